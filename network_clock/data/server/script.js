@@ -13,7 +13,15 @@ var networkPass = document.getElementById("ssid_password");
 var deviceName = document.getElementById("station_name");
 var loginName = document.getElementById("login_name");
 var devicePassword = document.getElementById("station_password");
+var fleetKey = document.getElementById("fleet_key");
 var timezone = document.getElementById("set_timezone");
+var joinStatus = document.getElementById("join_status");
+
+// Matches ConnectionState in ConnectionManager.h
+var STATE_CONNECTED = 4;
+var JOIN_POLL = 2000;
+var JOIN_TIMEOUT = 60000;
+var joinTimer = null;
 
 brightnessSlider.addEventListener("change", updateBrightness);
 
@@ -107,6 +115,27 @@ function fillpage(jsonResponse){
     deviceName.value = deviceState.dname;
     loginName.value = deviceState.lname;
     devicePassword.value = deviceState.dpass;
+    fleetKey.value = deviceState.fkey;
+    loadNetworks();
+}
+
+// Fills network name suggestions from the clock's last scan
+function loadNetworks(){
+    fetch("/scan").then(function(response) {
+        if(!response.ok){
+            return;
+        }
+        response.json().then(function(scan) {
+            var list = document.getElementById("networks");
+            list.innerHTML = "";
+            scan.networks.forEach(network => {
+                var option = document.createElement("option");
+                option.value = network.ssid;
+                option.label = network.rssi + " dBm" + (network.secure ? "" : ", open");
+                list.appendChild(option);
+            });
+        });
+    });
 }
 
 function parseTime(seconds){
@@ -146,8 +175,36 @@ function saveNetworkInfo(){
             ssid : networkName.value,
             psk : networkPass.value
         }),
-        true
+        false
     );
+    followJoin(Date.now());
+}
+
+// Polls the clock while it joins the network. The access point stays up
+// for a while after, long enough to show where the clock went.
+function followJoin(started){
+    window.clearTimeout(joinTimer);
+    joinStatus.innerHTML = "Connecting to " + networkName.value + "...";
+    var poll = function(){
+        fetch("/scan").then(function(response) {
+            return response.ok ? response.json() : null;
+        }).then(function(scan) {
+            if(scan != null && scan.state == STATE_CONNECTED && scan.ip != ""){
+                var url = "http://" + scan.ip + "/";
+                joinStatus.innerHTML = "Connected, the clock is now at <a href=\"" + url + "\">" + url + "</a>";
+                return;
+            }
+            retry();
+        }).catch(retry);
+    };
+    var retry = function(){
+        if(Date.now() - started > JOIN_TIMEOUT){
+            joinStatus.innerHTML = "Could not connect, check the network name and password.";
+            return;
+        }
+        joinTimer = window.setTimeout(poll, JOIN_POLL);
+    };
+    joinTimer = window.setTimeout(poll, JOIN_POLL);
 }
 
 function saveDeviceInfo(){
@@ -156,6 +213,7 @@ function saveDeviceInfo(){
         dname : deviceName.value,
         lname : loginName.value,
         dpass : devicePassword.value,
+        fkey : fleetKey.value,
         bright : brightnessSlider.value,
         timezone : timezone.value
         }),
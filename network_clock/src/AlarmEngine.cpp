@@ -0,0 +1,256 @@
+#include "AlarmEngine.h"
+
+/*
+ * Loads saved alarms and schedules them. offset is the local time offset in minutes.
+ */
+void AlarmEngine::begin(uint32_t now, int16_t offset){
+    _offset = offset;
+    load();
+    rebuild(now);
+}
+
+/*
+ * Stores an alarm in a free slot. Returns the slot, -1 if the alarm is
+ * invalid or there is no room.
+ */
+int16_t AlarmEngine::add(const Alarm &alarm, uint32_t now){
+    if(alarm.type == ALARM_NONE || alarm.type > ALARM_COUNTDOWN || alarm.hour > 23 || alarm.minute > 59){
+        return -1;
+    }
+    for(int i = 0; i < ALARM_MAX; i++){
+        if(_alarms[i].type == ALARM_NONE){
+            _alarms[i] = alarm;
+            _alarms[i].days &= ALARM_EVERY_DAY;
+            rebuild(now);
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool AlarmEngine::remove(uint16_t index, uint32_t now){
+    if(!isUsed(index)){
+        return false;
+    }
+    _alarms[index].type = ALARM_NONE;
+    rebuild(now);
+    return true;
+}
+
+void AlarmEngine::clear(){
+    for(int i = 0; i < ALARM_MAX; i++){
+        _alarms[i].type = ALARM_NONE;
+    }
+    _scheduled = 0;
+    _next = ALARM_NEVER;
+}
+
+/*
+ * Alarms follow local time, so all of them move with the offset.
+ */
+void AlarmEngine::setOffset(int16_t offset, uint32_t now){
+    if(offset == _offset){
+        return;
+    }
+    _offset = offset;
+    rebuild(now);
+}
+
+/*
+ * Works out every fire time again, for when the clock moved under the
+ * alarms, like on the first sync after boot.
+ */
+void AlarmEngine::reschedule(uint32_t now){
+    rebuild(now);
+}
+
+void AlarmEngine::setCallback(void (*callback)(uint16_t index, const Alarm &alarm)){
+    _callback = callback;
+}
+
+bool AlarmEngine::isUsed(uint16_t index){
+    return index < ALARM_MAX && _alarms[index].type != ALARM_NONE;
+}
+
+const Alarm& AlarmEngine::get(uint16_t index){
+    return _alarms[index];
+}
+
+/*
+ * UTC epoch the alarm fires next, ALARM_NEVER if it won't.
+ */
+uint32_t AlarmEngine::getNextFire(uint16_t index){
+    return isUsed(index) ? _fire[index] : ALARM_NEVER;
+}
+
+/*
+ * Alarms that are waiting to fire.
+ */
+uint16_t AlarmEngine::getCount(){
+    return _scheduled;
+}
+
+/*
+ * Reads alarms from flash, one "type,days,hour,minute,at" line each.
+ */
+bool AlarmEngine::load(){
+    clear();
+    SPIFFS.begin();
+    File file = SPIFFS.open(ALARM_FILE, "r");
+    if(!file){
+        SPIFFS.end();
+        return false;
+    }
+    char line[40];
+    int index = 0;
+    while(file.available() && index < ALARM_MAX){
+        size_t length = file.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[length] = '\0';
+        unsigned int type, days, hour, minute;
+        unsigned long at;
+        if(sscanf(line, "%u,%u,%u,%u,%lu", &type, &days, &hour, &minute, &at) != 5 ||
+           type == ALARM_NONE || type > ALARM_COUNTDOWN){
+            continue;
+        }
+        _alarms[index].type = type;
+        _alarms[index].days = days & ALARM_EVERY_DAY;
+        _alarms[index].hour = hour;
+        _alarms[index].minute = minute;
+        _alarms[index].at = at;
+        index++;
+    }
+    file.close();
+    SPIFFS.end();
+    return true;
+}
+
+bool AlarmEngine::save(){
+    SPIFFS.begin();
+    File file = SPIFFS.open(ALARM_FILE, "w");
+    if(!file){
+        SPIFFS.end();
+        return false;
+    }
+    for(int i = 0; i < ALARM_MAX; i++){
+        const Alarm &alarm = _alarms[i];
+        if(alarm.type != ALARM_NONE){
+            file.printf("%u,%u,%u,%u,%lu\n", alarm.type, alarm.days, alarm.hour, alarm.minute, (unsigned long)alarm.at);
+        }
+    }
+    file.close();
+    SPIFFS.end();
+    return true;
+}
+
+/*
+ * Fires everything due and moves recurring alarms to their next time.
+ * Alarms due long ago were missed while the clock was off or wrong,
+ * recurring ones are skipped. Countdowns still fire.
+ */
+void AlarmEngine::fire(uint32_t now){
+    bool consumed = false;
+    while(_scheduled > 0 && _fire[_order[0]] <= now){
+        uint16_t index = _order[0];
+        uint32_t due = _fire[index];
+        memmove(_order, _order + 1, --_scheduled * sizeof(_order[0]));
+
+        Alarm &alarm = _alarms[index];
+        bool late = now - due > ALARM_LATE;
+        if(alarm.type == ALARM_COUNTDOWN || (alarm.type == ALARM_ONCE && !late)){
+            if(_callback != nullptr){
+                _callback(index, alarm);
+            }
+            alarm.type = ALARM_NONE;
+            consumed = true;
+            continue;
+        }
+        if(!late && _callback != nullptr){
+            _callback(index, alarm);
+        }
+        _fire[index] = nextFire(alarm, now);
+        insert(index);
+    }
+    _next = _scheduled > 0 ? _fire[_order[0]] : ALARM_NEVER;
+
+    if(consumed){
+        save();
+    }
+}
+
+void AlarmEngine::rebuild(uint32_t now){
+    _scheduled = 0;
+    for(int i = 0; i < ALARM_MAX; i++){
+        if(_alarms[i].type == ALARM_NONE){
+            continue;
+        }
+        _fire[i] = nextFire(_alarms[i], now);
+        insert(i);
+    }
+    _next = _scheduled > 0 ? _fire[_order[0]] : ALARM_NEVER;
+}
+
+/*
+ * Puts a slot into the order by its fire time, after equal ones.
+ */
+void AlarmEngine::insert(uint16_t index){
+    uint32_t fire = _fire[index];
+    if(fire == ALARM_NEVER){
+        return;
+    }
+    uint16_t low = 0;
+    uint16_t high = _scheduled;
+    while(low < high){
+        uint16_t middle = (low + high) / 2;
+        if(_fire[_order[middle]] <= fire){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    memmove(_order + low + 1, _order + low, (_scheduled - low) * sizeof(_order[0]));
+    _order[low] = index;
+    _scheduled++;
+}
+
+/*
+ * First time after now the alarm should fire, in UTC.
+ */
+uint32_t AlarmEngine::nextFire(const Alarm &alarm, uint32_t now){
+    int32_t shift = _offset * SECONDS_PER_MINUTE;
+    uint32_t local = now + shift;
+
+    switch (alarm.type)
+    {
+    case ALARM_DAILY:
+    case ALARM_ONCE:
+    {
+        if((alarm.days & ALARM_EVERY_DAY) == 0){
+            return ALARM_NEVER;
+        }
+        uint32_t days = local / SECONDS_PER_DAY;
+        uint32_t time = alarm.hour * SECONDS_PER_HOUR + alarm.minute * SECONDS_PER_MINUTE;
+        if(days * SECONDS_PER_DAY + time <= local){
+            days++;
+        }
+        while(!(alarm.days & (1 << CivilTime::weekday(days)))){
+            days++;
+        }
+        return days * SECONDS_PER_DAY + time - shift;
+    }
+
+    case ALARM_HOURLY:
+    {
+        uint32_t fire = local - local % SECONDS_PER_HOUR + alarm.minute * SECONDS_PER_MINUTE;
+        if(fire <= local){
+            fire += SECONDS_PER_HOUR;
+        }
+        return fire - shift;
+    }
+
+    case ALARM_COUNTDOWN:
+        return alarm.at;
+
+    default:
+        return ALARM_NEVER;
+    }
+}
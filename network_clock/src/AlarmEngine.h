@@ -0,0 +1,81 @@
+#ifndef ALARMENGINE_H
+#define ALARMENGINE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <CivilTime.h>
+
+#define ALARM_MAX 256 //Slots, 14 bytes of RAM each
+#define ALARM_NEVER 0xFFFFFFFF
+#define ALARM_LATE 60 //s past due after which a recurring alarm is skipped, not fired
+#define ALARM_EVERY_DAY B01111111 //Weekday mask, bit 0 is Sunday
+#define ALARM_FILE "/alarms.txt"
+
+static_assert(ALARM_MAX < 0x7FFF, "Slots are returned as int16_t");
+
+enum AlarmType {
+  ALARM_NONE, //Free slot
+  ALARM_DAILY, //hour:minute on days in mask
+  ALARM_ONCE, //Next hour:minute on a day in mask, then removed
+  ALARM_HOURLY, //Every hour at minute
+  ALARM_COUNTDOWN //At epoch, then removed
+};
+
+typedef struct Alarm_t {
+  uint8_t type;
+  uint8_t days;
+  uint8_t hour;
+  uint8_t minute;
+  uint32_t at; //Countdowns only
+}Alarm;
+
+/*
+ * Alarms, countdowns and hourly chimes.
+ * Next fire time of every alarm is kept in UTC together with an index
+ * sorted by it, so tick() only compares against the earliest one.
+ * Anything that moves fire times (edits, time offset) rebuilds the index,
+ * firing only moves the alarms that fired.
+ */
+class AlarmEngine{
+public:
+    void begin(uint32_t now, int16_t offset);
+    int16_t add(const Alarm &alarm, uint32_t now);
+    bool remove(uint16_t index, uint32_t now);
+    void clear();
+    void setOffset(int16_t offset, uint32_t now);
+    void reschedule(uint32_t now);
+    void setCallback(void (*callback)(uint16_t index, const Alarm &alarm));
+
+    /*
+     * Called every loop, costs a single compare until something is due.
+     */
+    void tick(uint32_t now){
+        if(now >= _next){
+            fire(now);
+        }
+    }
+
+    bool isUsed(uint16_t index);
+    const Alarm& get(uint16_t index);
+    uint32_t getNextFire(uint16_t index);
+    uint16_t getCount();
+
+    bool load();
+    bool save();
+
+private:
+    void fire(uint32_t now);
+    void rebuild(uint32_t now);
+    void insert(uint16_t index);
+    uint32_t nextFire(const Alarm &alarm, uint32_t now);
+
+    void (*_callback)(uint16_t index, const Alarm &alarm) = nullptr;
+    Alarm _alarms[ALARM_MAX];
+    uint32_t _fire[ALARM_MAX];
+    uint16_t _order[ALARM_MAX]; //Scheduled slots, earliest first
+    uint16_t _scheduled = 0;
+    uint32_t _next = ALARM_NEVER;
+    int16_t _offset = 0;
+};
+
+#endif
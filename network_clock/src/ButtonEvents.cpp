@@ -0,0 +1,149 @@
+#include "ButtonEvents.h"
+
+/*
+ * Sets the pin up and starts catching its edges.
+ * Returns index of the button used in events.
+ */
+uint8_t ButtonEvents::attach(uint8_t pin, bool doubleClick){
+    if(_count >= BUTTON_MAX){
+        return BUTTON_MAX;
+    }
+    pinMode(pin, INPUT_PULLUP);
+    uint8_t level = digitalRead(pin);
+    uint32_t now = millis();
+
+    Button_State &button = _buttons[_count];
+    button.owner = this;
+    button.index = _count;
+    button.pin = pin;
+    button.doubleClick = doubleClick;
+    button.stable = level;
+    button.pending = level;
+    button.pendingTime = now;
+    button.pressTime = now;
+    button.releaseTime = now;
+    //A button held through boot isn't a press
+    button.longFired = level == LOW;
+    button.clicks = 0;
+
+    attachInterruptArg(digitalPinToInterrupt(pin), onEdge, &button, CHANGE);
+    return _count++;
+}
+
+/*
+ * Drains edges caught since last call and fires events that are due.
+ */
+void ButtonEvents::tick(){
+    while(_tail != _head){
+        uint8_t tail = _tail;
+        edge(_buttons[_ring[tail].button], _ring[tail].level, _ring[tail].time);
+        _tail = (tail + 1) & (BUTTON_RING - 1);
+    }
+
+    //Read after draining, so no edge handled above is newer than this
+    uint32_t now = millis();
+    for(int i = 0; i < _count; i++){
+        Button_State &button = _buttons[i];
+        settle(button, now);
+
+        if(button.stable == LOW && !button.longFired && now - button.pressTime >= LONG_PRESS_TIME){
+            button.longFired = true;
+            button.clicks = 0;
+            emit(button, BUTTON_LONG_PRESS);
+        }
+        if(button.clicks > 0 && button.stable == HIGH && now - button.releaseTime > DOUBLE_CLICK_TIME){
+            button.clicks = 0;
+            emit(button, BUTTON_CLICK);
+        }
+    }
+}
+
+void ButtonEvents::setCallback(void (*callback)(uint8_t button, ButtonEvent event)){
+    _callback = callback;
+}
+
+bool ButtonEvents::isPressed(uint8_t button){
+    return button < _count && _buttons[button].stable == LOW;
+}
+
+/*
+ * Edges dropped because the ring was full.
+ */
+uint32_t ButtonEvents::getOverflows(){
+    return _overflows;
+}
+
+void IRAM_ATTR ButtonEvents::onEdge(void *arg){
+    Button_State *button = (Button_State*)arg;
+    ButtonEvents *events = button->owner;
+    uint8_t head = events->_head;
+    uint8_t next = (head + 1) & (BUTTON_RING - 1);
+    if(next == events->_tail){
+        events->_overflows++;
+        return;
+    }
+    events->_ring[head].time = millis();
+    events->_ring[head].button = button->index;
+    events->_ring[head].level = digitalRead(button->pin);
+    //Published last, tick() never sees a half written edge
+    events->_head = next;
+}
+
+/*
+ * Takes in an edge. The previous one counts only if it held long enough.
+ */
+void ButtonEvents::edge(Button_State &button, uint8_t level, uint32_t time){
+    settle(button, time);
+    button.pending = level;
+    button.pendingTime = time;
+}
+
+void ButtonEvents::settle(Button_State &button, uint32_t time){
+    if(button.pending != button.stable && time - button.pendingTime >= DEBOUNCE_TIME){
+        commit(button, button.pending, button.pendingTime);
+    }
+}
+
+/*
+ * Debounced level change at given time.
+ */
+void ButtonEvents::commit(Button_State &button, uint8_t level, uint32_t time){
+    button.stable = level;
+    if(level == LOW){
+        //A click waiting too long for its second half is a click on its own
+        if(button.clicks > 0 && time - button.releaseTime > DOUBLE_CLICK_TIME){
+            button.clicks = 0;
+            emit(button, BUTTON_CLICK);
+        }
+        button.pressTime = time;
+        button.longFired = false;
+        return;
+    }
+
+    if(button.longFired){
+        return;
+    }
+    if(time - button.pressTime >= LONG_PRESS_TIME){
+        //Held while loop was blocked, tick() never saw it down that long
+        button.clicks = 0;
+        emit(button, BUTTON_LONG_PRESS);
+        return;
+    }
+    if(!button.doubleClick){
+        emit(button, BUTTON_CLICK);
+        return;
+    }
+    if(button.clicks > 0){
+        button.clicks = 0;
+        emit(button, BUTTON_DOUBLE_CLICK);
+        return;
+    }
+    button.clicks = 1;
+    button.releaseTime = time;
+}
+
+void ButtonEvents::emit(Button_State &button, ButtonEvent event){
+    if(_callback != nullptr){
+        _callback(button.index, event);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef BUTTONEVENTS_H
+#define BUTTONEVENTS_H
+
+#include <Arduino.h>
+
+#define BUTTON_MAX 4
+#define BUTTON_RING 32 //Edges held until loop drains them, power of two
+#define DEBOUNCE_TIME 5 //ms a level has to hold to count
+#define LONG_PRESS_TIME 1000 //ms held for a long press
+#define DOUBLE_CLICK_TIME 300 //ms between release and next press for a double click
+
+enum ButtonEvent {
+  BUTTON_CLICK,
+  BUTTON_DOUBLE_CLICK,
+  BUTTON_LONG_PRESS
+};
+
+typedef struct Button_Edge_t {
+  uint32_t time;
+  uint8_t button;
+  uint8_t level;
+}Button_Edge;
+
+class ButtonEvents;
+
+typedef struct Button_State_t {
+  ButtonEvents *owner;
+  uint8_t index;
+  uint8_t pin;
+  bool doubleClick; //Clicks wait for a possible second one
+  uint8_t stable; //Debounced level
+  uint8_t pending; //Level of the last edge
+  uint32_t pendingTime;
+  uint32_t pressTime;
+  uint32_t releaseTime;
+  bool longFired;
+  uint8_t clicks;
+}Button_State;
+
+/*
+ * Buttons on pulled up pins, pressed is LOW.
+ * Pin change interrupts only timestamp edges into a ring, tick() drains
+ * it from loop and does debouncing, long press and double click there.
+ * Edges keep their own time, so presses made while loop was blocked are
+ * still seen, with their real length.
+ */
+class ButtonEvents{
+public:
+    uint8_t attach(uint8_t pin, bool doubleClick = false);
+    void tick();
+    void setCallback(void (*callback)(uint8_t button, ButtonEvent event));
+    bool isPressed(uint8_t button);
+    uint32_t getOverflows();
+
+private:
+    static void onEdge(void *arg);
+    void edge(Button_State &button, uint8_t level, uint32_t time);
+    void settle(Button_State &button, uint32_t time);
+    void commit(Button_State &button, uint8_t level, uint32_t time);
+    void emit(Button_State &button, ButtonEvent event);
+
+    void (*_callback)(uint8_t button, ButtonEvent event) = nullptr;
+    Button_State _buttons[BUTTON_MAX];
+    uint8_t _count = 0;
+
+    //Written by the interrupt only, read by tick() only
+    volatile Button_Edge _ring[BUTTON_RING];
+    volatile uint8_t _head = 0;
+    volatile uint8_t _tail = 0;
+    volatile uint32_t _overflows = 0;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef CIVILTIME_H
+#define CIVILTIME_H
+
+#include <Arduino.h>
+
+#define SECONDS_PER_MINUTE 60
+#define SECONDS_PER_HOUR 3600
+#define SECONDS_PER_DAY 86400UL
+
+#define CIVIL_BASE_YEAR 1968 //Days are counted from 1968-03-01, right after a leap day
+#define CIVIL_EPOCH_DAYS 671 //1970-01-01 counted from the base
+#define CIVIL_SKIPPED_LEAP 48212 //2100-03-01 counted from the base, 2100 has no Feb 29
+
+typedef struct Civil_Time_t {
+  uint16_t year;
+  uint8_t month; //1 - 12
+  uint8_t day; //1 - 31
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t second;
+  uint8_t weekday; //0 is Sunday
+}Civil_Time;
+
+/*
+ * Calendar conversions for 32 bit unix time, 1970 to 2106.
+ * Within that range every fourth year is leap except 2100, so years are
+ * counted in 1461 day cycles and 2100 is patched with a single compare.
+ * Divisions by constants are done as multiply and shift with factors
+ * that are exact over the ranges used and never overflow 32 bits, the
+ * core has no divider. Only splitting epoch into days divides for real.
+ */
+struct CivilTime {
+  static constexpr Civil_Time fromEpoch(uint32_t epoch){
+    return withTime(civilFromDays(epoch / SECONDS_PER_DAY), epoch % SECONDS_PER_DAY);
+  }
+
+  /*
+   * Hour, minute and second only, date fields are left zero.
+   */
+  static constexpr Civil_Time timeOfDay(uint32_t epoch){
+    return withTime(Civil_Time{}, epoch % SECONDS_PER_DAY);
+  }
+
+  static constexpr uint32_t toEpoch(uint16_t year, uint8_t month, uint8_t day,
+      uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0){
+    return daysFromCivil(year, month, day) * SECONDS_PER_DAY +
+      hour * SECONDS_PER_HOUR + minute * SECONDS_PER_MINUTE + second;
+  }
+
+  static constexpr Civil_Time civilFromDays(uint32_t days){
+    Civil_Time time{};
+    uint32_t base = days + CIVIL_EPOCH_DAYS;
+    //Pretend 2100-02-29 exists, later dates move one day up
+    base += base >= CIVIL_SKIPPED_LEAP;
+
+    uint32_t cycle = (base * 22967) >> 25; // / 1461
+    uint32_t dayOfCycle = base - cycle * 1461;
+    uint32_t yearOfCycle = ((dayOfCycle - (dayOfCycle == 1460)) * 1437) >> 19; // / 365
+    uint32_t dayOfYear = dayOfCycle - yearOfCycle * 365;
+    //Year starts on March 1st so the leap day is the last one
+    uint32_t shiftedMonth = ((5 * dayOfYear + 2) * 857) >> 17; // / 153
+    uint32_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+
+    time.year = CIVIL_BASE_YEAR + cycle * 4 + yearOfCycle + (month <= 2);
+    time.month = month;
+    time.day = dayOfYear - (((153 * shiftedMonth + 2) * 1639) >> 13) + 1; // / 5
+    time.weekday = weekday(days);
+    return time;
+  }
+
+  static constexpr uint32_t daysFromCivil(uint16_t year, uint8_t month, uint8_t day){
+    uint32_t shiftedYear = year - CIVIL_BASE_YEAR - (month <= 2);
+    uint32_t shiftedMonth = month > 2 ? month - 3 : month + 9;
+    uint32_t base = ((shiftedYear * 1461) >> 2) + (((153 * shiftedMonth + 2) * 1639) >> 13) + day - 1;
+    base -= base > CIVIL_SKIPPED_LEAP;
+    return base - CIVIL_EPOCH_DAYS;
+  }
+
+  static constexpr uint8_t weekday(uint32_t days){
+    //1970-01-01 was a Thursday
+    return days + 4 - (((days + 4) * 74899) >> 19) * 7; // % 7
+  }
+
+  static constexpr Civil_Time withTime(Civil_Time time, uint32_t secondOfDay){
+    time.hour = (secondOfDay * 37283) >> 27; // / 3600
+    uint32_t secondOfHour = secondOfDay - time.hour * SECONDS_PER_HOUR;
+    time.minute = (secondOfHour * 2185) >> 17; // / 60
+    time.second = secondOfHour - time.minute * SECONDS_PER_MINUTE;
+    return time;
+  }
+};
+
+static_assert(CivilTime::fromEpoch(0).year == 1970 && CivilTime::fromEpoch(0).weekday == 4,
+  "Epoch must be Thursday, 1970-01-01");
+static_assert(CivilTime::fromEpoch(951782400).month == 2 && CivilTime::fromEpoch(951782400).day == 29,
+  "2000 is a leap year");
+static_assert(CivilTime::fromEpoch(4107542400UL).month == 3 && CivilTime::fromEpoch(4107542400UL).day == 1,
+  "2100 is not a leap year");
+static_assert(CivilTime::fromEpoch(0xFFFFFFFF).year == 2106 && CivilTime::fromEpoch(0xFFFFFFFF).hour == 6 &&
+  CivilTime::fromEpoch(0xFFFFFFFF).minute == 28 && CivilTime::fromEpoch(0xFFFFFFFF).second == 15,
+  "Last second of 32 bit time is 2106-02-07 06:28:15");
+static_assert(CivilTime::toEpoch(2038, 1, 19, 3, 14, 7) == 0x7FFFFFFF && CivilTime::toEpoch(2100, 3, 1) == 4107542400UL,
+  "Conversion back to epoch must match");
+
+#endif
@@ -0,0 +1,254 @@
+#include "ConnectionManager.h"
+
+volatile int ConnectionManager::_wpsStatus = WPS_PENDING;
+
+ConnectionManager::ConnectionManager(FastBoot &fastBoot) : _fastBoot(fastBoot){
+}
+
+/*
+ * Sets credentials to use. Buffers are kept, not copied,
+ * so later changes to them are picked up on the next attempt.
+ */
+void ConnectionManager::begin(const char *ssid, const char *psk, const char *apName){
+    _ssid = ssid;
+    _psk = psk;
+    _apName = apName;
+
+    //We do our own reconnects and credentials are saved by us
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+
+    if(!_gotIPHandler){
+        _gotIPHandler = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP &event){
+            _gotIP = true;
+        });
+        _disconnectedHandler = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected &event){
+            _disconnected = true;
+        });
+    }
+}
+
+/*
+ * Starts connecting to the stored network, or WPS if there is none.
+ */
+void ConnectionManager::connect(){
+    _failures = 0;
+    _backoff = BACKOFF_MIN;
+    _retry = true;
+    if(_ssid[0] == '\0'){
+        startWPS();
+        return;
+    }
+    connectStation();
+}
+
+void ConnectionManager::startWPS(){
+    _wpsAttempt = 0;
+    startWPSAttempt();
+}
+
+/*
+ * Opens the access point for configuration only. Station is kept up
+ * without connecting, networks are scanned through it.
+ */
+void ConnectionManager::startAccessPoint(){
+    _retry = false;
+    WiFi.disconnect();
+    openAccessPoint();
+    enterState(STATE_AP_FALLBACK);
+}
+
+/*
+ * Runs from loop(). Only compares a few values unless something happened.
+ */
+void ConnectionManager::tick(){
+    if(_state == STATE_CONNECTED){
+        if(_disconnected){
+            _disconnected = false;
+            //Keep the access point, it is the way back in if the network is wrong
+            _apClosing = false;
+            notify(EVENT_DISCONNECTED);
+            fail();
+        } else if(_apClosing && millis() - _apMillis >= AP_GRACE_PERIOD){
+            closeAccessPoint();
+        }
+        return;
+    }
+
+    if(_gotIP && _state == STATE_CONNECTING){
+        _gotIP = false;
+        _failures = 0;
+        _backoff = BACKOFF_MIN;
+        _fastBoot.markConnected();
+        _fastBoot.saveNetwork(_ssid);
+        if(_apActive){
+            //Clients on the access point are told where to find us before it closes
+            _apClosing = true;
+            _apMillis = millis();
+        }
+        enterState(STATE_CONNECTED);
+        notify(EVENT_CONNECTED);
+        return;
+    }
+
+    uint32_t elapsed = millis() - _stateMillis;
+    switch (_state)
+    {
+    case STATE_CONNECTING:
+        //Disconnect events also come from begin() itself, only timeouts count
+        _disconnected = false;
+        if(_fastAttempt && elapsed > FAST_CONNECT_TIMEOUT){
+            //AP moved or lease is gone, fall back to a regular connection
+            _fastBoot.clearNetwork();
+            connectStation();
+        } else if(elapsed > CONNECT_TIMEOUT){
+            fail();
+        }
+        break;
+
+    case STATE_BACKOFF:
+    case STATE_AP_FALLBACK:
+        if(_retry && _ssid[0] != '\0' && elapsed >= _backoff){
+            connectStation();
+        }
+        break;
+
+    case STATE_WPS:
+    {
+        int status = _wpsStatus;
+        if(status == WPS_PENDING){
+            break;
+        }
+        _wpsStatus = WPS_PENDING;
+        wifi_wps_disable();
+        if(status == WPS_CB_ST_SUCCESS){
+            //Credentials are in station config now, callback saves them
+            notify(EVENT_WPS_SUCCESS);
+            wifi_station_connect();
+            _fastAttempt = false;
+            enterState(STATE_CONNECTING);
+        } else if(_wpsAttempt < WPS_ATTEMPTS){
+            startWPSAttempt();
+        } else {
+            notify(EVENT_WPS_FAILED);
+            fail();
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void ConnectionManager::setCallback(void (*callback)(ConnectionEvent)){
+    _callback = callback;
+}
+
+ConnectionState ConnectionManager::getState(){
+    return _state;
+}
+
+uint8_t ConnectionManager::getWPSAttempt(){
+    return _wpsAttempt;
+}
+
+uint8_t ConnectionManager::getFailures(){
+    return _failures;
+}
+
+bool ConnectionManager::isAccessPointActive(){
+    return _apActive;
+}
+
+void ConnectionManager::connectStation(){
+    WiFi.mode(_apActive ? WIFI_AP_STA : WIFI_STA);
+    _gotIP = false;
+    _disconnected = false;
+
+    _fastAttempt = _fastBoot.hasNetwork(_ssid);
+    if(_fastAttempt){
+        //Skip scanning, and DHCP if allowed, by using what worked last time
+        if(FAST_BOOT_STATIC_IP && _fastBoot.hasAddress()){
+            WiFi.config(_fastBoot.getIP(), _fastBoot.getGateway(), _fastBoot.getSubnet(), _fastBoot.getDNS());
+        } else {
+            WiFi.config(0U, 0U, 0U);
+        }
+        WiFi.begin(_ssid, _psk, _fastBoot.getChannel(), _fastBoot.getBssid());
+    } else {
+        WiFi.config(0U, 0U, 0U);
+        WiFi.begin(_ssid, _psk);
+    }
+    enterState(STATE_CONNECTING);
+}
+
+/*
+ * Schedules next attempt. Delay doubles on every failure up to BACKOFF_MAX.
+ */
+void ConnectionManager::fail(){
+    if(_failures < 0xFF){
+        _failures++;
+    }
+    uint8_t shift = _failures - 1;
+    if(shift > 6){
+        shift = 6;
+    }
+    _backoff = BACKOFF_MIN << shift;
+    if(_backoff > BACKOFF_MAX){
+        _backoff = BACKOFF_MAX;
+    }
+
+    if(!_apActive && (_failures >= AP_FALLBACK_FAILURES || _ssid[0] == '\0')){
+        openAccessPoint();
+    }
+    enterState(_apActive ? STATE_AP_FALLBACK : STATE_BACKOFF);
+}
+
+void ConnectionManager::openAccessPoint(){
+    WiFi.mode(WIFI_AP_STA);
+    WiFi.softAP(_apName, NULL);
+    _apActive = true;
+    _apClosing = false;
+    notify(EVENT_AP_STARTED);
+}
+
+void ConnectionManager::closeAccessPoint(){
+    WiFi.softAPdisconnect(true);
+    WiFi.mode(WIFI_STA);
+    _apActive = false;
+    _apClosing = false;
+    notify(EVENT_AP_STOPPED);
+}
+
+void ConnectionManager::startWPSAttempt(){
+    _wpsAttempt++;
+    WiFi.mode(_apActive ? WIFI_AP_STA : WIFI_STA);
+    WiFi.disconnect();
+
+    _wpsStatus = WPS_PENDING;
+    wifi_wps_disable();
+    if(!wifi_wps_enable(WPS_TYPE_PBC) || !wifi_set_wps_cb((wps_st_cb_t)&wpsCallback) || !wifi_wps_start()){
+        _wpsStatus = WPS_CB_ST_FAILED;
+    }
+    enterState(STATE_WPS);
+    notify(EVENT_WPS_STARTED);
+}
+
+void ConnectionManager::enterState(ConnectionState state){
+    _state = state;
+    _stateMillis = millis();
+}
+
+void ConnectionManager::notify(ConnectionEvent event){
+    if(_callback != nullptr){
+        _callback(event);
+    }
+}
+
+/*
+ * Called by the SDK when WPS finishes.
+ */
+void ConnectionManager::wpsCallback(int status){
+    _wpsStatus = status;
+}
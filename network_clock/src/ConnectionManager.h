@@ -0,0 +1,96 @@
+#ifndef CONNECTIONMANAGER_H
+#define CONNECTIONMANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <user_interface.h>
+#include <FastBoot.h>
+
+#define CONNECT_TIMEOUT 15000 //ms for a regular connection attempt
+#define FAST_CONNECT_TIMEOUT 3000 //ms to try cached BSSID/channel before a full scan
+#define FAST_BOOT_STATIC_IP false //Reuse last DHCP lease on reconnect, unsafe if the router hands it to another host
+
+#define BACKOFF_MIN 1000
+#define BACKOFF_MAX 60000
+#define AP_FALLBACK_FAILURES 3 //Failed attempts before access point is opened
+#define AP_GRACE_PERIOD 60000 //ms the access point stays up after joining, the UI shows the new address through it
+#define WPS_ATTEMPTS 5
+#define WPS_PENDING -1
+
+enum ConnectionState {
+  STATE_IDLE,
+  STATE_CONNECTING,
+  STATE_WPS,
+  STATE_AP_FALLBACK,
+  STATE_CONNECTED,
+  STATE_BACKOFF
+};
+
+enum ConnectionEvent {
+  EVENT_CONNECTED,
+  EVENT_DISCONNECTED,
+  EVENT_WPS_STARTED,
+  EVENT_WPS_SUCCESS,
+  EVENT_WPS_FAILED,
+  EVENT_AP_STARTED,
+  EVENT_AP_STOPPED
+};
+
+/*
+ * Keeps the station connected without ever blocking the loop.
+ * Wi-Fi events and tick() move the state machine, failed attempts
+ * are retried with a bounded exponential backoff and after a few
+ * of them an access point is opened so the UI stays reachable.
+ */
+class ConnectionManager{
+public:
+    ConnectionManager(FastBoot &fastBoot);
+    void begin(const char *ssid, const char *psk, const char *apName);
+    void connect();
+    void startWPS();
+    void startAccessPoint();
+    void tick();
+
+    void setCallback(void (*callback)(ConnectionEvent));
+    ConnectionState getState();
+    uint8_t getWPSAttempt();
+    uint8_t getFailures();
+    bool isAccessPointActive();
+
+private:
+    void connectStation();
+    void fail();
+    void openAccessPoint();
+    void closeAccessPoint();
+    void startWPSAttempt();
+    void enterState(ConnectionState state);
+    void notify(ConnectionEvent event);
+    static void wpsCallback(int status);
+
+    FastBoot &_fastBoot;
+    void (*_callback)(ConnectionEvent) = nullptr;
+    const char *_ssid = nullptr;
+    const char *_psk = nullptr;
+    const char *_apName = nullptr;
+
+    ConnectionState _state = STATE_IDLE;
+    uint32_t _stateMillis = 0;
+    uint32_t _backoff = BACKOFF_MIN;
+    uint8_t _failures = 0;
+    uint8_t _wpsAttempt = 0;
+    bool _fastAttempt = false;
+    bool _apActive = false;
+    bool _apClosing = false; //Connected, access point closes after the grace period
+    uint32_t _apMillis = 0;
+    bool _retry = true; //Station retries while access point is open
+
+    //Set from SDK context, handled in tick()
+    volatile bool _gotIP = false;
+    volatile bool _disconnected = false;
+    static volatile int _wpsStatus;
+
+    WiFiEventHandler _gotIPHandler;
+    WiFiEventHandler _disconnectedHandler;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "DeviceConfig.h"
+
+#define TEXT_KEY(member, key, size) key,
+#define NUMBER_KEY(type, member, key, low, high) key,
+static const char *const fieldKeys[DEVICE_FIELD_COUNT] = {
+    DEVICE_FIELDS(TEXT_KEY, NUMBER_KEY)
+};
+#undef TEXT_KEY
+#undef NUMBER_KEY
+
+/*
+ * Reads comma separated fields into info, missing ones are left as they are.
+ * So are numbers that aren't numbers or are out of their range, a file
+ * edited by hand can't set what a patch couldn't. Returns fields read.
+ */
+uint8_t DeviceConfig::parseCsv(char *csv, Device_Info &info){
+    uint8_t index = 0;
+    char *field = csv;
+    while(*field != '\0' && index < DEVICE_FIELD_COUNT){
+        char *end = strchr(field, ',');
+        if(end != nullptr){
+            *end = '\0';
+        }
+        switch (index)
+        {
+#define TEXT_PARSE(member, key, size) \
+        case FIELD_##member: \
+            copyText(info.member, field, size); \
+            break;
+#define NUMBER_PARSE(type, member, key, low, high) \
+        case FIELD_##member: \
+        { \
+            char *last; \
+            long number = strtol(field, &last, 10); \
+            if(last != field && number >= (low) && number <= (high)){ \
+                info.member = number; \
+            } \
+            break; \
+        }
+        DEVICE_FIELDS(TEXT_PARSE, NUMBER_PARSE)
+#undef TEXT_PARSE
+#undef NUMBER_PARSE
+        }
+        index++;
+        if(end == nullptr){
+            break;
+        }
+        field = end + 1;
+    }
+    return index;
+}
+
+/*
+ * Writes every field followed by a comma, as parseCsv() reads them.
+ */
+void DeviceConfig::printCsv(Print &out, const Device_Info &info){
+#define TEXT_PRINT(member, key, size) \
+    out.print(info.member); \
+    out.print(',');
+#define NUMBER_PRINT(type, member, key, low, high) \
+    out.print(info.member); \
+    out.print(',');
+    DEVICE_FIELDS(TEXT_PRINT, NUMBER_PRINT)
+#undef TEXT_PRINT
+#undef NUMBER_PRINT
+}
+
+void DeviceConfig::toJson(const Device_Info &info, JsonObject &root){
+#define TEXT_JSON(member, key, size) root[key] = info.member;
+#define NUMBER_JSON(type, member, key, low, high) root[key] = info.member;
+    DEVICE_FIELDS(TEXT_JSON, NUMBER_JSON)
+#undef TEXT_JSON
+#undef NUMBER_JSON
+}
+
+/*
+ * Applies the fields present in root. Nothing is applied unless all of
+ * them are valid, error then gets the key of the first bad one.
+ * changed gets a FIELD_BIT mask of fields that now hold another value.
+ */
+bool DeviceConfig::patch(JsonObject &root, Device_Info &info, uint16_t &changed, const char *&error){
+    Device_Info next = info;
+#define TEXT_PATCH(member, key, size) \
+    if(root.containsKey(key)){ \
+        const char *text = root[key]; \
+        if(text == nullptr || strlen(text) >= size){ \
+            error = key; \
+            return false; \
+        } \
+        copyText(next.member, text, size); \
+    }
+#define NUMBER_PATCH(type, member, key, low, high) \
+    if(root.containsKey(key)){ \
+        long number; \
+        if(!readNumber(root.get<JsonVariant>(key), number) || number < (low) || number > (high)){ \
+            error = key; \
+            return false; \
+        } \
+        next.member = number; \
+    }
+    DEVICE_FIELDS(TEXT_PATCH, NUMBER_PATCH)
+#undef TEXT_PATCH
+#undef NUMBER_PATCH
+
+    changed = diff(info, next);
+    info = next;
+    return true;
+}
+
+uint16_t DeviceConfig::diff(const Device_Info &from, const Device_Info &to){
+    uint16_t changed = 0;
+#define TEXT_DIFF(member, key, size) \
+    if(strncmp(from.member, to.member, size) != 0){ \
+        changed |= FIELD_BIT(member); \
+    }
+#define NUMBER_DIFF(type, member, key, low, high) \
+    if(from.member != to.member){ \
+        changed |= FIELD_BIT(member); \
+    }
+    DEVICE_FIELDS(TEXT_DIFF, NUMBER_DIFF)
+#undef TEXT_DIFF
+#undef NUMBER_DIFF
+    return changed;
+}
+
+/*
+ * Sets a text field from at most length bytes of text, which needn't be
+ * terminated, like the fixed arrays the SDK fills. False, and the field
+ * left as it is, if it isn't a text field or the text doesn't fit.
+ */
+bool DeviceConfig::setText(Device_Info &info, uint8_t field, const char *text, size_t length){
+    length = strnlen(text, length);
+    switch (field)
+    {
+#define TEXT_SET(member, key, size) \
+    case FIELD_##member: \
+        if(length >= size){ \
+            return false; \
+        } \
+        memcpy(info.member, text, length); \
+        info.member[length] = '\0'; \
+        return true;
+#define NUMBER_SET(type, member, key, low, high)
+    DEVICE_FIELDS(TEXT_SET, NUMBER_SET)
+#undef TEXT_SET
+#undef NUMBER_SET
+    }
+    return false;
+}
+
+const char* DeviceConfig::getKey(uint8_t field){
+    return field < DEVICE_FIELD_COUNT ? fieldKeys[field] : "";
+}
+
+void DeviceConfig::copyText(char *target, const char *text, size_t size){
+    strncpy(target, text, size - 1);
+    target[size - 1] = '\0';
+}
+
+/*
+ * Numbers may come as JSON numbers or as strings of digits, form inputs send the latter.
+ */
+bool DeviceConfig::readNumber(const JsonVariant &value, long &number){
+    if(value.is<long>()){
+        number = value.as<long>();
+        return true;
+    }
+    const char *text = value.as<const char*>();
+    if(text == nullptr || *text == '\0'){
+        return false;
+    }
+    char *end;
+    number = strtol(text, &end, 10);
+    return *end == '\0';
+}
@@ -0,0 +1,73 @@
+#ifndef DEVICECONFIG_H
+#define DEVICECONFIG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define DEVICE_NAME_SIZE 12
+#define DEVICE_PASS_SIZE 12
+
+#define SSID_SIZE 32
+#define PASSWORD_SIZE 64
+#define FLEET_KEY_SIZE 33 //Site key fleet beacons are signed with
+
+#define OFFSET_MIN -720 //Minutes
+#define OFFSET_MAX 840
+
+/*
+ * Settings of the device, in the order they are saved.
+ * TEXT(member, JSON key, buffer size)
+ * NUMBER(type, member, JSON key, lowest, highest)
+ * Struct, file and JSON formats, validation and diffing all come from here.
+ */
+#define DEVICE_FIELDS(TEXT, NUMBER) \
+  TEXT(ssid, "ssid", SSID_SIZE) \
+  TEXT(psk, "psk", PASSWORD_SIZE) \
+  TEXT(name, "dname", DEVICE_NAME_SIZE) \
+  TEXT(loginName, "lname", DEVICE_NAME_SIZE) \
+  TEXT(password, "dpass", DEVICE_PASS_SIZE) \
+  NUMBER(uint8_t, brightness, "bright", 0, 15) \
+  NUMBER(int16_t, timeOffset, "timezone", OFFSET_MIN, OFFSET_MAX) \
+  TEXT(fleetKey, "fkey", FLEET_KEY_SIZE)
+
+#define DEVICE_TEXT_ENUM(member, key, size) FIELD_##member,
+#define DEVICE_NUMBER_ENUM(type, member, key, low, high) FIELD_##member,
+enum DeviceField {
+  DEVICE_FIELDS(DEVICE_TEXT_ENUM, DEVICE_NUMBER_ENUM)
+  DEVICE_FIELD_COUNT
+};
+#undef DEVICE_TEXT_ENUM
+#undef DEVICE_NUMBER_ENUM
+
+//Bit of a field in change masks
+#define FIELD_BIT(member) (1 << FIELD_##member)
+
+static_assert(DEVICE_FIELD_COUNT <= 16, "Change masks are 16 bits");
+
+#define DEVICE_TEXT_MEMBER(member, key, size) char member[size];
+#define DEVICE_NUMBER_MEMBER(type, member, key, low, high) type member;
+typedef struct Device_Info_t {
+  DEVICE_FIELDS(DEVICE_TEXT_MEMBER, DEVICE_NUMBER_MEMBER)
+}Device_Info;
+#undef DEVICE_TEXT_MEMBER
+#undef DEVICE_NUMBER_MEMBER
+
+/*
+ * Reads, writes, checks and compares Device_Info through DEVICE_FIELDS.
+ */
+class DeviceConfig{
+public:
+    static uint8_t parseCsv(char *csv, Device_Info &info);
+    static void printCsv(Print &out, const Device_Info &info);
+    static void toJson(const Device_Info &info, JsonObject &root);
+    static bool patch(JsonObject &root, Device_Info &info, uint16_t &changed, const char *&error);
+    static uint16_t diff(const Device_Info &from, const Device_Info &to);
+    static bool setText(Device_Info &info, uint8_t field, const char *text, size_t length);
+    static const char* getKey(uint8_t field);
+
+private:
+    static void copyText(char *target, const char *text, size_t size);
+    static bool readNumber(const JsonVariant &value, long &number);
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include "DisplayCompositor.h"
+
+DisplayCompositor::DisplayCompositor(){
+    memset(_text, 0, sizeof(_text));
+    memset(_from, 0, sizeof(_from));
+    memset(_to, 0, sizeof(_to));
+}
+
+/*
+ * Renders text into glyphs. A dot is merged into the previous
+ * digit's decimal point so "10.0.0.1" takes 5 cells instead of 8.
+ * Returns the number of cells written.
+ */
+uint8_t DisplayCompositor::renderText(const char *text, uint8_t *cells, uint8_t maxCells){
+    uint8_t length = 0;
+    while(*text != '\0' && length < maxCells){
+        char c = *text++;
+        if(c == '.' && length > 0 && !(cells[length - 1] & SEG_DP)){
+            cells[length - 1] |= SEG_DP;
+            continue;
+        }
+        cells[length++] = SegmentFont::glyph(c);
+    }
+    return length;
+}
+
+/*
+ * Shows text for given ticks. Text that doesn't fit the display scrolls instead.
+ */
+void DisplayCompositor::showText(const char *text, uint8_t hold){
+    memset(_text, 0, sizeof(_text));
+    _textLength = renderText(text, _text, TEXT_CELLS);
+    if(_textLength > DIGIT_COUNT){
+        scrollText(text, hold == HOLD_FOREVER ? 0 : 1);
+        return;
+    }
+    _hold = hold;
+    start(EFFECT_STATIC, 1);
+}
+
+/*
+ * Scrolls text from right to left. Zero loops scrolls until cleared.
+ */
+void DisplayCompositor::scrollText(const char *text, uint8_t loops){
+    //Text is padded with a blank display on both ends so it enters and leaves the screen
+    memset(_text, 0, sizeof(_text));
+    _textLength = renderText(text, _text + DIGIT_COUNT, TEXT_CELLS);
+    _loops = loops;
+    start(EFFECT_SCROLL, _textLength + DIGIT_COUNT + 1);
+}
+
+/*
+ * Rolls changed digits out downwards while the new ones come in from the top.
+ */
+void DisplayCompositor::rollDigits(const uint8_t *from, const uint8_t *to){
+    memcpy(_from, from, DIGIT_COUNT);
+    memcpy(_to, to, DIGIT_COUNT);
+    start(EFFECT_ROLL, 4);
+}
+
+/*
+ * Dims out the old content, then brightens the new one up to given intensity.
+ */
+void DisplayCompositor::fade(const uint8_t *from, const uint8_t *to, uint8_t intensity){
+    memcpy(_from, from, DIGIT_COUNT);
+    memcpy(_to, to, DIGIT_COUNT);
+    _intensity = intensity;
+    start(EFFECT_FADE, 2 * FADE_STEPS + 1);
+}
+
+void DisplayCompositor::clear(){
+    _effect = EFFECT_NONE;
+    _count = 0;
+    _head = 0;
+    _holdLeft = 0;
+}
+
+bool DisplayCompositor::isActive(){
+    return _count > 0 || _effect != EFFECT_NONE || _holdLeft > 1;
+}
+
+/*
+ * Called on every display tick. Returns true when a new frame
+ * has to be sent to the display.
+ */
+bool DisplayCompositor::tick(uint8_t *cells, uint8_t &intensity){
+    if(_holdLeft > 1){
+        _holdLeft--;
+        return false;
+    }
+    if(_count == 0){
+        _holdLeft = 0;
+        return false;
+    }
+
+    Frame &frame = _ring[_head];
+    memcpy(cells, frame.cells, DIGIT_COUNT);
+    intensity = frame.intensity;
+    _holdLeft = frame.hold;
+    _head = (_head + 1) % FRAME_RING_SIZE;
+    _count--;
+
+    //Prepare the next frames now, so the next tick only copies
+    fill();
+    return true;
+}
+
+void DisplayCompositor::start(Effect effect, uint8_t steps){
+    clear();
+    _effect = effect;
+    _step = 0;
+    _steps = steps;
+    fill();
+}
+
+void DisplayCompositor::fill(){
+    while(_count < FRAME_RING_SIZE){
+        Frame &frame = _ring[(_head + _count) % FRAME_RING_SIZE];
+        if(!generate(frame)){
+            return;
+        }
+        _count++;
+    }
+}
+
+/*
+ * Generates the next frame of the running effect.
+ * Returns false when the effect is finished.
+ */
+bool DisplayCompositor::generate(Frame &frame){
+    if(_effect == EFFECT_NONE){
+        return false;
+    }
+    if(_step >= _steps){
+        if(_effect == EFFECT_SCROLL && _loops != 1){
+            if(_loops > 0){
+                _loops--;
+            }
+            _step = 0;
+        } else {
+            _effect = EFFECT_NONE;
+            return false;
+        }
+    }
+
+    frame.intensity = INTENSITY_KEEP;
+    switch (_effect)
+    {
+    case EFFECT_STATIC:
+        memcpy(frame.cells, _text, DIGIT_COUNT);
+        if(_hold == HOLD_FOREVER){
+            //Step never advances, frame is repeated until cleared
+            frame.hold = 0xFF;
+        } else {
+            frame.hold = _hold;
+            _step++;
+        }
+        break;
+
+    case EFFECT_SCROLL:
+        memcpy(frame.cells, _text + _step, DIGIT_COUNT);
+        frame.hold = SCROLL_HOLD;
+        _step++;
+        break;
+
+    case EFFECT_ROLL:
+        for(int i = 0; i < DIGIT_COUNT; i++){
+            if(_from[i] == _to[i] || _step == 3){
+                frame.cells[i] = _to[i];
+            } else if(_step == 0){
+                frame.cells[i] = rollDown(_from[i]);
+            } else if(_step == 1){
+                frame.cells[i] = rollDown(rollDown(_from[i])) | rollUp(rollUp(_to[i]));
+            } else {
+                frame.cells[i] = rollUp(_to[i]);
+            }
+        }
+        frame.hold = ROLL_HOLD;
+        _step++;
+        break;
+
+    case EFFECT_FADE:
+        if(_step < FADE_STEPS){
+            memcpy(frame.cells, _from, DIGIT_COUNT);
+            frame.intensity = _intensity * (FADE_STEPS - 1 - _step) / FADE_STEPS;
+        } else if(_step == FADE_STEPS){
+            memset(frame.cells, 0, DIGIT_COUNT);
+            frame.intensity = 0;
+        } else {
+            memcpy(frame.cells, _to, DIGIT_COUNT);
+            frame.intensity = _intensity * (_step - FADE_STEPS) / FADE_STEPS;
+        }
+        frame.hold = FADE_HOLD;
+        _step++;
+        break;
+
+    default:
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Moves a glyph one row down. Bottom row falls off the digit.
+ */
+uint8_t DisplayCompositor::rollDown(uint8_t glyph){
+    uint8_t out = glyph & SEG_DP;
+    if(glyph & SEG_A) out |= SEG_G;
+    if(glyph & SEG_G) out |= SEG_D;
+    if(glyph & SEG_F) out |= SEG_E;
+    if(glyph & SEG_B) out |= SEG_C;
+    return out;
+}
+
+/*
+ * Moves a glyph one row up. Top row falls off the digit.
+ */
+uint8_t DisplayCompositor::rollUp(uint8_t glyph){
+    uint8_t out = glyph & SEG_DP;
+    if(glyph & SEG_D) out |= SEG_G;
+    if(glyph & SEG_G) out |= SEG_A;
+    if(glyph & SEG_E) out |= SEG_F;
+    if(glyph & SEG_C) out |= SEG_B;
+    return out;
+}
@@ -0,0 +1,72 @@
+#ifndef DISPLAYCOMPOSITOR_H
+#define DISPLAYCOMPOSITOR_H
+
+#include <Arduino.h>
+#include <SegmentFont.h>
+
+#define DIGIT_COUNT 4
+#define FRAME_RING_SIZE 16
+#define TEXT_CELLS 32
+
+#define INTENSITY_KEEP 0xFF
+#define HOLD_FOREVER 0
+
+#define SCROLL_HOLD 3
+#define ROLL_HOLD 1
+#define FADE_HOLD 1
+#define FADE_STEPS 4
+
+typedef struct Frame_t {
+  uint8_t cells[DIGIT_COUNT];
+  uint8_t intensity;
+  uint8_t hold; //Ticks to keep this frame on display
+}Frame;
+
+/*
+ * Builds display frames for text and transitions.
+ * Frames are generated ahead into a small ring, so every tick
+ * only pops a ready frame and no effect ever blocks the loop.
+ */
+class DisplayCompositor{
+public:
+    DisplayCompositor();
+    static uint8_t renderText(const char *text, uint8_t *cells, uint8_t maxCells);
+
+    void showText(const char *text, uint8_t hold = HOLD_FOREVER);
+    void scrollText(const char *text, uint8_t loops = 1);
+    void rollDigits(const uint8_t *from, const uint8_t *to);
+    void fade(const uint8_t *from, const uint8_t *to, uint8_t intensity);
+    void clear();
+
+    bool isActive();
+    bool tick(uint8_t *cells, uint8_t &intensity);
+
+private:
+    enum Effect { EFFECT_NONE, EFFECT_STATIC, EFFECT_SCROLL, EFFECT_ROLL, EFFECT_FADE };
+
+    void start(Effect effect, uint8_t steps);
+    void fill();
+    bool generate(Frame &frame);
+
+    static uint8_t rollDown(uint8_t glyph);
+    static uint8_t rollUp(uint8_t glyph);
+
+    Frame _ring[FRAME_RING_SIZE];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+    uint8_t _holdLeft = 0;
+
+    Effect _effect = EFFECT_NONE;
+    uint8_t _step = 0;
+    uint8_t _steps = 0;
+    uint8_t _loops = 0;
+    uint8_t _hold = 0;
+    uint8_t _intensity = 0;
+
+    uint8_t _text[TEXT_CELLS + 2 * DIGIT_COUNT];
+    uint8_t _textLength = 0;
+    uint8_t _from[DIGIT_COUNT];
+    uint8_t _to[DIGIT_COUNT];
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "FastBoot.h"
+
+FastBoot::FastBoot(){
+    memset(&_cache, 0, sizeof(_cache));
+}
+
+/*
+ * Reads the cache from RTC memory. Returns false on cold boot,
+ * when the memory holds garbage.
+ */
+bool FastBoot::load(){
+    ESP.rtcUserMemoryRead(BOOT_CACHE_OFFSET, (uint32_t*)&_cache, sizeof(_cache));
+    if(_cache.magic != BOOT_CACHE_MAGIC ||
+       _cache.crc != crc32((uint8_t*)&_cache, offsetof(Boot_Cache, crc))){
+        memset(&_cache, 0, sizeof(_cache));
+        _cache.magic = BOOT_CACHE_MAGIC;
+        return false;
+    }
+
+    if(_cache.flags & CACHE_TIME){
+        //RTC timer keeps counting over a warm reset but restarts on power up.
+        //If it went backwards we can't know how long we were down.
+        uint32_t rtcNow = system_get_rtc_time();
+        if(rtcNow < _cache.rtcTime){
+            _cache.flags &= ~CACHE_TIME;
+        } else {
+            //Calibration is microseconds per tick in Q12
+            uint64_t us = (uint64_t)(rtcNow - _cache.rtcTime) * system_rtc_clock_cali_proc() >> 12;
+            _restoredEpoch = _cache.epoch + us / 1000000ULL;
+        }
+    }
+    return true;
+}
+
+bool FastBoot::hasTime(){
+    return _cache.flags & CACHE_TIME;
+}
+
+uint32_t FastBoot::getTime(){
+    return _restoredEpoch;
+}
+
+int32_t FastBoot::getDrift(){
+    return _cache.drift;
+}
+
+int16_t FastBoot::getTimeOffset(){
+    return _cache.timeOffset;
+}
+
+uint8_t FastBoot::getBrightness(){
+    return _cache.brightness;
+}
+
+/*
+ * Display settings are saved along, they are needed before credentials are loaded.
+ */
+void FastBoot::saveTime(uint32_t epoch, int32_t drift, int16_t timeOffset, uint8_t brightness){
+    _cache.epoch = epoch;
+    _cache.rtcTime = system_get_rtc_time();
+    _cache.drift = drift;
+    _cache.timeOffset = timeOffset;
+    _cache.brightness = brightness;
+    _cache.flags |= CACHE_TIME;
+    write();
+}
+
+/*
+ * Cached BSSID and channel are only good for the network they were saved with.
+ */
+bool FastBoot::hasNetwork(const char *ssid){
+    return (_cache.flags & CACHE_NETWORK) && _cache.ssidHash == crc32((const uint8_t*)ssid, strlen(ssid));
+}
+
+const uint8_t* FastBoot::getBssid(){
+    return _cache.bssid;
+}
+
+uint8_t FastBoot::getChannel(){
+    return _cache.channel;
+}
+
+bool FastBoot::hasAddress(){
+    return _cache.flags & CACHE_ADDRESS;
+}
+
+IPAddress FastBoot::getIP(){
+    return IPAddress(_cache.ip);
+}
+
+IPAddress FastBoot::getGateway(){
+    return IPAddress(_cache.gateway);
+}
+
+IPAddress FastBoot::getSubnet(){
+    return IPAddress(_cache.subnet);
+}
+
+IPAddress FastBoot::getDNS(){
+    return IPAddress(_cache.dns);
+}
+
+/*
+ * Saves parameters of the current connection.
+ */
+void FastBoot::saveNetwork(const char *ssid){
+    _cache.ssidHash = crc32((const uint8_t*)ssid, strlen(ssid));
+    memcpy(_cache.bssid, WiFi.BSSID(), sizeof(_cache.bssid));
+    _cache.channel = WiFi.channel();
+    _cache.ip = WiFi.localIP();
+    _cache.gateway = WiFi.gatewayIP();
+    _cache.subnet = WiFi.subnetMask();
+    _cache.dns = WiFi.dnsIP();
+    _cache.flags |= CACHE_NETWORK | CACHE_ADDRESS;
+    write();
+}
+
+void FastBoot::clearNetwork(){
+    _cache.flags &= ~(CACHE_NETWORK | CACHE_ADDRESS);
+    write();
+}
+
+/*
+ * Boot metrics, only the first call counts.
+ */
+void FastBoot::markDisplay(){
+    if(_displayMillis == 0){
+        _displayMillis = millis();
+    }
+}
+
+void FastBoot::markConnected(){
+    if(_connectedMillis == 0){
+        _connectedMillis = millis();
+    }
+}
+
+uint32_t FastBoot::getDisplayMillis(){
+    return _displayMillis;
+}
+
+uint32_t FastBoot::getConnectedMillis(){
+    return _connectedMillis;
+}
+
+void FastBoot::write(){
+    _cache.crc = crc32((uint8_t*)&_cache, offsetof(Boot_Cache, crc));
+    ESP.rtcUserMemoryWrite(BOOT_CACHE_OFFSET, (uint32_t*)&_cache, sizeof(_cache));
+}
+
+uint32_t FastBoot::crc32(const uint8_t *data, size_t length){
+    uint32_t crc = 0xFFFFFFFF;
+    while(length--){
+        crc ^= *data++;
+        for(int i = 0; i < 8; i++){
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,93 @@
+#ifndef FASTBOOT_H
+#define FASTBOOT_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <user_interface.h>
+
+#define BOOT_CACHE_MAGIC 0x434C4B31 //"CLK1"
+/*
+ * RTC user blocks 0-31 belong to the core, the eboot command that makes
+ * the bootloader copy an OTA image sits at the start of them. Writing
+ * there between Update.end() and the restart leaves the old firmware
+ * booting. The host shim doesn't model this, keep our caches past it.
+ */
+#define RTC_USER_RESERVED 32 //4 byte blocks, from the start of RTC user memory
+#define RTC_USER_BLOCKS 128 //512 bytes
+#define BOOT_CACHE_OFFSET RTC_USER_RESERVED //in 4 byte blocks of RTC user memory
+
+#define CACHE_TIME B00000001
+#define CACHE_NETWORK B00000010
+#define CACHE_ADDRESS B00000100
+
+/*
+ * Survives warm resets in RTC user memory.
+ * Size has to stay a multiple of 4.
+ */
+typedef struct Boot_Cache_t {
+  uint32_t magic;
+  uint32_t epoch;
+  uint32_t rtcTime; //RTC timer ticks when epoch was saved
+  int32_t drift;
+  int16_t timeOffset;
+  uint8_t flags;
+  uint8_t channel;
+  uint8_t bssid[6];
+  uint8_t brightness;
+  uint8_t reserved;
+  uint32_t ssidHash;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint32_t crc;
+}Boot_Cache;
+
+static_assert(sizeof(Boot_Cache) % 4 == 0, "RTC memory is accessed in 4 byte blocks");
+static_assert(BOOT_CACHE_OFFSET >= RTC_USER_RESERVED, "Boot cache would overwrite the eboot command");
+static_assert(BOOT_CACHE_OFFSET * 4 + sizeof(Boot_Cache) <= RTC_USER_BLOCKS * 4, "RTC user memory is 512 bytes");
+
+/*
+ * Keeps last good time and network parameters over a warm reset,
+ * so the display and Wi-Fi don't have to start from nothing.
+ * Also measures how long boot took.
+ */
+class FastBoot{
+public:
+    FastBoot();
+    bool load();
+
+    bool hasTime();
+    uint32_t getTime();
+    int32_t getDrift();
+    int16_t getTimeOffset();
+    uint8_t getBrightness();
+    void saveTime(uint32_t epoch, int32_t drift, int16_t timeOffset, uint8_t brightness);
+
+    bool hasNetwork(const char *ssid);
+    const uint8_t* getBssid();
+    uint8_t getChannel();
+    bool hasAddress();
+    IPAddress getIP();
+    IPAddress getGateway();
+    IPAddress getSubnet();
+    IPAddress getDNS();
+    void saveNetwork(const char *ssid);
+    void clearNetwork();
+
+    void markDisplay();
+    void markConnected();
+    uint32_t getDisplayMillis();
+    uint32_t getConnectedMillis();
+
+private:
+    void write();
+    static uint32_t crc32(const uint8_t *data, size_t length);
+
+    Boot_Cache _cache;
+    uint32_t _restoredEpoch = 0;
+    uint32_t _displayMillis = 0;
+    uint32_t _connectedMillis = 0;
+};
+
+#endif
@@ -0,0 +1,333 @@
+#include "FleetSync.h"
+
+FleetSync::FleetSync(SoftClock &clock) : _clock(clock){
+    _id = ESP.getChipId();
+    _boot = ESP.random();
+    IPAddress group(FLEET_GROUP);
+    ip_addr_set_ip4_u32(&_group, (uint32_t)group);
+    ip_addr_set_ip4_u32(&_local, 0);
+    _key = deriveKey("");
+}
+
+/*
+ * Joins the beacon group on given interface. Starts as follower,
+ * so an existing leader gets a full timeout to be heard.
+ */
+bool FleetSync::begin(uint32_t localAddress){
+    if(_pcb != nullptr){
+        return true;
+    }
+    ip_addr_set_ip4_u32(&_local, localAddress);
+    _pcb = udp_new();
+    if(_pcb == nullptr){
+        return false;
+    }
+    if(udp_bind(_pcb, IP_ADDR_ANY, FLEET_PORT) != ERR_OK ||
+       igmp_joingroup(ip_2_ip4(&_local), ip_2_ip4(&_group)) != ERR_OK){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+        return false;
+    }
+    //Beacons never leave the site
+    udp_set_multicast_ttl(_pcb, 1);
+    udp_recv(_pcb, onPacket, this);
+
+    _leader = 0;
+    _leaderMillis = millis();
+    setRole(ROLE_FOLLOWER);
+    return true;
+}
+
+void FleetSync::stop(){
+    if(_pcb == nullptr){
+        return;
+    }
+    igmp_leavegroup(ip_2_ip4(&_local), ip_2_ip4(&_group));
+    udp_remove(_pcb);
+    _pcb = nullptr;
+    _pending = false;
+    setRole(ROLE_FOLLOWER);
+}
+
+/*
+ * Runs from loop(). Applies received beacon and moves the election along.
+ */
+void FleetSync::tick(){
+    if(_pcb == nullptr){
+        return;
+    }
+    if(_pending){
+        receive(_beacon);
+        _pending = false;
+    }
+
+    uint32_t now = millis();
+    switch (_role)
+    {
+    case ROLE_FOLLOWER:
+        if(now - _leaderMillis > FLEET_TIMEOUT){
+            _leader = 0;
+            setRole(ROLE_CANDIDATE);
+        }
+        break;
+
+    case ROLE_CANDIDATE:
+        //Holdoff depends on id, if two still claim together the lower id wins
+        if(now - _roleMillis > (_id % FLEET_HOLDOFF_SLOTS) * FLEET_INTERVAL / 2){
+            claim();
+        }
+        break;
+
+    case ROLE_LEADER:
+        if(now - _sentMillis >= FLEET_INTERVAL){
+            send();
+        }
+        break;
+    }
+}
+
+/*
+ * Site key beacons are signed and checked with, every clock of the site
+ * needs the same one.
+ */
+void FleetSync::setKey(const char *key){
+    _key = deriveKey(key);
+}
+
+/*
+ * Our stratum and root after an upstream sync, passed on in beacons.
+ */
+void FleetSync::setReference(uint8_t stratum, uint32_t rootDelay, uint32_t rootDispersion){
+    _stratum = stratum;
+    _rootDelay = rootDelay;
+    _rootDispersion = rootDispersion;
+}
+
+void FleetSync::setCallback(void (*callback)(FleetRole)){
+    _callback = callback;
+}
+
+/*
+ * Called when a follower took time from a synced beacon. error is how
+ * far off in us the clock was left, beacons within FLEET_MAX_OFFSET
+ * don't step it.
+ */
+void FleetSync::setSyncCallback(void (*callback)(const Fleet_Beacon &beacon, uint32_t error)){
+    _syncCallback = callback;
+}
+
+bool FleetSync::isLeader(){
+    return _role == ROLE_LEADER;
+}
+
+FleetRole FleetSync::getRole(){
+    return _role;
+}
+
+uint32_t FleetSync::getLeader(){
+    return _leader;
+}
+
+/*
+ * Beacons of current leader that never arrived.
+ */
+uint32_t FleetSync::getLost(){
+    return _lost;
+}
+
+void FleetSync::onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port){
+    FleetSync *fleet = (FleetSync*)arg;
+    uint64_t received = fleet->_clock.nowNtp();
+    const uint8_t *packet = (const uint8_t*)p->payload;
+
+    //A beacon not handled yet is newer than anything in flight, keep it
+    if(!fleet->_pending && p->len >= FLEET_BEACON_SIZE &&
+       word(packet[0], packet[1]) == FLEET_MAGIC && packet[2] == FLEET_VERSION &&
+       ((uint64_t)readWord(packet + 36) << 32 | readWord(packet + 40)) == sipHash(fleet->_key, packet, FLEET_SIGNED_SIZE)){
+        Fleet_Beacon &beacon = fleet->_beacon;
+        beacon.flags = packet[3];
+        beacon.stratum = packet[4];
+        beacon.sequence = readWord(packet + 8);
+        beacon.id = readWord(packet + 12);
+        beacon.time = (uint64_t)readWord(packet + 16) << 32 | readWord(packet + 20);
+        beacon.boot = readWord(packet + 24);
+        beacon.rootDelay = readWord(packet + 28);
+        beacon.rootDispersion = readWord(packet + 32);
+        beacon.address = ip_addr_get_ip4_u32(addr);
+        fleet->_received = received;
+        fleet->_pending = true;
+    }
+    pbuf_free(p);
+}
+
+void FleetSync::receive(const Fleet_Beacon &beacon){
+    if(beacon.id == _id || !(beacon.flags & BEACON_LEADER)){
+        return;
+    }
+
+    if(beacon.id > _id){
+        //Lowest id leads, they will step down when they hear us
+        if(_role != ROLE_LEADER){
+            claim();
+        }
+        return;
+    }
+    if(_role == ROLE_LEADER){
+        setRole(ROLE_FOLLOWER);
+    }
+
+    uint32_t now = millis();
+    if(beacon.id != _leader || beacon.boot != _leaderBoot){
+        //Lower id takes over, anyone takes over a silent leader
+        if(beacon.id != _leader && _leader != 0 && beacon.id > _leader && now - _leaderMillis <= FLEET_TIMEOUT){
+            return;
+        }
+        //New leader or the same one rebooted, its sequence starts over
+        _leader = beacon.id;
+        _leaderBoot = beacon.boot;
+        _leaderSequence = beacon.sequence - 1;
+    }
+    if(_role == ROLE_CANDIDATE){
+        setRole(ROLE_FOLLOWER);
+    }
+
+    //Old or repeated beacons carry stale time
+    int32_t gap = beacon.sequence - _leaderSequence;
+    if(gap <= 0){
+        return;
+    }
+    _lost += gap - 1;
+    _leaderSequence = beacon.sequence;
+    _leaderMillis = now;
+
+    if(!(beacon.flags & BEACON_SYNCED)){
+        return;
+    }
+    //Offset in 32.32 fixed point, converted to microseconds.
+    //Propagation on the LAN is well below FLEET_MAX_OFFSET and ignored.
+    int64_t offsetMicros = SoftClock::toMicros((int64_t)(beacon.time - _received));
+    uint32_t error = 0;
+    if(offsetMicros > FLEET_MAX_OFFSET || offsetMicros < -FLEET_MAX_OFFSET || !_clock.isSynced()){
+        uint64_t target = _clock.nowMicros() + offsetMicros;
+        _clock.adjust(target / 1000000ULL, target % 1000000ULL);
+    } else {
+        error = offsetMicros < 0 ? -offsetMicros : offsetMicros;
+    }
+    _stratum = beacon.stratum < 15 ? beacon.stratum + 1 : 16;
+    _rootDelay = beacon.rootDelay;
+    _rootDispersion = beacon.rootDispersion;
+    if(_syncCallback != nullptr){
+        _syncCallback(beacon, error);
+    }
+}
+
+/*
+ * Takes the lead and announces it right away.
+ */
+void FleetSync::claim(){
+    _leader = _id;
+    setRole(ROLE_LEADER);
+    send();
+}
+
+void FleetSync::send(){
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, FLEET_BEACON_SIZE, PBUF_RAM);
+    _sentMillis = millis();
+    if(p == nullptr){
+        return;
+    }
+    uint8_t *packet = (uint8_t*)p->payload;
+    memset(packet, 0, FLEET_BEACON_SIZE);
+    packet[0] = FLEET_MAGIC >> 8;
+    packet[1] = FLEET_MAGIC & 0xFF;
+    packet[2] = FLEET_VERSION;
+    packet[3] = BEACON_LEADER | (_clock.isSynced() ? BEACON_SYNCED : 0);
+    packet[4] = _stratum;
+    writeWord(packet + 8, ++_sequence);
+    writeWord(packet + 12, _id);
+
+    uint64_t stamp = _clock.nowNtp();
+    writeWord(packet + 16, stamp >> 32);
+    writeWord(packet + 20, stamp);
+    writeWord(packet + 24, _boot);
+    writeWord(packet + 28, _rootDelay);
+    writeWord(packet + 32, _rootDispersion);
+    uint64_t tag = sipHash(_key, packet, FLEET_SIGNED_SIZE);
+    writeWord(packet + 36, tag >> 32);
+    writeWord(packet + 40, tag);
+    udp_sendto(_pcb, p, &_group, FLEET_PORT);
+    pbuf_free(p);
+}
+
+/*
+ * Turns the text key from the config into the 128 bit SipHash key by
+ * hashing it under two fixed keys. An empty text gives a key everyone knows.
+ */
+Fleet_Key FleetSync::deriveKey(const char *key){
+    const Fleet_Key first = {0x4E43464C45455431ULL, 0x6B65792066697273ULL};
+    const Fleet_Key second = {0x4E43464C45455432ULL, 0x6B6579207365636FULL};
+    size_t length = strlen(key);
+    return Fleet_Key{sipHash(first, (const uint8_t*)key, length), sipHash(second, (const uint8_t*)key, length)};
+}
+
+#define SIP_ROTATE(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIP_ROUND(v0, v1, v2, v3) \
+    v0 += v1; v1 = SIP_ROTATE(v1, 13); v1 ^= v0; v0 = SIP_ROTATE(v0, 32); \
+    v2 += v3; v3 = SIP_ROTATE(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = SIP_ROTATE(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = SIP_ROTATE(v1, 17); v1 ^= v2; v2 = SIP_ROTATE(v2, 32);
+
+/*
+ * SipHash-2-4, a MAC made for short messages. Words are read little
+ * endian byte by byte as the reference does, tags match on any host.
+ */
+uint64_t FleetSync::sipHash(const Fleet_Key &key, const uint8_t *data, size_t length){
+    uint64_t v0 = key.k0 ^ 0x736F6D6570736575ULL;
+    uint64_t v1 = key.k1 ^ 0x646F72616E646F6DULL;
+    uint64_t v2 = key.k0 ^ 0x6C7967656E657261ULL;
+    uint64_t v3 = key.k1 ^ 0x7465646279746573ULL;
+    uint64_t last = (uint64_t)length << 56;
+    for(size_t i = 0; i <= length; i += 8){
+        uint64_t m = 0;
+        size_t end = length - i < 8 ? length - i : 8;
+        for(size_t j = 0; j < end; j++){
+            m |= (uint64_t)data[i + j] << (8 * j);
+        }
+        if(end < 8){
+            //Final word, the rest of the bytes and the length
+            m |= last;
+        }
+        v3 ^= m;
+        SIP_ROUND(v0, v1, v2, v3);
+        SIP_ROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    v2 ^= 0xFF;
+    for(uint8_t i = 0; i < 4; i++){
+        SIP_ROUND(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef SIP_ROUND
+#undef SIP_ROTATE
+
+void FleetSync::setRole(FleetRole role){
+    bool changed = role != _role;
+    _role = role;
+    _roleMillis = millis();
+    if(changed && _callback != nullptr){
+        _callback(role);
+    }
+}
+
+void FleetSync::writeWord(uint8_t *buffer, uint32_t value){
+    buffer[0] = value >> 24;
+    buffer[1] = value >> 16;
+    buffer[2] = value >> 8;
+    buffer[3] = value;
+}
+
+uint32_t FleetSync::readWord(const uint8_t *buffer){
+    return (uint32_t)buffer[0] << 24 | (uint32_t)buffer[1] << 16 | (uint32_t)buffer[2] << 8 | buffer[3];
+}
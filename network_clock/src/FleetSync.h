@@ -0,0 +1,124 @@
+#ifndef FLEETSYNC_H
+#define FLEETSYNC_H
+
+#include <Arduino.h>
+#include <SoftClock.h>
+
+extern "C" {
+#include <lwip/udp.h>
+#include <lwip/pbuf.h>
+#include <lwip/igmp.h>
+}
+
+#define FLEET_PORT 12300
+#define FLEET_GROUP 239, 255, 12, 3 //Site local multicast
+#define FLEET_MAGIC 0x4E43 //"NC"
+#define FLEET_VERSION 3
+#define FLEET_SIGNED_SIZE 36 //Bytes the tag covers
+#define FLEET_BEACON_SIZE 44 //Signed part and its SipHash-2-4 tag
+
+#define FLEET_INTERVAL 1000 //ms between leader beacons
+#define FLEET_TIMEOUT 3500 //ms without beacons before leader is considered gone
+#define FLEET_HOLDOFF_SLOTS 8 //Spreads candidates so they don't all claim at once
+#define FLEET_MAX_OFFSET 5000 //us of error tolerated before followers step their clock
+
+#define BEACON_LEADER B00000001
+#define BEACON_SYNCED B00000010
+
+enum FleetRole {
+  ROLE_FOLLOWER,
+  ROLE_CANDIDATE,
+  ROLE_LEADER
+};
+
+typedef struct Fleet_Beacon_t {
+  uint8_t flags;
+  uint8_t stratum;
+  uint32_t sequence;
+  uint32_t id;
+  uint64_t time; //NTP timestamp taken right before sending
+  uint32_t boot; //Random per boot, sequence restarts when it changes
+  uint32_t rootDelay; //Leader's, NTP short format
+  uint32_t rootDispersion;
+  uint32_t address; //Sender, not on the wire
+}Fleet_Beacon;
+
+typedef struct Fleet_Key_t {
+  uint64_t k0;
+  uint64_t k1;
+}Fleet_Key;
+
+/*
+ * Lets a site of clocks share one upstream NTP source.
+ * The clock with the lowest chip id that is alive leads: it syncs
+ * upstream and multicasts sequence numbered time beacons, the rest
+ * follow them. A clock hearing a leader with a higher id than its own
+ * claims the lead, the leader steps down when it hears a lower id.
+ * When beacons stop, followers elect a new leader.
+ *
+ * Whoever sends a valid beacon with a low id can lead and step every
+ * clock, so beacons carry a SipHash-2-4 tag keyed from the site key in
+ * the device config and others are dropped. Clocks sharing the key are
+ * trusted, with an empty key any host on the LAN is. Tags don't stop a
+ * recorded beacon being sent again, the sequence does only until the
+ * leader reboots.
+ */
+class FleetSync{
+public:
+    FleetSync(SoftClock &clock);
+    bool begin(uint32_t localAddress);
+    void stop();
+    void tick();
+
+    void setKey(const char *key);
+    void setReference(uint8_t stratum, uint32_t rootDelay, uint32_t rootDispersion);
+    void setCallback(void (*callback)(FleetRole));
+    void setSyncCallback(void (*callback)(const Fleet_Beacon &beacon, uint32_t error));
+    bool isLeader();
+    FleetRole getRole();
+    uint32_t getLeader();
+    uint32_t getLost();
+
+    static Fleet_Key deriveKey(const char *key);
+    static uint64_t sipHash(const Fleet_Key &key, const uint8_t *data, size_t length);
+
+private:
+    static void onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port);
+    void receive(const Fleet_Beacon &beacon);
+    void send();
+    void claim();
+    void setRole(FleetRole role);
+
+    static void writeWord(uint8_t *buffer, uint32_t value);
+    static uint32_t readWord(const uint8_t *buffer);
+
+    SoftClock &_clock;
+    void (*_callback)(FleetRole) = nullptr;
+    void (*_syncCallback)(const Fleet_Beacon&, uint32_t) = nullptr;
+    struct udp_pcb *_pcb = nullptr;
+    ip_addr_t _group;
+    ip_addr_t _local;
+    Fleet_Key _key;
+
+    FleetRole _role = ROLE_FOLLOWER;
+    uint32_t _id;
+    uint32_t _boot;
+    uint8_t _stratum = 16;
+    uint32_t _rootDelay = 0;
+    uint32_t _rootDispersion = 0;
+    uint32_t _sequence = 0;
+    uint32_t _leader = 0;
+    uint32_t _leaderBoot = 0;
+    uint32_t _leaderSequence = 0;
+    uint32_t _leaderMillis = 0;
+    uint32_t _roleMillis = 0;
+    uint32_t _sentMillis = 0;
+    uint32_t _lost = 0;
+
+    //Filled in lwIP callback, handled in tick()
+    volatile bool _pending = false;
+    Fleet_Beacon _beacon;
+    uint64_t _received = 0;
+};
+
+#endif
@@ -0,0 +1,460 @@
+#include "Inflater.h"
+
+#define GZIP_FHCRC B00000010
+#define GZIP_FEXTRA B00000100
+#define GZIP_FNAME B00001000
+#define GZIP_FCOMMENT B00010000
+#define GZIP_RESERVED B11100000
+
+static const uint16_t lengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t lengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+//Order code length code lengths are sent in
+static const uint8_t codeLengthOrder[19] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+//CRC32 a nibble at a time, small enough to keep in RAM
+static const uint32_t crcTable[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+/*
+ * Allocates window and tables, about 36K. Returns false if heap is short.
+ */
+bool Inflater::begin(bool (*sink)(const uint8_t *data, size_t length)){
+    end();
+    _window = (uint8_t*)malloc(INFLATE_WINDOW);
+    _in = (uint8_t*)malloc(INFLATE_INPUT);
+    _literals = (Huffman_Tree*)malloc(sizeof(Huffman_Tree));
+    _distances = (Huffman_Tree*)malloc(sizeof(Huffman_Tree));
+    if(_window == nullptr || _in == nullptr || _literals == nullptr || _distances == nullptr){
+        end();
+        return false;
+    }
+
+    _sink = sink;
+    _stage = STAGE_HEADER;
+    _last = false;
+    _error = false;
+    _inPos = 0;
+    _inLen = 0;
+    _bitBuffer = 0;
+    _bitCount = 0;
+    _pos = 0;
+    _unflushed = 0;
+    _total = 0;
+    _crc = 0xFFFFFFFF;
+    return true;
+}
+
+void Inflater::end(){
+    free(_window);
+    free(_in);
+    free(_literals);
+    free(_distances);
+    _window = nullptr;
+    _in = nullptr;
+    _literals = nullptr;
+    _distances = nullptr;
+}
+
+/*
+ * Feeds compressed data. final marks the last piece of input,
+ * the stream has to be complete by then.
+ */
+InflateResult Inflater::write(const uint8_t *data, size_t length, bool final){
+    if(_window == nullptr){
+        return INFLATE_ERROR;
+    }
+    InflateResult result = INFLATE_OK;
+    do {
+        //Move held back input to the front and take as much new input as fits
+        memmove(_in, _in + _inPos, _inLen - _inPos);
+        _inLen -= _inPos;
+        _inPos = 0;
+        size_t take = length < INFLATE_INPUT - _inLen ? length : INFLATE_INPUT - _inLen;
+        memcpy(_in + _inLen, data, take);
+        _inLen += take;
+        data += take;
+        length -= take;
+
+        result = run(final && length == 0);
+    } while(result == INFLATE_OK && length > 0);
+
+    if(!flush()){
+        return INFLATE_ERROR;
+    }
+    if(final && result == INFLATE_OK){
+        //Input ended before the stream did
+        return INFLATE_ERROR;
+    }
+    if(result == INFLATE_DONE && (_inPos < _inLen || length > 0)){
+        //Nothing may follow the trailer
+        return INFLATE_ERROR;
+    }
+    return result;
+}
+
+/*
+ * Uncompressed bytes so far.
+ */
+uint32_t Inflater::getTotal(){
+    return _total;
+}
+
+InflateResult Inflater::run(bool last){
+    while(_stage != STAGE_DONE){
+        if(!last && _inLen - _inPos < INFLATE_MARGIN){
+            return INFLATE_OK;
+        }
+        if(!step() || _error){
+            return INFLATE_ERROR;
+        }
+    }
+    return INFLATE_DONE;
+}
+
+bool Inflater::step(){
+    switch (_stage)
+    {
+    case STAGE_HEADER:
+        return readHeader();
+
+    case STAGE_EXTRA:
+        if(_skip > 0 && _inPos >= _inLen){
+            return false;
+        }
+        while(_skip > 0 && _inPos < _inLen){
+            getBits(8);
+            _skip--;
+        }
+        if(_skip == 0){
+            _flags &= ~GZIP_FEXTRA;
+            _stage = STAGE_HEADER_CRC;
+        }
+        return true;
+
+    case STAGE_NAME:
+    case STAGE_COMMENT:
+        //Zero terminated, one byte per step
+        if(getBits(8) == 0){
+            _flags &= _stage == STAGE_NAME ? ~GZIP_FNAME : ~GZIP_FCOMMENT;
+            _stage = STAGE_HEADER_CRC;
+        }
+        return true;
+
+    case STAGE_HEADER_CRC:
+        //Optional header parts in the order they come
+        if(_flags & GZIP_FEXTRA){
+            _skip = getBits(16);
+            _stage = STAGE_EXTRA;
+        } else if(_flags & GZIP_FNAME){
+            _stage = STAGE_NAME;
+        } else if(_flags & GZIP_FCOMMENT){
+            _stage = STAGE_COMMENT;
+        } else {
+            if(_flags & GZIP_FHCRC){
+                getBits(16);
+            }
+            _stage = STAGE_BLOCK;
+        }
+        return true;
+
+    case STAGE_BLOCK:
+        return readBlockHeader();
+
+    case STAGE_STORED:
+        if(_storedLeft > 0 && _inPos >= _inLen){
+            //Only happens on the last piece of input
+            return false;
+        }
+        while(_storedLeft > 0 && _inLen - _inPos > 0){
+            put(getBits(8));
+            _storedLeft--;
+        }
+        if(_storedLeft == 0){
+            _stage = _last ? STAGE_TRAILER : STAGE_BLOCK;
+        }
+        return true;
+
+    case STAGE_HUFFMAN:
+        return inflateSymbol();
+
+    case STAGE_TRAILER:
+        return readTrailer();
+
+    default:
+        return true;
+    }
+}
+
+bool Inflater::readHeader(){
+    uint8_t id1 = getBits(8);
+    uint8_t id2 = getBits(8);
+    uint8_t method = getBits(8);
+    _flags = getBits(8);
+    //Modification time, extra flags and OS are of no use to us
+    for(int i = 0; i < 6; i++){
+        getBits(8);
+    }
+    if(id1 != 0x1F || id2 != 0x8B || method != 8 || (_flags & GZIP_RESERVED)){
+        return false;
+    }
+    _stage = STAGE_HEADER_CRC;
+    return true;
+}
+
+bool Inflater::readBlockHeader(){
+    _last = getBits(1);
+    uint8_t type = getBits(2);
+    switch (type)
+    {
+    case 0:
+    {
+        alignToByte();
+        uint16_t length = getBits(16);
+        uint16_t inverse = getBits(16);
+        if(length != (uint16_t)~inverse){
+            return false;
+        }
+        _storedLeft = length;
+        _stage = STAGE_STORED;
+        return true;
+    }
+
+    case 1:
+    {
+        uint8_t lengths[288 + 32];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        buildTree(*_literals, lengths, 288);
+        memset(lengths, 5, 30);
+        buildTree(*_distances, lengths, 30);
+        _stage = STAGE_HUFFMAN;
+        return true;
+    }
+
+    case 2:
+        if(!readDynamicTrees()){
+            return false;
+        }
+        _stage = STAGE_HUFFMAN;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool Inflater::readDynamicTrees(){
+    uint16_t literalCount = getBits(5) + 257;
+    uint8_t distanceCount = getBits(5) + 1;
+    uint8_t codeCount = getBits(4) + 4;
+    if(literalCount > 286 || distanceCount > 30){
+        return false;
+    }
+
+    uint8_t lengths[288 + 32];
+    memset(lengths, 0, 19);
+    for(int i = 0; i < codeCount; i++){
+        lengths[codeLengthOrder[i]] = getBits(3);
+    }
+    //Literal tree holds the code length tree for a moment
+    buildTree(*_literals, lengths, 19);
+
+    uint16_t total = literalCount + distanceCount;
+    uint16_t index = 0;
+    while(index < total){
+        int symbol = decodeSymbol(*_literals);
+        if(symbol < 0){
+            return false;
+        }
+        if(symbol < 16){
+            lengths[index++] = symbol;
+            continue;
+        }
+
+        uint8_t value = 0;
+        uint8_t repeat;
+        if(symbol == 16){
+            if(index == 0){
+                return false;
+            }
+            value = lengths[index - 1];
+            repeat = getBits(2) + 3;
+        } else if(symbol == 17){
+            repeat = getBits(3) + 3;
+        } else {
+            repeat = getBits(7) + 11;
+        }
+        if(index + repeat > total){
+            return false;
+        }
+        memset(lengths + index, value, repeat);
+        index += repeat;
+    }
+    if(lengths[256] == 0){
+        //No end of block code
+        return false;
+    }
+
+    buildTree(*_literals, lengths, literalCount);
+    buildTree(*_distances, lengths + literalCount, distanceCount);
+    return true;
+}
+
+bool Inflater::inflateSymbol(){
+    int symbol = decodeSymbol(*_literals);
+    if(symbol < 0){
+        return false;
+    }
+    if(symbol < 256){
+        put(symbol);
+        return true;
+    }
+    if(symbol == 256){
+        _stage = _last ? STAGE_TRAILER : STAGE_BLOCK;
+        return true;
+    }
+
+    symbol -= 257;
+    if(symbol >= 29){
+        return false;
+    }
+    uint16_t length = lengthBase[symbol] + getBits(lengthExtra[symbol]);
+
+    int distanceSymbol = decodeSymbol(*_distances);
+    if(distanceSymbol < 0 || distanceSymbol >= 30){
+        return false;
+    }
+    uint16_t distance = distanceBase[distanceSymbol] + getBits(distanceExtra[distanceSymbol]);
+    if(distance > _total){
+        return false;
+    }
+
+    uint16_t from = _pos - distance;
+    while(length--){
+        put(_window[from++ & (INFLATE_WINDOW - 1)]);
+    }
+    return true;
+}
+
+bool Inflater::readTrailer(){
+    alignToByte();
+    uint32_t crc = getBits(16);
+    crc |= getBits(16) << 16;
+    uint32_t size = getBits(16);
+    size |= getBits(16) << 16;
+    _stage = STAGE_DONE;
+    return crc == ~_crc && size == _total;
+}
+
+/*
+ * Deflate packs bits starting from the least significant one.
+ * Running past the input marks an error, with INFLATE_MARGIN
+ * that only happens on truncated streams.
+ */
+uint32_t Inflater::getBits(uint8_t count){
+    while(_bitCount < count){
+        uint32_t next = 0;
+        if(_inPos < _inLen){
+            next = _in[_inPos++];
+        } else {
+            _error = true;
+        }
+        _bitBuffer |= next << _bitCount;
+        _bitCount += 8;
+    }
+    uint32_t value = _bitBuffer & ((1UL << count) - 1);
+    _bitBuffer >>= count;
+    _bitCount -= count;
+    return value;
+}
+
+void Inflater::alignToByte(){
+    getBits(_bitCount & 7);
+}
+
+/*
+ * Walks the canonical code one bit at a time. Slower than a lookup
+ * table but needs no extra memory.
+ */
+int Inflater::decodeSymbol(const Huffman_Tree &tree){
+    int sum = 0;
+    int code = 0;
+    for(int length = 1; length < 16; length++){
+        code = code * 2 + getBits(1);
+        sum += tree.counts[length];
+        code -= tree.counts[length];
+        if(code < 0){
+            return tree.symbols[sum + code];
+        }
+    }
+    return -1;
+}
+
+void Inflater::buildTree(Huffman_Tree &tree, const uint8_t *lengths, uint16_t count){
+    uint16_t offsets[16];
+    memset(tree.counts, 0, sizeof(tree.counts));
+    for(int i = 0; i < count; i++){
+        tree.counts[lengths[i]]++;
+    }
+    tree.counts[0] = 0;
+
+    uint16_t sum = 0;
+    for(int i = 0; i < 16; i++){
+        offsets[i] = sum;
+        sum += tree.counts[i];
+    }
+    for(int i = 0; i < count; i++){
+        if(lengths[i] != 0){
+            tree.symbols[offsets[lengths[i]]++] = i;
+        }
+    }
+}
+
+void Inflater::put(uint8_t value){
+    _window[_pos] = value;
+    _pos = (_pos + 1) & (INFLATE_WINDOW - 1);
+    _total++;
+    _crc = (_crc >> 4) ^ crcTable[(_crc ^ value) & 0x0F];
+    _crc = (_crc >> 4) ^ crcTable[(_crc ^ (value >> 4)) & 0x0F];
+    if(++_unflushed >= INFLATE_FLUSH){
+        if(!flush()){
+            _error = true;
+        }
+    }
+}
+
+/*
+ * Passes output not seen by the sink yet. It may wrap around the window end.
+ */
+bool Inflater::flush(){
+    if(_unflushed == 0){
+        return true;
+    }
+    uint16_t start = (_pos - _unflushed) & (INFLATE_WINDOW - 1);
+    uint16_t first = _unflushed < INFLATE_WINDOW - start ? _unflushed : INFLATE_WINDOW - start;
+    bool ok = _sink(_window + start, first);
+    if(ok && first < _unflushed){
+        ok = _sink(_window, _unflushed - first);
+    }
+    _unflushed = 0;
+    return ok;
+}
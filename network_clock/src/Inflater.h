@@ -0,0 +1,90 @@
+#ifndef INFLATER_H
+#define INFLATER_H
+
+#include <Arduino.h>
+
+#define INFLATE_WINDOW 32768 //Largest distance deflate may refer back to
+#define INFLATE_MARGIN 512 //Input held back so no decode step runs out mid-way
+#define INFLATE_INPUT (2048 + INFLATE_MARGIN) //One upload chunk plus the held back part
+#define INFLATE_FLUSH 4096 //Output is passed on in flash sector sized pieces
+
+enum InflateResult {
+  INFLATE_OK,
+  INFLATE_DONE,
+  INFLATE_ERROR
+};
+
+typedef struct Huffman_Tree_t {
+  uint16_t counts[16]; //Codes of each length
+  uint16_t symbols[288]; //Symbols ordered by code
+}Huffman_Tree;
+
+/*
+ * Streaming gzip decoder. Input is pushed as it arrives, decoded output
+ * goes through a fixed 32K window to the sink, so memory use doesn't
+ * depend on the image size.
+ * Decoding only advances while a full step is guaranteed to be in the
+ * input, so no step ever has to be resumed half way.
+ */
+class Inflater{
+public:
+    bool begin(bool (*sink)(const uint8_t *data, size_t length));
+    void end();
+    InflateResult write(const uint8_t *data, size_t length, bool final);
+    uint32_t getTotal();
+
+private:
+    enum Stage {
+      STAGE_HEADER,
+      STAGE_EXTRA,
+      STAGE_NAME,
+      STAGE_COMMENT,
+      STAGE_HEADER_CRC,
+      STAGE_BLOCK,
+      STAGE_STORED,
+      STAGE_HUFFMAN,
+      STAGE_TRAILER,
+      STAGE_DONE
+    };
+
+    InflateResult run(bool last);
+    bool step();
+    bool readHeader();
+    bool readBlockHeader();
+    bool readDynamicTrees();
+    bool inflateSymbol();
+    bool readTrailer();
+
+    uint32_t getBits(uint8_t count);
+    void alignToByte();
+    int decodeSymbol(const Huffman_Tree &tree);
+    static void buildTree(Huffman_Tree &tree, const uint8_t *lengths, uint16_t count);
+
+    void put(uint8_t value);
+    bool flush();
+
+    bool (*_sink)(const uint8_t *data, size_t length) = nullptr;
+    uint8_t *_window = nullptr;
+    uint8_t *_in = nullptr;
+    Huffman_Tree *_literals = nullptr;
+    Huffman_Tree *_distances = nullptr;
+
+    Stage _stage = STAGE_HEADER;
+    uint8_t _flags = 0;
+    bool _last = false;
+    bool _error = false;
+    uint16_t _skip = 0;
+    uint16_t _storedLeft = 0;
+
+    size_t _inPos = 0;
+    size_t _inLen = 0;
+    uint32_t _bitBuffer = 0;
+    uint8_t _bitCount = 0;
+
+    uint16_t _pos = 0;
+    uint16_t _unflushed = 0;
+    uint32_t _total = 0;
+    uint32_t _crc = 0;
+};
+
+#endif
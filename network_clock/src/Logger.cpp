@@ -0,0 +1,251 @@
+#include "Logger.h"
+
+/*
+ * Sends formatted records to the UART, only as much as its FIFO takes
+ * without waiting. Called from loop().
+ */
+void Logger::tick(){
+    while(true){
+        if(_linePos == _lineLen){
+            if(_uart == _head){
+                return;
+            }
+            _lineLen = format(_uart, _line, sizeof(_line));
+            _linePos = 0;
+            _uart += recordSize(_uart);
+        }
+        int room = Serial.availableForWrite();
+        if(room <= 0){
+            return;
+        }
+        size_t count = _lineLen - _linePos < (size_t)room ? _lineLen - _linePos : room;
+        Serial.write((const uint8_t*)_line + _linePos, count);
+        _linePos += count;
+    }
+}
+
+/*
+ * Sends everything left and waits for it, for use right before a restart.
+ */
+void Logger::flush(){
+    while(_uart != _head || _linePos < _lineLen){
+        tick();
+    }
+    Serial.flush();
+}
+
+/*
+ * Position of the oldest record still in the ring, for readLine().
+ */
+uint32_t Logger::oldest(){
+    return _tail;
+}
+
+/*
+ * Formats the record at position and moves position to the next one.
+ * Returns 0 when there are no more records.
+ */
+size_t Logger::readLine(uint32_t &position, char *line, size_t size){
+    if((int32_t)(position - _tail) < 0){
+        //Overwritten while the reader was away
+        position = _tail;
+    }
+    if(position == _head){
+        return 0;
+    }
+    size_t length = format(position, line, size);
+    position += recordSize(position);
+    return length;
+}
+
+/*
+ * Records that were overwritten before they reached the UART.
+ */
+uint32_t Logger::getDropped(){
+    return _dropped;
+}
+
+void Logger::packValue(uint8_t *payload, uint8_t &length, const char *text){
+    size_t textLength = strnlen(text, LOG_STRING);
+    if(length + 2 + textLength > LOG_PAYLOAD){
+        return;
+    }
+    payload[length++] = LOG_ARG_STRING;
+    payload[length++] = textLength;
+    memcpy(payload + length, text, textLength);
+    length += textLength;
+}
+
+void Logger::packValue(uint8_t *payload, uint8_t &length, const String &text){
+    packValue(payload, length, text.c_str());
+}
+
+void Logger::packValue(uint8_t *payload, uint8_t &length, const IPAddress &address){
+    packNumber(payload, length, LOG_ARG_IP, (uint32_t)address);
+}
+
+void Logger::packValue(uint8_t *payload, uint8_t &length, const Redacted &secret){
+    if(length + 1 > LOG_PAYLOAD){
+        return;
+    }
+    payload[length++] = LOG_ARG_REDACTED;
+}
+
+void Logger::packNumber(uint8_t *payload, uint8_t &length, uint8_t type, uint32_t value){
+    if(length + 5 > LOG_PAYLOAD){
+        return;
+    }
+    payload[length++] = type;
+    memcpy(payload + length, &value, 4);
+    length += 4;
+}
+
+void Logger::push(uint8_t level, PGM_P format, const uint8_t *payload, uint8_t length){
+    uint16_t size = LOG_HEADER_SIZE + length;
+    //Make room by dropping the oldest records
+    while(_head + size - _tail > LOG_RING){
+        if(_uart == _tail){
+            _uart += recordSize(_tail);
+            _dropped++;
+        }
+        _tail += recordSize(_tail);
+    }
+
+    uint8_t header[LOG_HEADER_SIZE];
+    uint32_t time = millis();
+    memcpy(header, &time, 4);
+    memcpy(header + 4, &format, sizeof(PGM_P));
+    header[4 + sizeof(PGM_P)] = level;
+    header[5 + sizeof(PGM_P)] = length;
+    for(size_t i = 0; i < LOG_HEADER_SIZE; i++){
+        _ring[(_head + i) & (LOG_RING - 1)] = header[i];
+    }
+    for(size_t i = 0; i < length; i++){
+        _ring[(_head + LOG_HEADER_SIZE + i) & (LOG_RING - 1)] = payload[i];
+    }
+    _head += size;
+}
+
+uint8_t Logger::peek(uint32_t position){
+    return _ring[position & (LOG_RING - 1)];
+}
+
+uint32_t Logger::peekWord(uint32_t position){
+    uint32_t value;
+    uint8_t *bytes = (uint8_t*)&value;
+    for(int i = 0; i < 4; i++){
+        bytes[i] = peek(position + i);
+    }
+    return value;
+}
+
+uint16_t Logger::recordSize(uint32_t position){
+    return LOG_HEADER_SIZE + peek(position + 5 + sizeof(PGM_P));
+}
+
+/*
+ * Turns a record into a line like "12.345 I text\n". Supports the printf
+ * conversions used in this project: d i u x X c s with flags and width.
+ */
+size_t Logger::format(uint32_t position, char *line, size_t size){
+    PGM_P format;
+    uint8_t *formatBytes = (uint8_t*)&format;
+    for(size_t i = 0; i < sizeof(PGM_P); i++){
+        formatBytes[i] = peek(position + 4 + i);
+    }
+    uint32_t time = peekWord(position);
+    uint8_t level = peek(position + 4 + sizeof(PGM_P));
+    uint32_t arg = position + LOG_HEADER_SIZE;
+    uint32_t argEnd = arg + peek(position + 5 + sizeof(PGM_P));
+
+    //One byte is kept for the newline
+    size--;
+    size_t length = snprintf(line, size, "%u.%03u %c ", (unsigned int)(time / 1000), (unsigned int)(time % 1000),
+        level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG ? "EWID"[level - 1] : '?');
+    if(length > size - 1){
+        length = size - 1;
+    }
+
+    char c;
+    while(length < size - 1 && (c = pgm_read_byte(format++)) != '\0'){
+        if(c != '%'){
+            line[length++] = c;
+            continue;
+        }
+        //Flags and width are kept, length modifiers don't matter for packed values
+        char spec[8] = "%";
+        uint8_t specLength = 1;
+        while((c = pgm_read_byte(format++)) != '\0' && strchr("-0123456789lh", c) != nullptr){
+            if(c != 'l' && c != 'h' && specLength < sizeof(spec) - 2){
+                spec[specLength++] = c;
+            }
+        }
+        if(c == '\0'){
+            break;
+        }
+        if(c == '%'){
+            line[length++] = '%';
+            continue;
+        }
+        if(arg >= argEnd){
+            line[length++] = '?';
+            continue;
+        }
+
+        int written = 0;
+        uint8_t type = peek(arg++);
+        switch (type)
+        {
+        case LOG_ARG_INT:
+        case LOG_ARG_UINT:
+        {
+            uint32_t value = peekWord(arg);
+            arg += 4;
+            spec[specLength++] = c == 's' ? (type == LOG_ARG_INT ? 'd' : 'u') : c;
+            spec[specLength] = '\0';
+            if(c == 'd' || c == 'i'){
+                written = snprintf(line + length, size - length, spec, (int)value);
+            } else {
+                written = snprintf(line + length, size - length, spec, (unsigned int)value);
+            }
+            break;
+        }
+
+        case LOG_ARG_STRING:
+        {
+            uint8_t textLength = peek(arg++);
+            for(uint8_t i = 0; i < textLength && length + written < size - 1; i++){
+                line[length + written++] = peek(arg + i);
+            }
+            arg += textLength;
+            break;
+        }
+
+        case LOG_ARG_IP:
+        {
+            uint32_t value = peekWord(arg);
+            arg += 4;
+            written = snprintf(line + length, size - length, "%u.%u.%u.%u",
+                (unsigned int)(value & 0xFF), (unsigned int)(value >> 8 & 0xFF),
+                (unsigned int)(value >> 16 & 0xFF), (unsigned int)(value >> 24));
+            break;
+        }
+
+        case LOG_ARG_REDACTED:
+            written = snprintf(line + length, size - length, "<redacted>");
+            break;
+
+        default:
+            //Unknown type, rest of the record can't be trusted
+            arg = argEnd;
+            break;
+        }
+        length += written;
+        if(length > size - 1){
+            length = size - 1;
+        }
+    }
+    line[length++] = '\n';
+    line[length] = '\0';
+    return length;
+}
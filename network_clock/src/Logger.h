@@ -0,0 +1,140 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+//Calls below this level are not compiled in at all
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING 2048 //Bytes of records kept, power of two
+#define LOG_PAYLOAD 96 //Largest packed argument list of one record
+#define LOG_STRING 32 //Longest string argument kept, longer ones are cut
+#define LOG_LINE 160 //Longest formatted line
+
+#define LOG_HEADER_SIZE (6 + sizeof(PGM_P)) //Time, format, level and payload length
+
+#define LOG_ARG_INT 0
+#define LOG_ARG_UINT 1
+#define LOG_ARG_STRING 2
+#define LOG_ARG_IP 3
+#define LOG_ARG_REDACTED 4
+
+/*
+ * Format strings are literals and go to flash through PSTR.
+ */
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) logger.write(LOG_LEVEL_ERROR, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) logger.write(LOG_LEVEL_WARN, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) logger.write(LOG_LEVEL_INFO, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) logger.write(LOG_LEVEL_DEBUG, PSTR(format), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while(0)
+#endif
+
+/*
+ * Wraps an argument that must never be logged, like passwords.
+ * Only "<redacted>" makes it to the record.
+ */
+struct Redacted {
+};
+
+template<typename T>
+Redacted redact(const T &value){
+  return Redacted();
+}
+
+/*
+ * Logging without waiting on the UART. A call only packs its arguments
+ * next to the flash address of its format string into a RAM ring,
+ * formatting happens later when tick() sends records as fast as the
+ * UART FIFO takes them, or when the ring is read over HTTP.
+ * When the ring is full the oldest records go.
+ */
+class Logger{
+public:
+    template<typename... Args>
+    void write(uint8_t level, PGM_P format, const Args&... args){
+        if constexpr(sizeof...(Args) == 0){
+            //Nothing to pack, no payload buffer to leave unset
+            push(level, format, nullptr, 0);
+            return;
+        }
+        uint8_t payload[LOG_PAYLOAD];
+        uint8_t length = 0;
+        pack(payload, length, args...);
+        push(level, format, payload, length);
+    }
+
+    void tick();
+    void flush();
+    uint32_t oldest();
+    size_t readLine(uint32_t &position, char *line, size_t size);
+    uint32_t getDropped();
+
+private:
+    static void pack(uint8_t *payload, uint8_t &length){}
+
+    template<typename T, typename... Args>
+    static void pack(uint8_t *payload, uint8_t &length, const T &value, const Args&... args){
+        packValue(payload, length, value);
+        pack(payload, length, args...);
+    }
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    packValue(uint8_t *payload, uint8_t &length, const T &value){
+        packNumber(payload, length, std::is_signed<T>::value ? LOG_ARG_INT : LOG_ARG_UINT, (uint32_t)value);
+    }
+
+    static void packValue(uint8_t *payload, uint8_t &length, const char *text);
+    static void packValue(uint8_t *payload, uint8_t &length, const String &text);
+    static void packValue(uint8_t *payload, uint8_t &length, const IPAddress &address);
+    static void packValue(uint8_t *payload, uint8_t &length, const Redacted &secret);
+    static void packNumber(uint8_t *payload, uint8_t &length, uint8_t type, uint32_t value);
+
+    void push(uint8_t level, PGM_P format, const uint8_t *payload, uint8_t length);
+    uint8_t peek(uint32_t position);
+    uint32_t peekWord(uint32_t position);
+    uint16_t recordSize(uint32_t position);
+    size_t format(uint32_t position, char *line, size_t size);
+
+    //Positions only grow, they are masked on access
+    uint8_t _ring[LOG_RING];
+    uint32_t _head = 0;
+    uint32_t _tail = 0;
+    uint32_t _uart = 0;
+    uint32_t _dropped = 0;
+
+    char _line[LOG_LINE];
+    size_t _linePos = 0;
+    size_t _lineLen = 0;
+};
+
+extern Logger logger;
+
+#endif
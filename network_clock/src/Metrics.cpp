@@ -0,0 +1,89 @@
+#include "Metrics.h"
+
+static const char *const seriesNames[METRIC_SERIES] = {
+    "httpRead", "httpWrite", "httpFile", "display", "loop"
+};
+
+void Metrics::reset(){
+    memset(_series, 0, sizeof(_series));
+    _since = millis();
+}
+
+/*
+ * Adds one sample, elapsed in us. Loop passes fill a count in about a
+ * day, then every series starts over so they still share getSeconds().
+ */
+void Metrics::record(uint8_t series, uint32_t elapsed){
+    if(series >= METRIC_SERIES){
+        return;
+    }
+    Latency_Histogram &histogram = _series[series];
+    if(histogram.count == UINT32_MAX){
+        reset();
+    }
+    uint32_t ms = elapsed / 1000;
+    uint8_t bucket = 0;
+    while(ms > 0 && bucket < METRIC_BUCKETS - 1){
+        ms >>= 1;
+        bucket++;
+    }
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.sum += elapsed;
+    if(elapsed > histogram.max){
+        histogram.max = elapsed;
+    }
+}
+
+/*
+ * Seconds covered by the samples, for rates.
+ */
+uint32_t Metrics::getSeconds(){
+    return (millis() - _since) / 1000;
+}
+
+uint32_t Metrics::getCount(uint8_t series){
+    return series < METRIC_SERIES ? _series[series].count : 0;
+}
+
+uint32_t Metrics::getMean(uint8_t series){
+    if(series >= METRIC_SERIES || _series[series].count == 0){
+        return 0;
+    }
+    return _series[series].sum / _series[series].count;
+}
+
+uint32_t Metrics::getMax(uint8_t series){
+    return series < METRIC_SERIES ? _series[series].max : 0;
+}
+
+uint32_t Metrics::getBucket(uint8_t series, uint8_t bucket){
+    if(series >= METRIC_SERIES || bucket >= METRIC_BUCKETS){
+        return 0;
+    }
+    return _series[series].buckets[bucket];
+}
+
+/*
+ * Upper bound in ms of the bucket the percentile falls in, so it is never
+ * better than the truth. The max stands in for the open last bucket.
+ */
+uint32_t Metrics::getPercentile(uint8_t series, uint8_t percent){
+    if(series >= METRIC_SERIES || _series[series].count == 0){
+        return 0;
+    }
+    const Latency_Histogram &histogram = _series[series];
+    uint32_t rank = ((uint64_t)histogram.count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for(uint8_t i = 0; i < METRIC_BUCKETS - 1; i++){
+        seen += histogram.buckets[i];
+        if(seen >= rank){
+            return min((uint32_t)1 << i, histogram.max / 1000 + 1);
+        }
+    }
+    return histogram.max / 1000 + 1;
+}
+
+const char* Metrics::getName(uint8_t series){
+    return series < METRIC_SERIES ? seriesNames[series] : "";
+}
@@ -0,0 +1,48 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+#define METRIC_BUCKETS 12 //Bucket i holds values under 2^i ms, the last one the rest
+
+enum MetricSeries {
+  METRIC_HTTP_READ, //GET handlers
+  METRIC_HTTP_WRITE, //Other handlers, login and settings included
+  METRIC_HTTP_FILE, //Static files
+  METRIC_DISPLAY, //How late into its second the display tick ran
+  METRIC_LOOP, //One pass of loop()
+  METRIC_SERIES
+};
+
+typedef struct Latency_Histogram_t {
+  uint32_t buckets[METRIC_BUCKETS];
+  uint32_t count;
+  uint32_t max; //us
+  uint64_t sum; //us
+}Latency_Histogram;
+
+/*
+ * Latency histograms of the web server and of the clock itself, read
+ * side by side while clients load the UI, to see what requests cost the
+ * timekeeping. Buckets are powers of two so recording is a few shifts
+ * and RAM use is fixed.
+ */
+class Metrics{
+public:
+    void reset();
+    void record(uint8_t series, uint32_t elapsed);
+
+    uint32_t getSeconds();
+    uint32_t getCount(uint8_t series);
+    uint32_t getMean(uint8_t series);
+    uint32_t getMax(uint8_t series);
+    uint32_t getBucket(uint8_t series, uint8_t bucket);
+    uint32_t getPercentile(uint8_t series, uint8_t percent);
+    static const char* getName(uint8_t series);
+
+private:
+    Latency_Histogram _series[METRIC_SERIES];
+    uint32_t _since = 0; //millis() at reset
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "NtpClient.h"
+
+NtpClient::NtpClient(SoftClock &clock) : _clock(clock){
+}
+
+bool NtpClient::begin(uint16_t port){
+    if(_pcb != nullptr){
+        return true;
+    }
+    _pcb = udp_new();
+    if(_pcb == nullptr){
+        return false;
+    }
+    if(udp_bind(_pcb, IP_ADDR_ANY, port) != ERR_OK){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+        return false;
+    }
+    udp_recv(_pcb, onPacket, this);
+    return true;
+}
+
+void NtpClient::stop(){
+    if(_pcb != nullptr){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+    }
+    _pending = false;
+}
+
+/*
+ * Sends a request, any reply to an earlier one is ignored from now on.
+ */
+bool NtpClient::send(IPAddress server){
+    if(_pcb == nullptr){
+        return false;
+    }
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, NTP_PACKET_SIZE, PBUF_RAM);
+    if(p == nullptr){
+        return false;
+    }
+    _request = _clock.nowNtp();
+    NtpPacket::buildRequest((uint8_t*)p->payload, _request);
+
+    ip_addr_t address;
+    ip_addr_set_ip4_u32(&address, (uint32_t)server);
+    _server = (uint32_t)server;
+    _replied = false;
+    _pending = true;
+    err_t result = udp_sendto(_pcb, p, &address, NTP_PORT);
+    //Packet is with the driver now, building it doesn't count as network delay
+    _sent = _clock.nowNtp();
+    pbuf_free(p);
+    if(result != ERR_OK){
+        _pending = false;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * True once a valid reply to the last request has come in.
+ */
+bool NtpClient::hasReply(){
+    return _replied;
+}
+
+const Ntp_Reply& NtpClient::getReply(){
+    return _reply;
+}
+
+uint32_t NtpClient::getServer(){
+    return _server;
+}
+
+void NtpClient::onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port){
+    //Receive timestamp comes first, everything else adds error
+    NtpClient *client = (NtpClient*)arg;
+    uint64_t received = client->_clock.nowNtp();
+    client->handle(p, addr, received);
+}
+
+void NtpClient::handle(struct pbuf *p, const ip_addr_t *addr, uint64_t received){
+    uint8_t packet[NTP_PACKET_SIZE];
+    uint16_t length = pbuf_copy_partial(p, packet, sizeof(packet), 0);
+    pbuf_free(p);
+
+    //Only the server asked may answer, and only once
+    if(!_pending || ip_addr_get_ip4_u32(addr) != _server){
+        return;
+    }
+    if(!NtpPacket::parseReply(packet, length, _request, _sent, received, _reply)){
+        LOG_WARN("Bad or stale NTP reply");
+        return;
+    }
+    _pending = false;
+    _replied = true;
+}
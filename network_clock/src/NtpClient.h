@@ -0,0 +1,52 @@
+#ifndef NTPCLIENT_H
+#define NTPCLIENT_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <SoftClock.h>
+#include <NtpPacket.h>
+#include <Logger.h>
+
+extern "C" {
+#include <lwip/udp.h>
+#include <lwip/pbuf.h>
+}
+
+#define NTP_PORT 123
+#define NTP_TIMEOUT 2000 //ms to wait for a reply before asking again
+
+/*
+ * Asks an upstream server for time over a raw lwIP socket.
+ * The request is timestamped right after it is handed to lwIP and the
+ * reply first thing in the receive callback. lwIP only runs that callback
+ * once loop() returns or yields, so whatever is left of the loop pass
+ * when the reply comes in is measured as network delay. The offset is
+ * still within half the measured round trip, the error we report.
+ */
+class NtpClient{
+public:
+    NtpClient(SoftClock &clock);
+    bool begin(uint16_t port);
+    void stop();
+    bool send(IPAddress server);
+
+    bool hasReply();
+    const Ntp_Reply& getReply();
+    uint32_t getServer();
+
+private:
+    static void onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port);
+    void handle(struct pbuf *p, const ip_addr_t *addr, uint64_t received);
+
+    SoftClock &_clock;
+    struct udp_pcb *_pcb = nullptr;
+
+    uint32_t _server = 0; //IPv4 address the pending request went to
+    uint64_t _request = 0; //Transmit time in the request, pairs the reply with it
+    uint64_t _sent = 0; //When the request actually left
+    bool _pending = false;
+    bool _replied = false;
+    Ntp_Reply _reply;
+};
+
+#endif
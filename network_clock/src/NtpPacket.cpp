@@ -0,0 +1,69 @@
+#include "NtpPacket.h"
+
+/*
+ * Fills a client request. transmit comes back as originate time in the
+ * reply, it pairs the reply with this request.
+ */
+void NtpPacket::buildRequest(uint8_t *buffer, uint64_t transmit){
+    memset(buffer, 0, NTP_PACKET_SIZE);
+    buffer[0] = 0b11100011; // LI, Version, Mode
+    buffer[1] = 2; // Stratum, or type of clock
+    buffer[2] = 6; // Polling Interval
+    buffer[3] = 0xEC; // Peer Clock Precision
+    // 8 bytes of zero for Root Delay & Root Dispersion
+    buffer[12] = 49;
+    buffer[13] = 0x4E;
+    buffer[14] = 49;
+    buffer[15] = 52;
+    writeStamp(buffer + 40, transmit);
+}
+
+/*
+ * Checks a reply to the request that carried request as transmit time.
+ * sent and received are our NTP times the request left and the reply
+ * arrived. Offset and round trip come from the four timestamps, halved
+ * first so huge offsets don't overflow.
+ */
+bool NtpPacket::parseReply(const uint8_t *buffer, size_t length, uint64_t request, uint64_t sent, uint64_t received, Ntp_Reply &reply){
+    if(length < NTP_PACKET_SIZE || (buffer[0] & 0x07) != NTP_MODE_SERVER){
+        return false;
+    }
+    //Stratum 0 is a kiss-o'-death, the server wants us gone
+    if(buffer[1] == 0 || buffer[1] > 15){
+        return false;
+    }
+    //Leap indicator 3, the server isn't synchronised itself
+    if((buffer[0] >> 6) == NTP_LEAP_ALARM){
+        return false;
+    }
+    if(readStamp(buffer + 24) != request){
+        //Reply to an earlier request, times in it aren't ours
+        return false;
+    }
+    uint64_t serverReceived = readStamp(buffer + 32);
+    uint64_t serverSent = readStamp(buffer + 40);
+    if(serverSent == 0){
+        return false;
+    }
+    reply.offset = SoftClock::toMicros(((int64_t)(serverReceived - sent) >> 1) + ((int64_t)(serverSent - received) >> 1));
+    reply.delay = SoftClock::toMicros((int64_t)(received - sent) - (int64_t)(serverSent - serverReceived));
+    reply.stratum = buffer[1];
+    reply.rootDelay = readWord(buffer + 4);
+    reply.rootDispersion = readWord(buffer + 8);
+    return true;
+}
+
+uint64_t NtpPacket::readStamp(const uint8_t *buffer){
+    return (uint64_t)readWord(buffer) << 32 | readWord(buffer + 4);
+}
+
+void NtpPacket::writeStamp(uint8_t *buffer, uint64_t stamp){
+    for(int i = 7; i >= 0; i--){
+        buffer[i] = stamp;
+        stamp >>= 8;
+    }
+}
+
+uint32_t NtpPacket::readWord(const uint8_t *buffer){
+    return (uint32_t)buffer[0] << 24 | (uint32_t)buffer[1] << 16 | (uint32_t)buffer[2] << 8 | buffer[3];
+}
@@ -0,0 +1,36 @@
+#ifndef NTPPACKET_H
+#define NTPPACKET_H
+
+#include <Arduino.h>
+#include <SoftClock.h>
+
+#define NTP_PACKET_SIZE 48
+#define NTP_MODE_SERVER 4
+#define NTP_LEAP_ALARM 3 //Leap indicator of an unsynchronised server
+
+/*
+ * What a server reply tells about our clock.
+ */
+typedef struct Ntp_Reply_t {
+  int64_t offset; //us to add to our clock
+  int64_t delay; //us round trip, without the time spent in the server
+  uint8_t stratum;
+  uint32_t rootDelay; //16.16 seconds, as sent
+  uint32_t rootDispersion;
+}Ntp_Reply;
+
+/*
+ * Client side NTP packets, kept free of sockets and globals so they
+ * can be tested and benchmarked on the host.
+ */
+class NtpPacket{
+public:
+    static void buildRequest(uint8_t *buffer, uint64_t transmit);
+    static bool parseReply(const uint8_t *buffer, size_t length, uint64_t request, uint64_t sent, uint64_t received, Ntp_Reply &reply);
+
+    static uint64_t readStamp(const uint8_t *buffer);
+    static void writeStamp(uint8_t *buffer, uint64_t stamp);
+    static uint32_t readWord(const uint8_t *buffer);
+};
+
+#endif
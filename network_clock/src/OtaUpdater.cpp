@@ -0,0 +1,152 @@
+#include "OtaUpdater.h"
+
+/*
+ * Prepares flash for a new image. md5 is the hex digest of the
+ * uncompressed image, empty to skip the check.
+ */
+bool OtaUpdater::begin(OtaTarget target, const char *md5){
+    abort();
+    _target = target;
+    _received = 0;
+    _compressed = false;
+    _started = false;
+    _finished = false;
+    _error = nullptr;
+
+    //Size of the image isn't known before it is inflated, whole area is offered
+    //and end() cuts it to what was written
+    bool begun;
+    if(target == OTA_FILESYSTEM){
+        SPIFFS.end();
+        begun = Update.begin(FS_end - FS_start, U_FS);
+    } else {
+        begun = Update.begin((ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000, U_FLASH);
+    }
+    if(!begun){
+        return fail("space");
+    }
+    _running = true;
+
+    if(md5 != nullptr && md5[0] != '\0'){
+        if(strlen(md5) != OTA_MD5_SIZE || !Update.setMD5(md5)){
+            return fail("md5");
+        }
+    }
+    return true;
+}
+
+/*
+ * Passes a piece of the upload on to flash.
+ */
+bool OtaUpdater::write(const uint8_t *data, size_t length){
+    if(!_running){
+        return false;
+    }
+    if(!_started){
+        //Decided on the first piece, gzip images start with 1F 8B
+        if(length < 2){
+            return fail("short");
+        }
+        _compressed = data[0] == 0x1F && data[1] == 0x8B;
+        if(_compressed && !_inflater.begin(writeFlash)){
+            return fail("heap");
+        }
+        _started = true;
+    }
+    _received += length;
+
+    if(!_compressed){
+        return writeFlash(data, length) || fail("flash");
+    }
+    if(_finished){
+        //Nothing is expected after the gzip trailer
+        return fail("data");
+    }
+    switch (_inflater.write(data, length, false))
+    {
+    case INFLATE_DONE:
+        _finished = true;
+        return true;
+    case INFLATE_OK:
+        return true;
+    default:
+        return fail("inflate");
+    }
+}
+
+/*
+ * Completes the image. Firmware is only marked for boot if this returns true.
+ */
+bool OtaUpdater::end(){
+    if(!_running){
+        return false;
+    }
+    if(!_started){
+        return fail("empty");
+    }
+    if(_compressed){
+        uint8_t none = 0;
+        if(!_finished && _inflater.write(&none, 0, true) != INFLATE_DONE){
+            return fail("inflate");
+        }
+        _inflater.end();
+    }
+    _running = false;
+    if(!Update.end(true)){
+        _error = "verify";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Drops the image. For firmware nothing changes, the old image keeps booting.
+ */
+void OtaUpdater::abort(){
+    if(!_running){
+        return;
+    }
+    _running = false;
+    _inflater.end();
+    //Ending an incomplete update fails and leaves the boot image alone
+    Update.end(false);
+}
+
+bool OtaUpdater::isRunning(){
+    return _running;
+}
+
+OtaTarget OtaUpdater::getTarget(){
+    return _target;
+}
+
+/*
+ * Bytes uploaded, compressed if the image is.
+ */
+uint32_t OtaUpdater::getReceived(){
+    return _received;
+}
+
+/*
+ * Bytes passed to flash.
+ */
+uint32_t OtaUpdater::getWritten(){
+    return _compressed ? _inflater.getTotal() : _received;
+}
+
+/*
+ * Short reason of the last failure, nullptr if there was none.
+ */
+const char* OtaUpdater::getError(){
+    return _error;
+}
+
+bool OtaUpdater::fail(const char *error){
+    abort();
+    _error = error;
+    return false;
+}
+
+bool OtaUpdater::writeFlash(const uint8_t *data, size_t length){
+    return Update.write((uint8_t*)data, length) == length;
+}
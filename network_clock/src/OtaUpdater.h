@@ -0,0 +1,52 @@
+#ifndef OTAUPDATER_H
+#define OTAUPDATER_H
+
+#include <Arduino.h>
+#include <Updater.h>
+#include <FS.h>
+#include <flash_hal.h>
+#include <Inflater.h>
+
+#define OTA_MD5_SIZE 32 //Hex digest
+
+enum OtaTarget {
+  OTA_FIRMWARE,
+  OTA_FILESYSTEM
+};
+
+/*
+ * Writes an uploaded image to flash as it arrives. Images may be gzip
+ * compressed, they are detected by their magic and inflated on the way,
+ * so only the window is held in RAM and never the image.
+ * New firmware is only booted if the whole image arrived and its digest
+ * matches, otherwise the running one stays. The filesystem is written in
+ * place and can't be rolled back.
+ */
+class OtaUpdater{
+public:
+    bool begin(OtaTarget target, const char *md5);
+    bool write(const uint8_t *data, size_t length);
+    bool end();
+    void abort();
+
+    bool isRunning();
+    OtaTarget getTarget();
+    uint32_t getReceived();
+    uint32_t getWritten();
+    const char* getError();
+
+private:
+    bool fail(const char *error);
+    static bool writeFlash(const uint8_t *data, size_t length);
+
+    Inflater _inflater;
+    OtaTarget _target = OTA_FIRMWARE;
+    bool _running = false;
+    bool _compressed = false;
+    bool _started = false;
+    bool _finished = false;
+    uint32_t _received = 0;
+    const char *_error = nullptr;
+};
+
+#endif
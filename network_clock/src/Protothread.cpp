@@ -0,0 +1,55 @@
+#include "Protothread.h"
+
+/*
+ * Starts function from the top. A task that is already running is left
+ * alone, so the same work is never done twice at once.
+ */
+bool TaskRunner::start(TaskFunction function){
+    if(isRunning(function)){
+        return false;
+    }
+    for(int i = 0; i < PT_TASKS; i++){
+        if(_tasks[i].function == nullptr){
+            _tasks[i].function = function;
+            _tasks[i].pt.line = 0;
+            _tasks[i].pt.now = _now;
+            _tasks[i].pt.mark = _now;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskRunner::stop(TaskFunction function){
+    for(int i = 0; i < PT_TASKS; i++){
+        if(_tasks[i].function == function){
+            _tasks[i].function = nullptr;
+        }
+    }
+}
+
+bool TaskRunner::isRunning(TaskFunction function){
+    for(int i = 0; i < PT_TASKS; i++){
+        if(_tasks[i].function == function){
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Resumes every task once. now is in ms.
+ */
+void TaskRunner::tick(uint32_t now){
+    _now = now;
+    for(int i = 0; i < PT_TASKS; i++){
+        Task_Slot &task = _tasks[i];
+        if(task.function == nullptr){
+            continue;
+        }
+        task.pt.now = now;
+        if(task.function(&task.pt) != PT_WAITING){
+            task.function = nullptr;
+        }
+    }
+}
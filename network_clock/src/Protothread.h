@@ -0,0 +1,81 @@
+#ifndef PROTOTHREAD_H
+#define PROTOTHREAD_H
+
+#include <Arduino.h>
+
+#define PT_TASKS 4 //Tasks that can run at once
+
+#define PT_WAITING 0
+#define PT_EXITED 1
+#define PT_ENDED 2
+
+typedef struct Protothread_t {
+  uint16_t line; //Where to resume, 0 is the top
+  uint32_t now; //ms, set by the runner before every resume
+  uint32_t mark; //ms, start of the current wait
+}Protothread;
+
+/*
+ * Stackless tasks in the protothread style. A task is a function that
+ * returns at every wait and jumps back to it on the next resume through
+ * a switch on the line number, so it costs a few bytes instead of a stack.
+ * Locals don't survive a wait, keep state in globals. A task can't use a
+ * switch of its own around a wait.
+ *
+ * Time comes from the runner, never from millis() directly, so tasks can
+ * be run against any clock.
+ */
+#define PT_THREAD(name) uint8_t name(Protothread *pt)
+
+#define PT_BEGIN(pt) switch((pt)->line) { case 0:
+#define PT_END(pt) } (pt)->line = 0; return PT_ENDED
+
+#define PT_WAIT_UNTIL(pt, condition) \
+  do { \
+    (pt)->line = __LINE__; case __LINE__: \
+    if(!(condition)) return PT_WAITING; \
+  } while(0)
+
+#define PT_WAIT_WHILE(pt, condition) PT_WAIT_UNTIL(pt, !(condition))
+
+//Waits for condition, giving up after ms. PT_TIMED_OUT tells which one happened.
+#define PT_WAIT_UNTIL_TIMEOUT(pt, condition, ms) \
+  do { \
+    (pt)->mark = (pt)->now; \
+    PT_WAIT_UNTIL(pt, (condition) || (pt)->now - (pt)->mark >= (uint32_t)(ms)); \
+  } while(0)
+
+#define PT_TIMED_OUT(pt, ms) ((pt)->now - (pt)->mark >= (uint32_t)(ms))
+
+#define PT_DELAY(pt, ms) PT_WAIT_UNTIL_TIMEOUT(pt, false, ms)
+
+#define PT_EXIT(pt) \
+  do { \
+    (pt)->line = 0; \
+    return PT_EXITED; \
+  } while(0)
+
+typedef uint8_t (*TaskFunction)(Protothread *pt);
+
+typedef struct Task_Slot_t {
+  TaskFunction function; //nullptr if free
+  Protothread pt;
+}Task_Slot;
+
+/*
+ * Resumes running tasks from loop(). Scheduled functions start tasks
+ * for work that has to wait on the network.
+ */
+class TaskRunner{
+public:
+    bool start(TaskFunction function);
+    void stop(TaskFunction function);
+    bool isRunning(TaskFunction function);
+    void tick(uint32_t now);
+
+private:
+    Task_Slot _tasks[PT_TASKS] = {};
+    uint32_t _now = 0;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "Provisioner.h"
+
+/*
+ * Starts answering DNS for every name with address, the access point's own.
+ */
+void Provisioner::begin(IPAddress address){
+    _address = address;
+    _dns.setErrorReplyCode(DNSReplyCode::NoError);
+    _dns.setTTL(DNS_TTL);
+    _dns.start(DNS_PORT, "*", address);
+    _active = true;
+    //First scan right away, the UI is usually opened within seconds
+    _scanMillis = millis() - SCAN_INTERVAL;
+}
+
+void Provisioner::stop(){
+    if(!_active){
+        return;
+    }
+    _dns.stop();
+    if(_scanning){
+        WiFi.scanDelete();
+        _scanning = false;
+    }
+    _active = false;
+}
+
+/*
+ * Runs from loop(). Scans only start when canScan is set, since a scan
+ * takes the radio away from a station that is connecting.
+ */
+void Provisioner::tick(bool canScan){
+    if(!_active){
+        return;
+    }
+    _dns.processNextRequest();
+
+    if(_scanning){
+        int8_t found = WiFi.scanComplete();
+        if(found == WIFI_SCAN_RUNNING){
+            return;
+        }
+        _scanning = false;
+        _scanMillis = millis();
+        if(found >= 0){
+            collect(found);
+        }
+        WiFi.scanDelete();
+        return;
+    }
+
+    if(canScan && millis() - _scanMillis >= SCAN_INTERVAL){
+        //Async, results are picked up by later ticks
+        _scanning = WiFi.scanNetworks(true, false) == WIFI_SCAN_RUNNING;
+        _scanMillis = millis();
+    }
+}
+
+bool Provisioner::isActive(){
+    return _active;
+}
+
+IPAddress Provisioner::getAddress(){
+    return _address;
+}
+
+uint8_t Provisioner::getCount(){
+    return _count;
+}
+
+const Scan_Result& Provisioner::get(uint8_t index){
+    return _results[index];
+}
+
+/*
+ * ms since results were collected, 0 if there are none yet.
+ */
+uint32_t Provisioner::getAge(){
+    return _resultMillis == 0 ? 0 : millis() - _resultMillis;
+}
+
+/*
+ * Keeps the strongest access point of every network, strongest first.
+ * Networks seen through several access points are listed once.
+ */
+void Provisioner::collect(int8_t found){
+    _count = 0;
+    for(int8_t i = 0; i < found; i++){
+        String ssid = WiFi.SSID(i);
+        if(ssid.length() == 0 || ssid.length() > 32){
+            continue;
+        }
+        int8_t rssi = WiFi.RSSI(i);
+
+        //Same network from another access point
+        uint8_t index = 0;
+        while(index < _count && strcmp(_results[index].ssid, ssid.c_str()) != 0){
+            index++;
+        }
+        if(index < _count){
+            if(rssi <= _results[index].rssi){
+                continue;
+            }
+            //Stronger one is moved up below
+            memmove(_results + index, _results + index + 1, (_count - index - 1) * sizeof(Scan_Result));
+            _count--;
+        }
+
+        //Insert sorted, weakest falls off when full
+        uint8_t position = 0;
+        while(position < _count && _results[position].rssi >= rssi){
+            position++;
+        }
+        if(position == SCAN_MAX){
+            continue;
+        }
+        uint8_t moved = _count < SCAN_MAX ? _count - position : SCAN_MAX - 1 - position;
+        memmove(_results + position + 1, _results + position, moved * sizeof(Scan_Result));
+        if(_count < SCAN_MAX){
+            _count++;
+        }
+
+        Scan_Result &result = _results[position];
+        strncpy(result.ssid, ssid.c_str(), sizeof(result.ssid) - 1);
+        result.ssid[sizeof(result.ssid) - 1] = '\0';
+        result.rssi = rssi;
+        result.channel = WiFi.channel(i);
+        result.secure = WiFi.encryptionType(i) != ENC_TYPE_NONE;
+    }
+    _resultMillis = millis();
+    if(_resultMillis == 0){
+        _resultMillis = 1;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PROVISIONER_H
+#define PROVISIONER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <DNSServer.h>
+
+#define DNS_PORT 53
+#define DNS_TTL 10 //s, short so names resolve normally soon after provisioning
+
+#define SCAN_MAX 16 //Networks kept, strongest first
+#define SCAN_INTERVAL 15000 //ms between scans while provisioning
+
+typedef struct Scan_Result_t {
+  char ssid[33];
+  int8_t rssi;
+  uint8_t channel;
+  bool secure;
+}Scan_Result;
+
+/*
+ * Gets a unit onto the network from its access point.
+ * Every name resolves to the unit so phones open the UI on their own,
+ * and networks around are scanned in the background so the UI can list
+ * them without waiting for the radio.
+ */
+class Provisioner{
+public:
+    void begin(IPAddress address);
+    void stop();
+    void tick(bool canScan);
+
+    bool isActive();
+    IPAddress getAddress();
+    uint8_t getCount();
+    const Scan_Result& get(uint8_t index);
+    uint32_t getAge();
+
+private:
+    void collect(int8_t found);
+
+    DNSServer _dns;
+    IPAddress _address;
+    bool _active = false;
+    bool _scanning = false;
+    uint32_t _scanMillis = 0;
+    uint32_t _resultMillis = 0;
+
+    Scan_Result _results[SCAN_MAX];
+    uint8_t _count = 0;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "Resolver.h"
+
+/*
+ * Starts looking name up. Cached names and plain addresses are done
+ * right away. False if lwIP couldn't even start the lookup.
+ */
+bool Resolver::begin(const char *name){
+    if(_pending){
+        return true;
+    }
+    _resolved = false;
+    ip_addr_t address;
+    err_t result = dns_gethostbyname(name, &address, onFound, this);
+    if(result == ERR_OK){
+        _address = ip_addr_get_ip4_u32(&address);
+        _resolved = true;
+        return true;
+    }
+    _pending = result == ERR_INPROGRESS;
+    return _pending;
+}
+
+bool Resolver::isDone(){
+    return !_pending;
+}
+
+bool Resolver::isResolved(){
+    return !_pending && _resolved;
+}
+
+IPAddress Resolver::getAddress(){
+    return IPAddress(_address);
+}
+
+/*
+ * Called by lwIP, address is null if the name couldn't be found.
+ */
+void Resolver::onFound(const char *name, const ip_addr_t *address, void *arg){
+    Resolver *resolver = (Resolver*)arg;
+    if(address != nullptr){
+        resolver->_address = ip_addr_get_ip4_u32(address);
+        resolver->_resolved = true;
+    }
+    resolver->_pending = false;
+}
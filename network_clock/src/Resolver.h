@@ -0,0 +1,34 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+extern "C" {
+#include <lwip/dns.h>
+}
+
+#define DNS_TIMEOUT 5000 //ms to wait for a name before trying again, lwIP keeps looking
+
+/*
+ * Looks names up through lwIP without blocking the loop. The answer
+ * comes in a callback from the SDK, tasks wait on isDone(). lwIP always
+ * answers in the end, with its own timeout, so a lookup that is still
+ * going is picked up again instead of being started twice.
+ */
+class Resolver{
+public:
+    bool begin(const char *name);
+    bool isDone();
+    bool isResolved();
+    IPAddress getAddress();
+
+private:
+    static void onFound(const char *name, const ip_addr_t *address, void *arg);
+
+    volatile bool _pending = false;
+    volatile bool _resolved = false;
+    volatile uint32_t _address = 0;
+};
+
+#endif
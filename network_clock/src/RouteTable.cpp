@@ -0,0 +1,90 @@
+#include "RouteTable.h"
+
+const Route* RouteTable::find(const Route *routes, size_t count, uint8_t method, const char *path, size_t length){
+    uint32_t key = hash(method, path, length);
+    size_t low = 0;
+    size_t high = count;
+    while(low < high){
+        size_t middle = (low + high) / 2;
+        if(routes[middle].hash < key){
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if(low == count || routes[low].hash != key){
+        return nullptr;
+    }
+    //Paths that aren't in the table can still share a hash with one that is
+    const Route &route = routes[low];
+    if(route.length != length || memcmp(route.path, path, length) != 0){
+        return nullptr;
+    }
+    return &route;
+}
+
+RouteHandler::RouteHandler(const Route *routes, size_t count) : _routes(routes), _count(count){
+}
+
+/*
+ * callback gets every route served and the us it took.
+ */
+void RouteHandler::setCallback(void (*callback)(const Route &route, uint32_t elapsed)){
+    _callback = callback;
+}
+
+/*
+ * Server asks this first for every request, the match is kept for the calls after.
+ */
+bool RouteHandler::canHandle(HTTPMethod method, const String &uri){
+    _match = RouteTable::find(_routes, _count, method, uri.c_str(), uri.length());
+    return _match != nullptr;
+}
+
+bool RouteHandler::canUpload(const String &uri){
+    return _match != nullptr && _match->upload != nullptr;
+}
+
+bool RouteHandler::handle(ESP8266WebServer &server, HTTPMethod method, const String &uri){
+    if(_match == nullptr){
+        return false;
+    }
+    uint32_t start = micros();
+    bool handled = true;
+    if(_match->handler != nullptr){
+        _match->handler();
+    } else {
+        handled = sendFile(server, *_match);
+    }
+    if(handled && _callback != nullptr){
+        _callback(*_match, micros() - start);
+    }
+    return handled;
+}
+
+void RouteHandler::upload(ESP8266WebServer &server, const String &uri, HTTPUpload &upload){
+    if(_match != nullptr && _match->upload != nullptr){
+        _match->upload();
+    }
+}
+
+/*
+ * Streams a static file, the gzipped copy if there is one.
+ */
+bool RouteHandler::sendFile(ESP8266WebServer &server, const Route &route){
+    SPIFFS.begin();
+    char path[32];
+    snprintf(path, sizeof(path), "%s.gz", route.file);
+    File file = SPIFFS.open(path, "r");
+    if(!file){
+        file = SPIFFS.open(route.file, "r");
+    }
+    if(!file){
+        SPIFFS.end();
+        return false;
+    }
+    server.streamFile(file, route.type);
+    file.close();
+    SPIFFS.end();
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <FS.h>
+#include <array>
+
+typedef struct Route_t {
+  uint32_t hash; //Of method and path
+  uint8_t method;
+  uint8_t length;
+  const char *path;
+  void (*handler)(void); //nullptr for static files
+  void (*upload)(void);
+  const char *file; //Static files only
+  const char *type;
+}Route;
+
+/*
+ * Routes are a constexpr array sorted by hash of method and path, so a
+ * request costs one hash, a binary search over integers and one memcmp.
+ * Hashes are checked to be unique at compile time, which makes the hash
+ * perfect for the table.
+ */
+struct RouteTable{
+    //FNV-1a
+    static constexpr uint32_t hash(uint8_t method, const char *path, size_t length){
+        uint32_t value = 2166136261UL;
+        for(size_t i = 0; i < length; i++){
+            value = (value ^ (uint8_t)path[i]) * 16777619UL;
+        }
+        return (value ^ method) * 16777619UL;
+    }
+
+    static constexpr size_t length(const char *text){
+        size_t length = 0;
+        while(text[length] != '\0'){
+            length++;
+        }
+        return length;
+    }
+
+    static constexpr Route route(HTTPMethod method, const char *path, void (*handler)(void), void (*upload)(void) = nullptr){
+        return Route{hash(method, path, length(path)), (uint8_t)method, (uint8_t)length(path), path, handler, upload, nullptr, nullptr};
+    }
+
+    static constexpr Route file(const char *path, const char *file, const char *type){
+        return Route{hash(HTTP_GET, path, length(path)), (uint8_t)HTTP_GET, (uint8_t)length(path), path, nullptr, nullptr, file, type};
+    }
+
+    template<size_t N>
+    static constexpr std::array<Route, N> sort(std::array<Route, N> routes){
+        for(size_t i = 1; i < N; i++){
+            for(size_t j = i; j > 0 && routes[j].hash < routes[j - 1].hash; j--){
+                Route route = routes[j];
+                routes[j] = routes[j - 1];
+                routes[j - 1] = route;
+            }
+        }
+        return routes;
+    }
+
+    template<size_t N>
+    static constexpr bool isUnique(const std::array<Route, N> &routes){
+        for(size_t i = 1; i < N; i++){
+            if(routes[i].hash == routes[i - 1].hash){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static const Route* find(const Route *routes, size_t count, uint8_t method, const char *path, size_t length);
+};
+
+/*
+ * Serves the route table to ESP8266WebServer. Anything not in the table is
+ * left to its not found handler without touching flash.
+ */
+class RouteHandler : public RequestHandler{
+public:
+    RouteHandler(const Route *routes, size_t count);
+    void setCallback(void (*callback)(const Route &route, uint32_t elapsed));
+
+    bool canHandle(HTTPMethod method, const String &uri) override;
+    bool canUpload(const String &uri) override;
+    bool handle(ESP8266WebServer &server, HTTPMethod method, const String &uri) override;
+    void upload(ESP8266WebServer &server, const String &uri, HTTPUpload &upload) override;
+
+private:
+    bool sendFile(ESP8266WebServer &server, const Route &route);
+
+    const Route *_routes;
+    size_t _count;
+    const Route *_match = nullptr; //Route of the request being handled
+    void (*_callback)(const Route &route, uint32_t elapsed) = nullptr;
+};
+
+#endif
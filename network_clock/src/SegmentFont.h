@@ -0,0 +1,138 @@
+#ifndef SEGMENTFONT_H
+#define SEGMENTFONT_H
+
+#include <Arduino.h>
+
+/*
+ * Segment bits as they are sent to the MAX7219 in no-decode mode.
+ * MSB to LSB: DP A B C D E F G
+ */
+#define SEG_DP B10000000
+#define SEG_A  B01000000
+#define SEG_B  B00100000
+#define SEG_C  B00010000
+#define SEG_D  B00001000
+#define SEG_E  B00000100
+#define SEG_F  B00000010
+#define SEG_G  B00000001
+
+#define FONT_FIRST_CHAR ' '
+#define FONT_LAST_CHAR '~'
+
+/*
+ * 7-segment font for printable ASCII.
+ * Letters that can't be told apart on 7 segments share a glyph,
+ * characters that can't be drawn at all are blank.
+ */
+struct SegmentFont {
+  static constexpr uint8_t table[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1] = {
+    B00000000, // ' '
+    B10110000, // !
+    B00100010, // "
+    B00000000, // #
+    B01011011, // $
+    B00000000, // %
+    B00000000, // &
+    B00000010, // '
+    B01001110, // (
+    B01111000, // )
+    B01100011, // * drawn as degree sign
+    B00000000, // +
+    B10000000, // ,
+    B00000001, // -
+    B10000000, // .
+    B00100101, // /
+    B01111110, // 0
+    B00110000, // 1
+    B01101101, // 2
+    B01111001, // 3
+    B00110011, // 4
+    B01011011, // 5
+    B00011111, // 6
+    B01110000, // 7
+    B01111111, // 8
+    B01111011, // 9
+    B00000000, // :
+    B00000000, // ;
+    B00000000, // <
+    B00001001, // =
+    B00000000, // >
+    B01100101, // ?
+    B01111101, // @
+    B01110111, // A
+    B00011111, // B
+    B01001110, // C
+    B00111101, // D
+    B01001111, // E
+    B01000111, // F
+    B01011110, // G
+    B00110111, // H
+    B00000110, // I
+    B00111100, // J
+    B01010111, // K
+    B00001110, // L
+    B01010101, // M
+    B01110110, // N
+    B01111110, // O
+    B01100111, // P
+    B01110011, // Q
+    B00000101, // R
+    B01011011, // S
+    B00001111, // T
+    B00111110, // U
+    B00111110, // V
+    B00111110, // W
+    B00110111, // X
+    B00111011, // Y
+    B01101101, // Z
+    B01001110, // [
+    B00010011, // backslash
+    B01111000, // ]
+    B01100010, // ^
+    B00001000, // _
+    B00100000, // `
+    B01111101, // a
+    B00011111, // b
+    B00001101, // c
+    B00111101, // d
+    B01001111, // e
+    B01000111, // f
+    B01111011, // g
+    B00010111, // h
+    B00010000, // i
+    B00111100, // j
+    B01010111, // k
+    B00001110, // l
+    B01010101, // m
+    B00010101, // n
+    B00011101, // o
+    B01100111, // p
+    B01110011, // q
+    B00000101, // r
+    B01011011, // s
+    B00001111, // t
+    B00011100, // u
+    B00011100, // v
+    B00011100, // w
+    B00110111, // x
+    B00111011, // y
+    B01101101, // z
+    B01001110, // {
+    B00000110, // |
+    B01111000, // }
+    B01000000, // ~
+  };
+
+  static constexpr uint8_t glyph(char c){
+    return (c >= FONT_FIRST_CHAR && c <= FONT_LAST_CHAR) ? table[c - FONT_FIRST_CHAR] : 0;
+  }
+
+  static constexpr uint8_t digit(uint8_t n){
+    return table['0' - FONT_FIRST_CHAR + n];
+  }
+};
+
+static_assert(SegmentFont::digit(0) == B01111110 && SegmentFont::digit(9) == B01111011,
+  "Digit glyphs must match the display wiring");
+
+#endif
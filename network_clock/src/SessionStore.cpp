@@ -0,0 +1,71 @@
+#include "SessionStore.h"
+
+/*
+ * Issues a new token, taking the place of the oldest one.
+ */
+const char* SessionStore::create(){
+    char *token = _tokens[_next];
+    _next = (_next + 1) % SESSION_MAX;
+    for(uint8_t i = 0; i < SESSION_TOKEN_SIZE; i += 8){
+        snprintf(token + i, 9, "%08x", ESP.random());
+    }
+    return token;
+}
+
+/*
+ * True if cookie, a whole Cookie header, carries a live token.
+ */
+bool SessionStore::check(const char *cookie){
+    const char *token = find(cookie);
+    if(token == nullptr){
+        return false;
+    }
+    //Every slot is compared, a match doesn't end the loop early
+    bool found = false;
+    for(uint8_t i = 0; i < SESSION_MAX; i++){
+        found |= equals(_tokens[i], token);
+    }
+    return found;
+}
+
+void SessionStore::revoke(const char *cookie){
+    const char *token = find(cookie);
+    if(token == nullptr){
+        return;
+    }
+    for(uint8_t i = 0; i < SESSION_MAX; i++){
+        if(equals(_tokens[i], token)){
+            memset(_tokens[i], 0, sizeof(_tokens[i]));
+        }
+    }
+}
+
+void SessionStore::clear(){
+    memset(_tokens, 0, sizeof(_tokens));
+    _next = 0;
+}
+
+/*
+ * Token in the cookie header, nullptr unless it has the right length.
+ */
+const char* SessionStore::find(const char *cookie){
+    const char *token = strstr(cookie, SESSION_COOKIE);
+    if(token == nullptr){
+        return nullptr;
+    }
+    token += strlen(SESSION_COOKIE);
+    size_t length = strcspn(token, "; ");
+    return length == SESSION_TOKEN_SIZE ? token : nullptr;
+}
+
+/*
+ * Compares a stored token with one from a cookie without stopping at the
+ * first difference. An empty slot never matches.
+ */
+bool SessionStore::equals(const char *stored, const char *token){
+    uint8_t difference = stored[0] == '\0';
+    for(uint8_t i = 0; i < SESSION_TOKEN_SIZE; i++){
+        difference |= stored[i] ^ token[i];
+    }
+    return difference == 0;
+}
@@ -0,0 +1,31 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <Arduino.h>
+
+#define SESSION_MAX 4 //Browsers logged in at once, the oldest is dropped for a new one
+#define SESSION_TOKEN_SIZE 32 //Hex characters, 128 bits from the hardware RNG
+#define SESSION_COOKIE "ESPSESSIONID="
+
+/*
+ * Random per-login session tokens. A login gets a fresh token for its
+ * cookie, requests are let in only with one of the tokens handed out.
+ * Tokens are compared in constant time so timing doesn't leak them,
+ * and live in RAM only, a reboot logs everyone out.
+ */
+class SessionStore{
+public:
+    const char* create();
+    bool check(const char *cookie);
+    void revoke(const char *cookie);
+    void clear();
+
+private:
+    static const char* find(const char *cookie);
+    static bool equals(const char *a, const char *b);
+
+    char _tokens[SESSION_MAX][SESSION_TOKEN_SIZE + 1] = {};
+    uint8_t _next = 0;
+};
+
+#endif
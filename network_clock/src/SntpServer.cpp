@@ -0,0 +1,218 @@
+#include "SntpServer.h"
+#include <NtpPacket.h>
+
+SntpServer::SntpServer(SoftClock &clock) : _clock(clock){
+    memset(_reply, 0, sizeof(_reply));
+    memset(_clients, 0, sizeof(_clients));
+    memset(&_shared, 0, sizeof(_shared));
+    _shared.tokens = RATE_BURST;
+}
+
+bool SntpServer::begin(){
+    if(_pcb != nullptr){
+        return true;
+    }
+    _pcb = udp_new();
+    if(_pcb == nullptr){
+        return false;
+    }
+    if(udp_bind(_pcb, IP_ADDR_ANY, SNTP_PORT) != ERR_OK){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+        return false;
+    }
+    udp_recv(_pcb, onPacket, this);
+    return true;
+}
+
+void SntpServer::stop(){
+    if(_pcb != nullptr){
+        udp_remove(_pcb);
+        _pcb = nullptr;
+    }
+}
+
+/*
+ * Called after every sync. Requests are not answered before the first one.
+ * refId is the source's IPv4 address as lwIP keeps it, root delay and dispersion
+ * are the source's in NTP short format. delay is our round trip to it and
+ * error bounds the offset we were left with, both in us. The round trip
+ * adds to the root delay, the error and our precision to the dispersion.
+ */
+void SntpServer::setReference(uint8_t stratum, uint32_t refId, uint32_t rootDelay, uint32_t rootDispersion, uint32_t delay, uint32_t error){
+    _rootDispersion = addShort(addShort(rootDispersion, toShort(error)), SNTP_PRECISION_SHORT);
+
+    _reply[1] = stratum < 15 ? stratum + 1 : 16;
+    _reply[3] = (uint8_t)(int8_t)SNTP_PRECISION;
+    writeWord(_reply + 4, addShort(rootDelay, toShort(delay)));
+    writeWord(_reply + 8, _rootDispersion);
+    memcpy(_reply + 12, &refId, 4);
+
+    _referenceMicros = _clock.nowMicros();
+    writeStamp(_reply + 16, SoftClock::toNtp(_referenceMicros));
+    _hasReference = true;
+}
+
+/*
+ * Runs once a second. Updates throughput and lets dispersion grow
+ * while the clock runs on its own.
+ */
+void SntpServer::sample(){
+    _rate = _replies - _lastReplies;
+    _lastReplies = _replies;
+
+    if(_hasReference){
+        uint64_t elapsed = _clock.nowMicros() - _referenceMicros;
+        uint32_t grown = elapsed * SNTP_DISPERSION_RATE * 65536ULL / 1000000000000ULL;
+        writeWord(_reply + 8, addShort(_rootDispersion, grown));
+    }
+}
+
+uint32_t SntpServer::getRequests(){
+    return _requests;
+}
+
+uint32_t SntpServer::getReplies(){
+    return _replies;
+}
+
+uint32_t SntpServer::getLimited(){
+    return _limited;
+}
+
+/*
+ * Replies sent in the last second.
+ */
+uint32_t SntpServer::getRate(){
+    return _rate;
+}
+
+/*
+ * Root delay and dispersion we serve, NTP short format.
+ */
+uint32_t SntpServer::getRootDelay(){
+    return NtpPacket::readWord(_reply + 4);
+}
+
+uint32_t SntpServer::getRootDispersion(){
+    return NtpPacket::readWord(_reply + 8);
+}
+
+void SntpServer::onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port){
+    //Receive timestamp comes first, everything else adds error
+    SntpServer *server = (SntpServer*)arg;
+    uint64_t received = server->_clock.nowNtp();
+    server->handle(p, addr, port, received);
+}
+
+/*
+ * Turns the request into the reply in place, so no buffer is allocated per packet.
+ */
+void SntpServer::handle(struct pbuf *p, const ip_addr_t *addr, uint16_t port, uint64_t received){
+    _requests++;
+    uint8_t *packet = (uint8_t*)p->payload;
+    uint8_t mode = packet[0] & B00000111;
+    if(!_hasReference || p->len < SNTP_PACKET_SIZE || mode != 3){
+        pbuf_free(p);
+        return;
+    }
+    if(!allow(ip_addr_get_ip4_u32(addr))){
+        _limited++;
+        pbuf_free(p);
+        return;
+    }
+
+    uint8_t version = (packet[0] >> 3) & B00000111;
+    uint8_t poll = packet[2];
+    uint8_t origin[8];
+    memcpy(origin, packet + 40, sizeof(origin));
+
+    memcpy(packet, _reply, SNTP_PACKET_SIZE);
+    packet[0] = version << 3 | 4; //No leap second, server mode
+    packet[2] = poll;
+    memcpy(packet + 24, origin, sizeof(origin));
+    writeStamp(packet + 32, received);
+    if(p->tot_len > SNTP_PACKET_SIZE){
+        //Drop extension fields of the request
+        pbuf_realloc(p, SNTP_PACKET_SIZE);
+    }
+
+    writeStamp(packet + 40, _clock.nowNtp());
+    if(udp_sendto(_pcb, p, addr, port) == ERR_OK){
+        _replies++;
+    }
+    pbuf_free(p);
+}
+
+/*
+ * Token bucket per client. Unknown clients take a slot that is unused or
+ * idle long enough to be full again, so evicting it forgets nothing. When
+ * every slot is busy they all draw from one shared bucket, a flood of new
+ * addresses then can't push out the clients we already serve.
+ */
+bool SntpServer::allow(uint32_t address){
+    uint32_t now = millis();
+    Rate_Client *client = nullptr;
+    Rate_Client *idle = nullptr;
+    for(int i = 0; i < RATE_CLIENTS; i++){
+        if(_clients[i].address == address){
+            client = &_clients[i];
+            break;
+        }
+        if(idle == nullptr && (_clients[i].address == 0 || now - _clients[i].lastMillis >= RATE_BURST * RATE_REFILL)){
+            idle = &_clients[i];
+        }
+    }
+
+    if(client == nullptr && idle != nullptr){
+        client = idle;
+        client->address = address;
+        client->tokens = RATE_BURST;
+        client->lastMillis = now;
+    } else if(client == nullptr){
+        client = &_shared;
+        refill(_shared, now);
+    } else {
+        refill(*client, now);
+    }
+
+    if(client->tokens == 0){
+        return false;
+    }
+    client->tokens--;
+    return true;
+}
+
+void SntpServer::refill(Rate_Client &client, uint32_t now){
+    uint32_t earned = (now - client.lastMillis) / RATE_REFILL;
+    if(client.tokens + earned >= RATE_BURST){
+        client.tokens = RATE_BURST;
+        client.lastMillis = now;
+    } else {
+        client.tokens += earned;
+        client.lastMillis += earned * RATE_REFILL;
+    }
+}
+
+/*
+ * Microseconds to NTP short format, 16.16 seconds, rounded up.
+ */
+uint32_t SntpServer::toShort(uint32_t micros){
+    return ((uint64_t)micros * 65536ULL + 999999ULL) / 1000000ULL;
+}
+
+uint32_t SntpServer::addShort(uint32_t a, uint32_t b){
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+void SntpServer::writeStamp(uint8_t *buffer, uint64_t stamp){
+    writeWord(buffer, stamp >> 32);
+    writeWord(buffer + 4, stamp);
+}
+
+void SntpServer::writeWord(uint8_t *buffer, uint32_t value){
+    buffer[0] = value >> 24;
+    buffer[1] = value >> 16;
+    buffer[2] = value >> 8;
+    buffer[3] = value;
+}
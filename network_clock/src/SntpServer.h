@@ -0,0 +1,78 @@
+#ifndef SNTPSERVER_H
+#define SNTPSERVER_H
+
+#include <Arduino.h>
+#include <SoftClock.h>
+
+extern "C" {
+#include <lwip/udp.h>
+#include <lwip/pbuf.h>
+}
+
+#define SNTP_PORT 123
+#define SNTP_PACKET_SIZE 48
+#define SNTP_PRECISION -20 //Clock is read with microsecond resolution
+#define SNTP_PRECISION_SHORT 1 //2^SNTP_PRECISION in NTP short format, rounded up
+#define SNTP_DISPERSION_RATE 15 //ppm, added to root dispersion while running free
+
+#define RATE_CLIENTS 8 //Clients tracked for rate limiting
+#define RATE_BURST 8 //Requests a client may send at once
+#define RATE_REFILL 250 //ms for a client to earn another request
+
+typedef struct Rate_Client_t {
+  uint32_t address;
+  uint32_t lastMillis;
+  uint8_t tokens;
+}Rate_Client;
+
+/*
+ * Answers SNTP requests from the LAN with our disciplined clock.
+ * Works on a raw lwIP socket, requests are answered inside the
+ * receive callback so both timestamps are taken next to the socket
+ * and the loop never sees the packets.
+ */
+class SntpServer{
+public:
+    SntpServer(SoftClock &clock);
+    bool begin();
+    void stop();
+    void setReference(uint8_t stratum, uint32_t refId, uint32_t rootDelay, uint32_t rootDispersion, uint32_t delay, uint32_t error);
+    void sample();
+
+    uint32_t getRequests();
+    uint32_t getReplies();
+    uint32_t getLimited();
+    uint32_t getRate();
+    uint32_t getRootDelay();
+    uint32_t getRootDispersion();
+
+private:
+    static void onPacket(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port);
+    void handle(struct pbuf *p, const ip_addr_t *addr, uint16_t port, uint64_t received);
+    bool allow(uint32_t address);
+    void refill(Rate_Client &client, uint32_t now);
+    static uint32_t toShort(uint32_t micros);
+    static uint32_t addShort(uint32_t a, uint32_t b);
+    static void writeStamp(uint8_t *buffer, uint64_t stamp);
+    static void writeWord(uint8_t *buffer, uint32_t value);
+
+    SoftClock &_clock;
+    struct udp_pcb *_pcb = nullptr;
+
+    //Fields that only change on sync are kept ready in here
+    uint8_t _reply[SNTP_PACKET_SIZE];
+    uint32_t _rootDispersion = 0;
+    uint64_t _referenceMicros = 0;
+    bool _hasReference = false;
+
+    Rate_Client _clients[RATE_CLIENTS];
+    Rate_Client _shared; //Bucket of new clients while every slot is busy
+
+    uint32_t _requests = 0;
+    uint32_t _replies = 0;
+    uint32_t _limited = 0;
+    uint32_t _lastReplies = 0;
+    uint32_t _rate = 0;
+};
+
+#endif
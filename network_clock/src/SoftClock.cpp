@@ -0,0 +1,84 @@
+#include "SoftClock.h"
+
+/*
+ * Starts the clock from given time without touching learned drift.
+ */
+void SoftClock::begin(uint32_t epoch){
+    _base = (uint64_t)epoch * 1000000ULL;
+    _localBase = micros64();
+    _synced = false;
+}
+
+/*
+ * Sets the clock to a reference time. If the last reference is far
+ * enough in the past the error between them updates the drift.
+ */
+void SoftClock::adjust(uint32_t epoch, uint32_t micro){
+    uint64_t target = (uint64_t)epoch * 1000000ULL + micro;
+    uint64_t local = micros64();
+    uint64_t span = local - _localBase;
+
+    if(_synced && span >= DRIFT_MIN_SPAN){
+        int64_t error = (int64_t)(target - (_base + elapsed()));
+        int32_t measured = error * 1000000LL / (int64_t)span;
+        //Only take half of it, single measurements are noisy
+        _drift = constrain(_drift + measured / 2, -MAX_DRIFT, MAX_DRIFT);
+    }
+
+    _base = target;
+    _localBase = local;
+    _synced = true;
+}
+
+uint32_t SoftClock::now(){
+    return nowMicros() / 1000000ULL;
+}
+
+/*
+ * Microseconds since unix epoch.
+ */
+uint64_t SoftClock::nowMicros(){
+    return _base + elapsed();
+}
+
+/*
+ * NTP timestamp, seconds since 1900 in the upper and fraction in the lower 32 bits.
+ */
+uint64_t SoftClock::nowNtp(){
+    return toNtp(nowMicros());
+}
+
+uint64_t SoftClock::toNtp(uint64_t micros){
+    uint32_t seconds = micros / 1000000ULL;
+    uint32_t rest = micros - (uint64_t)seconds * 1000000ULL;
+    //2^32 / 10^6 in Q16, avoids a second 64 bit division
+    uint32_t fraction = ((uint64_t)rest * 281474977ULL) >> 16;
+    return (uint64_t)(seconds + NTP_UNIX_OFFSET) << 32 | fraction;
+}
+
+/*
+ * Difference of two NTP timestamps, 32.32 fixed point, in microseconds.
+ */
+int64_t SoftClock::toMicros(int64_t ntpDelta){
+    return (ntpDelta >> 32) * 1000000LL + ((ntpDelta & 0xFFFFFFFFLL) * 1000000LL >> 32);
+}
+
+bool SoftClock::isSynced(){
+    return _synced;
+}
+
+int32_t SoftClock::getDrift(){
+    return _drift;
+}
+
+void SoftClock::setDrift(int32_t drift){
+    _drift = constrain(drift, -MAX_DRIFT, MAX_DRIFT);
+}
+
+/*
+ * Local time passed since the last reference, drift corrected.
+ */
+uint64_t SoftClock::elapsed(){
+    int64_t span = micros64() - _localBase;
+    return span + span * _drift / 1000000LL;
+}
@@ -0,0 +1,39 @@
+#ifndef SOFTCLOCK_H
+#define SOFTCLOCK_H
+
+#include <Arduino.h>
+
+#define MAX_DRIFT 500 //ppm, crystals are well within this
+#define DRIFT_MIN_SPAN 3600000000ULL //us between syncs before drift is estimated
+#define NTP_UNIX_OFFSET 2208988800UL //Seconds from 1900 to 1970
+
+/*
+ * Software clock running on the microsecond counter.
+ * Every adjust() compares the prediction with the real time and
+ * learns how fast the local oscillator runs, so the clock stays
+ * close between syncs.
+ */
+class SoftClock{
+public:
+    void begin(uint32_t epoch);
+    void adjust(uint32_t epoch, uint32_t micro = 0);
+    uint32_t now();
+    uint64_t nowMicros();
+    uint64_t nowNtp();
+    static uint64_t toNtp(uint64_t micros);
+    static int64_t toMicros(int64_t ntpDelta);
+
+    bool isSynced();
+    int32_t getDrift();
+    void setDrift(int32_t drift);
+
+private:
+    uint64_t elapsed();
+
+    uint64_t _base = 0; //us since epoch at _localBase
+    uint64_t _localBase = 0;
+    int32_t _drift = 0; //ppm
+    bool _synced = false;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "StallMonitor.h"
+
+StallMonitor *StallMonitor::_instance = nullptr;
+
+static const char *const phaseNames[STALL_PHASES] = {
+    "http", "mdns", "connection", "fleet", "task", "alarms", "tasks", "buttons", "frames", "log"
+};
+
+//Default budgets in ms. Handlers touch flash, so http gets the most room.
+static const uint16_t phaseBudgets[STALL_PHASES] = {
+    300, 20, 100, 20, STALL_TASK_BUDGET, 20, STALL_TASK_BUDGET, 10, 30, 10
+};
+
+/*
+ * Checks what the last boot left behind and takes over timer1.
+ */
+void StallMonitor::begin(){
+    _instance = this;
+    memcpy(_budgets, phaseBudgets, sizeof(_budgets));
+    memset(_maxElapsed, 0, sizeof(_maxElapsed));
+
+    volatile Stall_Cache &last = cache();
+    if(last.magic != STALL_CACHE_MAGIC || last.phase >= STALL_PHASES || last.samples > STALL_SAMPLES){
+        //Power on, RTC memory holds noise
+        reset();
+    } else if(last.elapsed == STALL_UNFINISHED){
+        //Phase never left, whatever reset us cut it short
+        last.elapsed = STALL_RESET;
+        last.resets++;
+        LOG_ERROR("Reset inside %s phase, task %x, reason %u",
+            getName(last.phase), last.task, system_get_rst_info()->reason);
+    }
+
+    timer1_isr_init();
+    timer1_attachInterrupt(onTimer);
+    timer1_enable(TIM_DIV256, TIM_EDGE, TIM_SINGLE);
+}
+
+void StallMonitor::setBudget(uint8_t phase, uint16_t budget){
+    if(phase < STALL_PHASES && budget > 0){
+        _budgets[phase] = budget;
+    }
+}
+
+uint16_t StallMonitor::getBudget(uint8_t phase){
+    return phase < STALL_PHASES ? _budgets[phase] : 0;
+}
+
+/*
+ * Clears counters that survive reboots.
+ */
+void StallMonitor::reset(){
+    volatile Stall_Cache &last = cache();
+    for(size_t i = 0; i < sizeof(Stall_Cache) / 4; i++){
+        ((volatile uint32_t*)&last)[i] = 0;
+    }
+    last.magic = STALL_CACHE_MAGIC;
+    memset(_maxElapsed, 0, sizeof(_maxElapsed));
+}
+
+void StallMonitor::enter(uint8_t phase, uint32_t task, uint16_t budget){
+    if(_depth >= STALL_DEPTH){
+        _depth++;
+        return;
+    }
+    volatile Stall_Frame &frame = _frames[_depth];
+    frame.phase = phase;
+    frame.task = task;
+    frame.budget = budget > 0 ? budget : _budgets[phase];
+    frame.samples = 0;
+    frame.start = millis();
+    //Frame is complete before the timer can see it
+    _depth++;
+    timer1_write(toTicks(frame.budget));
+}
+
+void StallMonitor::leave(){
+    if(_depth == 0){
+        return;
+    }
+    if(_depth > STALL_DEPTH){
+        _depth--;
+        return;
+    }
+    Stall_Frame frame;
+    memcpy(&frame, (const void*)&_frames[_depth - 1], sizeof(frame));
+    _depth--;
+    if(_depth > 0){
+        arm((const Stall_Frame&)_frames[_depth - 1]);
+    }
+
+    uint32_t elapsed = millis() - frame.start;
+    if(elapsed > _maxElapsed[frame.phase]){
+        _maxElapsed[frame.phase] = elapsed;
+    }
+    if(elapsed <= frame.budget){
+        return;
+    }
+
+    volatile Stall_Cache &last = cache();
+    if(frame.samples == 0){
+        //Timer didn't get to run, interrupts were off or it is a near miss
+        last.phase = frame.phase;
+        last.task = frame.task;
+        last.uptime = frame.start / 1000;
+        last.samples = 0;
+    }
+    last.elapsed = elapsed;
+    last.counts[frame.phase]++;
+    last.overruns++;
+    LOG_WARN("%s phase took %u ms of %u, task %x", getName(frame.phase), elapsed, frame.budget, frame.task);
+
+#if STALL_ASSERT
+    if(frame.phase == STALL_TASK || frame.phase == STALL_TASKS){
+        logger.flush();
+        panic();
+    }
+#endif
+}
+
+uint32_t StallMonitor::getOverruns(){
+    return cache().overruns;
+}
+
+uint32_t StallMonitor::getResets(){
+    return cache().resets;
+}
+
+uint32_t StallMonitor::getCount(uint8_t phase){
+    return phase < STALL_PHASES ? cache().counts[phase] : 0;
+}
+
+/*
+ * Longest time the phase took since boot or reset().
+ */
+uint32_t StallMonitor::getMaxElapsed(uint8_t phase){
+    return phase < STALL_PHASES ? _maxElapsed[phase] : 0;
+}
+
+const volatile Stall_Cache& StallMonitor::getLast(){
+    return cache();
+}
+
+const char* StallMonitor::getName(uint8_t phase){
+    return phase < STALL_PHASES ? phaseNames[phase] : "?";
+}
+
+/*
+ * Times the outer phase again for what is left of its budget. One that
+ * is already over is sampled right away, unless it has all its samples.
+ */
+void StallMonitor::arm(const Stall_Frame &frame){
+    if(frame.samples >= STALL_SAMPLES){
+        return;
+    }
+    uint32_t elapsed = millis() - frame.start;
+    if(frame.samples > 0){
+        timer1_write(toTicks(STALL_SAMPLE_INTERVAL));
+    } else {
+        timer1_write(toTicks(elapsed < frame.budget ? frame.budget - elapsed : 1));
+    }
+}
+
+/*
+ * Innermost phase is over budget. EPC1 holds where the loop was interrupted.
+ */
+void IRAM_ATTR StallMonitor::onTimer(){
+    StallMonitor *monitor = _instance;
+    if(monitor == nullptr || monitor->_depth == 0 || monitor->_depth > STALL_DEPTH){
+        return;
+    }
+    volatile Stall_Frame &frame = monitor->_frames[monitor->_depth - 1];
+    if(frame.samples >= STALL_SAMPLES){
+        return;
+    }
+    uint32_t pc = 0;
+#ifdef __XTENSA__
+    asm volatile("rsr %0, epc1" : "=r"(pc));
+#endif
+
+    volatile Stall_Cache &last = cache();
+    if(frame.samples == 0){
+        last.phase = frame.phase;
+        last.task = frame.task;
+        last.elapsed = STALL_UNFINISHED;
+        last.uptime = frame.start / 1000;
+    }
+    last.pc[frame.samples] = pc;
+    frame.samples++;
+    last.samples = frame.samples;
+    if(frame.samples < STALL_SAMPLES){
+        timer1_write(toTicks(STALL_SAMPLE_INTERVAL));
+    }
+}
+
+volatile Stall_Cache& IRAM_ATTR StallMonitor::cache(){
+    return *(volatile Stall_Cache*)(RTC_USER_MEM + STALL_CACHE_OFFSET);
+}
+
+/*
+ * timer1 counts at 80MHz / 256.
+ */
+uint32_t IRAM_ATTR StallMonitor::toTicks(uint32_t ms){
+    uint32_t ticks = ms * 3125 / 10;
+    return ticks > STALL_MAX_TICKS ? STALL_MAX_TICKS : ticks;
+}
@@ -0,0 +1,118 @@
+#ifndef STALLMONITOR_H
+#define STALLMONITOR_H
+
+#include <Arduino.h>
+#include <Logger.h>
+#include <FastBoot.h>
+#include <user_interface.h>
+
+#define STALL_CACHE_MAGIC 0x53544C31 //"STL1"
+//In 4 byte blocks of RTC user memory, right after the boot cache. Both stay
+//past RTC_USER_RESERVED, a leave() after Update.end() must not touch eboot's command.
+#define STALL_CACHE_OFFSET (BOOT_CACHE_OFFSET + sizeof(Boot_Cache) / 4)
+
+#define STALL_SAMPLES 4 //PCs taken from an overrunning phase
+#define STALL_SAMPLE_INTERVAL 100 //ms between PC samples once a phase is over budget
+#define STALL_UNFINISHED 0xFFFFFFFF //Elapsed of a stall still going on
+#define STALL_RESET 0xFFFFFFFE //Elapsed of a stall the unit was reset in
+#define STALL_MAX_TICKS 0x7FFFFF //timer1 counter is 23 bits
+#define STALL_DEPTH 4 //Phases that may run inside one another, deeper ones aren't timed
+
+//Tasks say how long they may take when they are added to the scheduler
+#define STALL_TASK_BUDGET 50 //ms
+
+//Debug builds stop on the first overrun of our own tasks so it is found before
+//it ships, the other phases wait on the network and overrun now and then anyway
+#ifndef STALL_ASSERT
+#define STALL_ASSERT (LOG_LEVEL >= LOG_LEVEL_DEBUG)
+#endif
+
+enum StallPhase {
+  STALL_HTTP,
+  STALL_MDNS,
+  STALL_CONNECTION,
+  STALL_FLEET,
+  STALL_TASK, //Scheduler task, task is its function
+  STALL_ALARMS,
+  STALL_TASKS, //Protothreads
+  STALL_BUTTONS,
+  STALL_FRAMES,
+  STALL_LOG,
+  STALL_PHASES
+};
+
+/*
+ * Counters and the last stall, kept in RTC user memory so they survive
+ * the watchdog resets they lead up to. Words only, the timer interrupt
+ * writes it directly.
+ */
+typedef struct Stall_Cache_t {
+  uint32_t magic;
+  uint32_t overruns;
+  uint32_t resets; //Resets that happened inside a stall
+  uint32_t counts[STALL_PHASES];
+  uint32_t phase;
+  uint32_t task;
+  uint32_t elapsed; //ms, or STALL_UNFINISHED / STALL_RESET if the phase never returned
+  uint32_t uptime; //s since boot when the phase started
+  uint32_t samples;
+  uint32_t pc[STALL_SAMPLES];
+}Stall_Cache;
+
+static_assert(STALL_CACHE_OFFSET >= RTC_USER_RESERVED, "Stall cache would overwrite the eboot command");
+static_assert(STALL_CACHE_OFFSET * 4 >= BOOT_CACHE_OFFSET * 4 + sizeof(Boot_Cache), "Stall cache would overwrite the boot cache");
+static_assert(STALL_CACHE_OFFSET * 4 + sizeof(Stall_Cache) <= RTC_USER_BLOCKS * 4, "RTC user memory is 512 bytes");
+
+/*
+ * A phase being timed. Phases nest, the update upload runs display ticks
+ * inside the http phase, the outer one is timed again once the inner leaves.
+ */
+typedef struct Stall_Frame_t {
+  uint8_t phase;
+  uint8_t samples; //0 while within budget
+  uint16_t budget;
+  uint32_t task;
+  uint32_t start;
+}Stall_Frame;
+
+/*
+ * Watches the cooperative loop for phases that run over their budget.
+ * Every phase arms timer1 with its budget on entry. If it fires before
+ * the phase leaves, the interrupt samples the interrupted PC a few times,
+ * which shows where the phase is stuck even if the watchdog ends it.
+ */
+class StallMonitor{
+public:
+    void begin();
+    void setBudget(uint8_t phase, uint16_t budget);
+    uint16_t getBudget(uint8_t phase);
+    void reset();
+
+    /*
+     * Called around every phase of loop(), budget 0 uses the phase's own.
+     */
+    void enter(uint8_t phase, uint32_t task = 0, uint16_t budget = 0);
+    void leave();
+
+    uint32_t getOverruns();
+    uint32_t getResets();
+    uint32_t getCount(uint8_t phase);
+    uint32_t getMaxElapsed(uint8_t phase);
+    const volatile Stall_Cache& getLast();
+    static const char* getName(uint8_t phase);
+
+private:
+    static void IRAM_ATTR onTimer();
+    static volatile Stall_Cache& IRAM_ATTR cache();
+    static uint32_t IRAM_ATTR toTicks(uint32_t ms);
+    void arm(const Stall_Frame &frame);
+
+    static StallMonitor *_instance;
+
+    uint16_t _budgets[STALL_PHASES];
+    uint32_t _maxElapsed[STALL_PHASES];
+    volatile Stall_Frame _frames[STALL_DEPTH];
+    volatile uint8_t _depth = 0; //May go past STALL_DEPTH, those aren't timed
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "SyncHistory.h"
+
+/*
+ * Reads archive position from flash.
+ */
+void SyncHistory::begin(){
+    _current.count = 0;
+    SPIFFS.begin();
+    File file = SPIFFS.open(SYNC_ARCHIVE_FILE, "r");
+    uint16_t header[2];
+    if(file && file.read((uint8_t*)header, sizeof(header)) == sizeof(header) &&
+       header[0] < SYNC_ARCHIVE_RECORDS && header[1] <= SYNC_ARCHIVE_RECORDS){
+        _archiveNext = header[0];
+        _archiveCount = header[1];
+    }
+    file.close();
+    SPIFFS.end();
+}
+
+/*
+ * Keeps a sync. drift is the oscillator correction in use after it.
+ */
+void SyncHistory::add(const Sync_Record &record, int32_t drift){
+    _ring[_head] = record;
+    _head = (_head + 1) % SYNC_RING;
+    if(_count < SYNC_RING){
+        _count++;
+    }
+
+    //First sync after boot measures the time spent off, not the clock
+    if(!(record.flags & SYNC_FIRST)){
+        summarise(record);
+        _current.drift = drift;
+    }
+}
+
+/*
+ * Syncs in RAM, index 0 is the oldest.
+ */
+uint8_t SyncHistory::getCount(){
+    return _count;
+}
+
+const Sync_Record& SyncHistory::get(uint8_t index){
+    return _ring[(_head + SYNC_RING - _count + index) % SYNC_RING];
+}
+
+uint16_t SyncHistory::getSummaryCount(){
+    return _archiveCount;
+}
+
+/*
+ * Passes archived summaries to reader, oldest first.
+ */
+bool SyncHistory::readSummaries(void (*reader)(const Sync_Summary &summary)){
+    SPIFFS.begin();
+    File file = SPIFFS.open(SYNC_ARCHIVE_FILE, "r");
+    if(!file){
+        SPIFFS.end();
+        return false;
+    }
+    Sync_Summary summary;
+    for(uint16_t i = 0; i < _archiveCount; i++){
+        uint16_t index = (_archiveNext + SYNC_ARCHIVE_RECORDS - _archiveCount + i) % SYNC_ARCHIVE_RECORDS;
+        if(!file.seek(4 + index * sizeof(Sync_Summary)) ||
+           file.read((uint8_t*)&summary, sizeof(summary)) != sizeof(summary)){
+            break;
+        }
+        reader(summary);
+    }
+    file.close();
+    SPIFFS.end();
+    return true;
+}
+
+void SyncHistory::summarise(const Sync_Record &record){
+    if(_current.count > 0 && record.time - _current.time >= SYNC_ARCHIVE_PERIOD){
+        archive();
+    }
+    if(_current.count == 0){
+        _current.time = record.time - record.time % SYNC_ARCHIVE_PERIOD;
+        _current.offsetMin = record.offset;
+        _current.offsetMax = record.offset;
+        _offsetSum = 0;
+        _delaySum = 0;
+        _rssiSum = 0;
+    }
+    if(record.offset < _current.offsetMin){
+        _current.offsetMin = record.offset;
+    }
+    if(record.offset > _current.offsetMax){
+        _current.offsetMax = record.offset;
+    }
+    _offsetSum += record.offset;
+    _delaySum += record.delay;
+    _rssiSum += record.rssi;
+    _current.count++;
+
+    if(_current.count == 255){
+        //Counter is full, period ends early
+        archive();
+    }
+}
+
+/*
+ * Writes the finished period over the oldest archive record.
+ */
+void SyncHistory::archive(){
+    _current.offsetMean = _offsetSum / _current.count;
+    _current.delayMean = _delaySum / _current.count;
+    _current.rssiMean = _rssiSum / _current.count;
+
+    SPIFFS.begin();
+    bool exists = SPIFFS.exists(SYNC_ARCHIVE_FILE);
+    File file = SPIFFS.open(SYNC_ARCHIVE_FILE, exists ? "r+" : "w+");
+    uint16_t header[2] = {0, 0};
+    if(file && !exists){
+        //Records are only ever written at the end or over old ones
+        _archiveNext = 0;
+        _archiveCount = 0;
+        file.write((const uint8_t*)header, sizeof(header));
+    }
+    if(file && file.seek(4 + _archiveNext * sizeof(Sync_Summary))){
+        file.write((const uint8_t*)&_current, sizeof(_current));
+        _archiveNext = (_archiveNext + 1) % SYNC_ARCHIVE_RECORDS;
+        if(_archiveCount < SYNC_ARCHIVE_RECORDS){
+            _archiveCount++;
+        }
+        header[0] = _archiveNext;
+        header[1] = _archiveCount;
+        file.seek(0);
+        file.write((const uint8_t*)header, sizeof(header));
+    }
+    file.close();
+    SPIFFS.end();
+    _current.count = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef SYNCHISTORY_H
+#define SYNCHISTORY_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define SYNC_RING 32 //Latest syncs kept in RAM
+#define SYNC_ARCHIVE_RECORDS 90 //Days kept in flash
+#define SYNC_ARCHIVE_PERIOD 86400UL //s summarised into one archive record
+#define SYNC_ARCHIVE_FILE "/history.bin"
+
+#define SYNC_FIRST B00000001 //First sync since boot
+
+/*
+ * One upstream sync. Sent as is in binary exports, little endian.
+ */
+typedef struct __attribute__((packed)) Sync_Record_t {
+  uint32_t time; //Epoch right after the sync
+  int32_t offset; //us the clock was off, clamped to 32 bits
+  uint32_t delay; //us round trip
+  uint32_t server; //IPv4 address, network order
+  uint8_t poll; //log2 of seconds since previous sync
+  int8_t rssi;
+  uint8_t stratum;
+  uint8_t flags;
+}Sync_Record;
+
+/*
+ * Syncs of one archive period boiled down.
+ */
+typedef struct __attribute__((packed)) Sync_Summary_t {
+  uint32_t time; //Start of period
+  int32_t offsetMin;
+  int32_t offsetMax;
+  int32_t offsetMean;
+  uint32_t delayMean;
+  int16_t drift; //ppm at the end of period
+  uint8_t count;
+  int8_t rssiMean;
+}Sync_Summary;
+
+static_assert(sizeof(Sync_Record) == 20 && sizeof(Sync_Summary) == 24, "Export formats are fixed");
+
+/*
+ * Sync history for telling how a unit keeps time.
+ * Recent syncs stay as they are in a RAM ring, every period is also
+ * summarised into a fixed size ring file, so both RAM and flash use are
+ * known at compile time and flash is written once a period.
+ */
+class SyncHistory{
+public:
+    void begin();
+    void add(const Sync_Record &record, int32_t drift);
+
+    uint8_t getCount();
+    const Sync_Record& get(uint8_t index);
+    uint16_t getSummaryCount();
+    bool readSummaries(void (*reader)(const Sync_Summary &summary));
+
+private:
+    void summarise(const Sync_Record &record);
+    void archive();
+
+    Sync_Record _ring[SYNC_RING];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+
+    //Period being summarised
+    Sync_Summary _current;
+    int64_t _offsetSum = 0;
+    uint32_t _delaySum = 0;
+    int16_t _rssiSum = 0;
+
+    //Archive file header
+    uint16_t _archiveNext = 0;
+    uint16_t _archiveCount = 0;
+};
+
+#endif
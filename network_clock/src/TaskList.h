@@ -0,0 +1,81 @@
+#ifndef TASKLIST_H
+#define TASKLIST_H
+
+#include <Arduino.h>
+
+typedef struct Node {
+  uint32_t time = 0; //Epoch the task runs next
+  uint32_t (*function)(void);
+  uint16_t budget; //ms the task may block the loop
+  bool isActive = true;
+  struct Node *next = nullptr;
+}Node;
+
+/*
+ * Singly linked list of the timed tasks runInterrupts() walks once a
+ * second. index is the walk, a task may be removed while it is the
+ * current one and advance() still carries on with the one after it.
+ * Nodes are owned by the caller, the list only links them.
+ */
+struct List {
+  struct Node *head = nullptr;
+  struct Node *tail = nullptr;
+  uint8_t length = 0;
+  struct Node *index = nullptr;
+
+  void reset(){
+    index = nullptr;
+  }
+
+  struct Node* getCurrent(){
+    return index;
+  }
+
+  bool advance(){
+    index = index == nullptr ? head : index->next;
+    return index != nullptr;
+  }
+
+  void append(struct Node *n){
+    n->next = nullptr;
+    if(head == nullptr){
+      head = n;
+    } else {
+      tail->next = n;
+    }
+    tail = n;
+    length++;
+  }
+
+  /*
+   * Unlinks n, false if it isn't in the list. Removing the current node
+   * steps the walk back to its predecessor, or to the start for the head.
+   */
+  bool remove(struct Node *n){
+    struct Node *prev = nullptr;
+    struct Node *temp = head;
+    while(temp != nullptr && temp != n){
+      prev = temp;
+      temp = temp->next;
+    }
+    if(temp == nullptr){
+      return false;
+    }
+    if(prev == nullptr){
+      head = n->next;
+    } else {
+      prev->next = n->next;
+    }
+    if(tail == n){
+      tail = prev;
+    }
+    if(index == n){
+      index = prev;
+    }
+    n->next = nullptr;
+    length--;
+    return true;
+  }
+};
+
+#endif
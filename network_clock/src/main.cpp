@@ -2,9 +2,23 @@
 
 void setup() {
   Serial.begin(115200);
-  delay(500);
   //Init Peripherals. Buttons, displays etc
   initPeripherals();
+  stall.begin();
+  metrics.reset();
+
+  //After a warm reset put cached time on the display before anything slow happens
+  if(fastBoot.load() && fastBoot.hasTime()){
+    softClock.begin(fastBoot.getTime());
+    softClock.setDrift(fastBoot.getDrift());
+    deviceInfo.timeOffset = fastBoot.getTimeOffset();
+    deviceInfo.brightness = fastBoot.getBrightness();
+    sc.setBrightness(deviceInfo.brightness);
+    updateDisplayBuffer();
+    compositor.clear();
+    updateDisplay();
+    fastBoot.markDisplay();
+  }
 
 
   uint8_t bootState = checkBootState();
@@ -35,26 +49,22 @@ void setup() {
    */
   //Load credentials from flash "/creds.txt" file
   loadCredentials();
-  delay(500);
   sc.setBrightness(deviceInfo.brightness);
   switch (bootState)
   {
   case 0:
     initNetwork();
-    //Get Network Clock
-    milliClock.begin(DateTime(0));
-    initInterrupts();
+    connection.connect();
     break;
 
   case 1:
-    getWPSConnection();
-    if(WiFi.isConnected()){
-      ESP.restart();
-    }
+    initNetwork();
+    connection.startWPS();
     break;
 
   case 2:
-    WiFi.softAP(deviceInfo.name, NULL);
+    initNetwork();
+    connection.startAccessPoint();
     break;
 
   case 3:
@@ -63,19 +73,30 @@ void setup() {
     break;
   }
 
+  //Clock runs in every mode, network only corrects it
+  if(!fastBoot.hasTime()){
+    softClock.begin(0);
+  }
+  initInterrupts();
+
+  history.begin();
+  alarms.setCallback(onAlarm);
+  alarms.begin(softClock.now(), deviceInfo.timeOffset);
+
   initServer();
+
+  LOG_INFO("Boot to display: %u ms, boot to connected: %u ms",
+    fastBoot.getDisplayMillis(), fastBoot.getConnectedMillis());
 }
 
 /*
  * Inits peripherals like buttons leds etc to their initial state
  */
 void initPeripherals(){
-  wpsButton.attach(WPS_BUTTON_PIN, INPUT_PULLUP);
-  wpsButton.interval(5);
-  refreshButton.attach(REFRESH_BUTTON_PIN, INPUT_PULLUP);
-  refreshButton.interval(5);
-  functionButton.attach(FUNCTION_BUTTON_PIN, INPUT_PULLUP);
-  functionButton.interval(5);
+  wpsButton = buttons.attach(WPS_BUTTON_PIN);
+  refreshButton = buttons.attach(REFRESH_BUTTON_PIN);
+  functionButton = buttons.attach(FUNCTION_BUTTON_PIN, true);
+  buttons.setCallback(onButtonEvent);
 
   pinMode(WPS_LED, OUTPUT);
   digitalWrite(WPS_LED, LOW);
@@ -88,15 +109,14 @@ void initPeripherals(){
   sc.setBrightness(deviceInfo.brightness);
   updateDisplay();
 
-  Serial.println("Peripherals initiated");
+  LOG_INFO("Peripherals initiated");
 }
 
 
 void initServer(){
-  server.on("/", HTTP_POST, handleApiInput);
-  server.on("/api", HTTP_GET, handleApiExchange);
-  server.on("/api", HTTP_POST, handleApiInput);
-  server.on("/login", HTTP_POST, handleLogin);
+  //Every route is in routeList, see main.h
+  server.addHandler(&routeHandler);
+  routeHandler.setCallback(onRouteServed);
   server.onNotFound(handleNotFound);
 
 
@@ -110,74 +130,119 @@ void initServer(){
 
   //init dns system
   MDNS.begin("clock");
-  Serial.print("Open http://");
-  Serial.print("clock");
-  Serial.println(".local/to see the file browser");
+  LOG_INFO("Open http://%s.local/ to see the file browser", "clock");
 }
 
 /*
- * Creates a network connection.
+ * Prepares networking. Connection itself is made by the connection manager
+ * in the background, setup doesn't wait for it.
  */
 void initNetwork(){
-  //If we have connected to a network connect it again
-  bool niStored = deviceInfo.ssid != 0 && deviceInfo.psk != 0;
+  LOG_INFO("Network name: %s, Network password: %s", deviceInfo.ssid, redact(deviceInfo.psk));
+  connection.setCallback(onConnectionEvent);
+  fleet.setCallback(onFleetRole);
+  fleet.setSyncCallback(onFleetSync);
+  connection.begin(deviceInfo.ssid, deviceInfo.psk, deviceInfo.name);
 
-  WiFi.mode(WIFI_STA);
-
-  if(niStored){
-    Serial.printf("Network name: %s, Network password: %s", deviceInfo.ssid, deviceInfo.psk);
-    WiFi.begin(deviceInfo.ssid, deviceInfo.psk);
-    while(WiFi.status() != WL_CONNECTED){
-      delay(500);
-      Serial.print(".");
-    }
+  //Starting an UDP port for NTP connections.
+  if(ntpClient.begin(localPort)){
+    LOG_INFO("UDP started on port %u", localPort);
   } else {
-    //There is no preconfigured network.
-    getWPSConnection();
+    LOG_ERROR("NTP client could not bind");
   }
 
-  if(WiFi.isConnected()){ 
-    Serial.println("Connection established");
+  if(SNTP_SERVER && !sntpServer.begin()){
+    LOG_ERROR("SNTP server could not bind");
   }
-
-  Serial.print("IP: ");
-  Serial.println(WiFi.localIP());
-  
-  //Starting an UDP port for NTP connections.
-  Serial.println("Starting UDP");
-  udp.begin(localPort);
-  Serial.print("Local port: ");
-  Serial.println(udp.localPort());
-
-  Serial.println();
 }
 uint32_t prevSeconds = 0;
 bool isNetworkRequestActive = false;
-uint32_t networkMillis = 0;
-uint32_t buttonMillis = 0;
+uint32_t frameMillis = 0;
+bool framesActive = false;
+bool restartPending = false;
+bool alarmsSynced = false;
 
 void loop() {
+  uint32_t loopStart = micros();
+  stall.enter(STALL_HTTP);
   server.handleClient();
+  stall.leave();
+  stall.enter(STALL_MDNS);
   MDNS.update();
+  stall.leave();
+  stall.enter(STALL_CONNECTION);
+  connection.tick();
+  //Scanning would take the radio from a connection attempt, or from clients once joined
+  provisioner.tick(connection.getState() == STATE_AP_FALLBACK || connection.getState() == STATE_BACKOFF);
+  stall.leave();
+  stall.enter(STALL_FLEET);
+  fleet.tick();
+  stall.leave();
+
+  runInterrupts();
+  stall.enter(STALL_ALARMS);
+  if(!alarmsSynced && softClock.isSynced()){
+    //Fire times so far came from the guessed boot time
+    alarms.reschedule(softClock.now());
+    alarmsSynced = true;
+  }
+  alarms.tick(softClock.now());
+  stall.leave();
+
+  stall.enter(STALL_TASKS);
+  tasks.tick(millis());
+  stall.leave();
+
+  stall.enter(STALL_BUTTONS);
+  buttons.tick();
+  stall.leave();
+
+  stall.enter(STALL_FRAMES);
+  runFrames();
+  stall.leave();
+  stall.enter(STALL_LOG);
+  logger.tick();
+  stall.leave();
+
+  if(WiFi.isConnected()){
+    digitalWrite(CONN_LED, LOW);
+  }else{
+    digitalWrite(CONN_LED, HIGH);
+  }
+
+  metrics.record(METRIC_LOOP, micros() - loopStart);
+
+  if(restartPending){
+    //Response of the update request has been sent by now
+    delay(100);
+    logger.flush();
+    ESP.restart();
+  }
+}
 
-  uint32_t time = milliClock.now().unixtime();
+/*
+ * Runs due interrupts, once a second at most.
+ * Also called while long requests like updates hold the loop.
+ */
+void runInterrupts(){
+  uint32_t time = softClock.now();
   interruptList->reset();
-  if(time - prevSeconds >= 1 && !packetSent){
+  if(time - prevSeconds >= 1){
     prevSeconds = time;
+    //Display tick should be right at the start of the second, anything more is loop latency
+    metrics.record(METRIC_DISPLAY, softClock.nowMicros() % 1000000);
     while (interruptList->advance())
     {
       struct Node *temp = interruptList->getCurrent();
       if (time >= temp->time)
       { 
+        stall.enter(STALL_TASK, (uint32_t)(uintptr_t)temp->function, temp->budget);
         uint32_t ans = temp->function();
+        stall.leave();
         if (ans == 0)
         {
-          //We are calling remove interrupt which also uses advance and
-          //getCurrent functions. I relocate our pointer to previous one so our while
-          // will use advance to the right pointer
-          struct Node *t = temp->next;
+          //The walk steps back to the previous task, advance picks up after it
           removeInterrupt(temp);
-          interruptList->setIndex(t);
         }
         else
         {
@@ -186,47 +251,43 @@ void loop() {
       }
     }
   }
+}
 
-  if(packetSent){
-    if(millis() - networkMillis > 200){
-      getClock();
-      networkMillis = millis();
-    }
-  } 
-
-  if(millis() - buttonMillis >= 5){
-    wpsButton.update();
-    refreshButton.update();
-    functionButton.update();
-    if(wpsButton.rose()){
-      getWPSConnection();
-    }
-    if(refreshButton.rose()){
-      updateClock();
-    }
-    if(functionButton.rose()){
-      //TODO set offset
+/*
+ * Writes compositor frames on time and gives the display back to the clock
+ * when a message is over.
+ */
+void runFrames(){
+  if(millis() - frameMillis >= FRAME_INTERVAL){
+    bool active = renderFrame();
+    if(framesActive && !active){
+      //Message is over, give the display back to the clock
+      sc.setBrightness(deviceInfo.brightness);
+      updateDisplay();
     }
-    buttonMillis = millis();
-  }
-
-  if(WiFi.isConnected()){
-    digitalWrite(CONN_LED, LOW);
-  }else{
-    digitalWrite(CONN_LED, HIGH);
+    framesActive = active;
+    frameMillis = millis();
   }
 }
 
 void initInterrupts(){
   struct Node* temp = addInterrupt(updateDisplay);
-  temp->time = milliClock.now().unixtime() + 5;
+  temp->time = softClock.now() + 5;
 
   struct Node* temp1 = addInterrupt(updateDisplayBuffer);
-  temp1->time = milliClock.now().unixtime() + 5;
+  temp1->time = softClock.now() + 5;
 
 
   struct Node *temp2 = addInterrupt(updateClock);
-  temp2->time = milliClock.now().unixtime() + 5;
+  temp2->time = softClock.now() + 5;
+
+  struct Node *temp3 = addInterrupt(updateBootCache);
+  temp3->time = softClock.now() + BOOT_CACHE_INTERVAL;
+
+  if(SNTP_SERVER){
+    struct Node *temp4 = addInterrupt(updateSntpStats);
+    temp4->time = softClock.now() + 1;
+  }
 
   interruptList->reset();
 }
@@ -234,45 +295,19 @@ void initInterrupts(){
 /*
  * Adds and interrupt to the table.
  */
-struct Node* addInterrupt(uint32_t (*function) (void)){
-  struct Node* newNode = (struct Node*)malloc(sizeof(struct Node));
-
+struct Node* addInterrupt(uint32_t (*function) (void), uint16_t budget){
+  struct Node* newNode = new Node;
   newNode->function = function;
-  interruptList->reset();
-  if(interruptList->head ==nullptr){
-    //No interrupts registered
-    interruptList->head = newNode;
-    interruptList->tail = newNode;
-  } else {
-    interruptList->tail->next = newNode;
-    interruptList->tail = newNode;
-  }
+  newNode->budget = budget;
+  interruptList->append(newNode);
   return newNode;
 }
 
 bool removeInterrupt(struct Node* n){
-  struct Node* prev = nullptr;
-  struct Node* temp = nullptr;
-  interruptList->reset();
-  while(interruptList->advance()){
-    temp = interruptList->getCurrent();
-    if(temp != n){
-      prev = temp;
-      temp = temp->next;
-    }
-    if(temp == interruptList->tail && n != interruptList->tail){
-      return false;
-      // We are at tail, and couldn't find provided node
-    }else {
-      interruptList->tail = prev;
-      //We remove tail.
-    }
-  }
-  if(prev != nullptr && temp != nullptr){
-    prev->next = temp->next;
+  if(!interruptList->remove(n)){
     return false;
   }
-  free(n);
+  delete n;
   return true;
 }
 
@@ -283,79 +318,32 @@ bool loadCredentials(bool reset){
   SPIFFS.begin();
   File credFile;
   if(reset){
-    Serial.println("Reloading credentials.");
+    LOG_INFO("Reloading credentials.");
     credFile = SPIFFS.open("/creds_master.txt", "r");
   } else {
-    Serial.println("Reading credentials.");
+    LOG_INFO("Reading credentials.");
     credFile = SPIFFS.open("/creds.txt", "r");
   }
 
-  if(credFile){
-    Serial.println("No file found");
+  if(!credFile){
+    LOG_WARN("No file found");
   }
 
-  char buffer[64];
-  int index = 0;
-  while (credFile.available()) {
-    int l = credFile.readBytesUntil(',', buffer, sizeof(buffer));
-    buffer[l] = '\0';
-    Serial.println(buffer);
-    switch (index)
-    {
-    case 0:{
-      memcpy(deviceInfo.ssid, buffer, l);
-      break;
-    }
-    case 1:
-    {
-      memcpy(deviceInfo.psk, buffer, l);
-      break;
-    }
-    case 2:
-    {
-      memcpy(deviceInfo.name , buffer, l);
-      break;
-    }
-    case 3:
-    {
-      memcpy(deviceInfo.loginName, buffer, l);
-      break;
-      break;
-    }
-    case 4:
-    {
-      memcpy(deviceInfo.password, buffer, l);
-      break;
-    }
-    case 5:
-    {
-      String s = buffer;
-      uint8_t b = s.toInt();
-      s.~String();
-      deviceInfo.brightness = b;
-      break;
-    }
-    case 6:
-    {
-      String s = buffer;
-      uint16_t b = s.toInt();
-      s.~String();
-      deviceInfo.timeOffset = b;
-      break;
-    }
-    }
-
-    index++;
-  }
+  //Fields are bounded, so the whole file fits in one buffer
+  char buffer[CREDENTIALS_SIZE];
+  size_t length = credFile ? credFile.readBytes(buffer, sizeof(buffer) - 1) : 0;
+  buffer[length] = '\0';
+  DeviceConfig::parseCsv(buffer, deviceInfo);
   credFile.close();
   SPIFFS.end();
   if(reset){
     saveCredentials();
     delay(500);
-    Serial.println("Credentials restore");
+    LOG_INFO("Credentials restore");
+    logger.flush();
     ESP.restart();
   }
-  Serial.println("Credentials loaded");
+  LOG_INFO("Credentials loaded for %s", deviceInfo.name);
   return true;
 }
 
@@ -365,105 +353,175 @@ bool loadCredentials(bool reset){
 void saveCredentials(){
   SPIFFS.begin();
   File creds = SPIFFS.open("/creds.txt", "w");
-
-  creds.print(deviceInfo.ssid);
-  creds.print(',');
-  creds.print(deviceInfo.psk);
-  creds.print(',');
-  creds.print(deviceInfo.name);
-  creds.print(',');
-  creds.print(deviceInfo.loginName);
-  creds.print(',');
-  creds.print(deviceInfo.password);
-  creds.print(',');
-  creds.print(deviceInfo.brightness);
-  creds.print(',');
-  creds.print(deviceInfo.timeOffset);
-  creds.print(',');
-
+  if(!creds){
+    LOG_ERROR("Credentials could not be saved");
+    SPIFFS.end();
+    return;
+  }
+  DeviceConfig::printCsv(creds, deviceInfo);
   creds.close();
   SPIFFS.end();
-
-  SPIFFS.end();
-  Serial.println("Credentials saved.");
+  LOG_INFO("Credentials saved.");
 }
 
 /*
- * Connects to a open WPS connection
- * TODO: More testing required
+ * Reacts to connection manager events. Runs from loop(), not from the SDK.
  */
-void getWPSConnection(){
-    Serial.println("Waiting WPS connection");
-    displayBuffer[0] = B00111110;
-    displayBuffer[1] = B01100111;
-    displayBuffer[2] = B01011011;
-    displayBuffer[3] = B00000000;
+void onConnectionEvent(ConnectionEvent event){
+  char status[8];
+  switch (event)
+  {
+  case EVENT_CONNECTED:
+    LOG_INFO("Connection established, IP: %s", WiFi.localIP());
+    compositor.scrollText(WiFi.localIP().toString().c_str());
+    fleet.setKey(deviceInfo.fleetKey);
+    if(FLEET_MODE && !fleet.begin(WiFi.localIP())){
+      LOG_WARN("Fleet group could not be joined");
+    }
+    //Don't wait for the next scheduled sync
+    updateClock();
+    break;
 
+  case EVENT_DISCONNECTED:
+    LOG_WARN("Connection lost");
+    fleet.stop();
+    break;
+
+  case EVENT_WPS_STARTED:
+    LOG_INFO("Waiting WPS connection. Attempt %u", connection.getWPSAttempt());
     //Activate WPS LED
     digitalWrite(WPS_LED, HIGH);
-    WiFi.mode(WIFI_STA);
-    int timeToTry  = 1;
-    while (timeToTry < 6){
-      displayBuffer[3] = numTable[timeToTry];
-      updateDisplay();
-      if(WiFi.beginWPSConfig()){
-        Serial.println("WPS connection established.");
-        WiFi.printDiag(Serial);
-        break;
-      }
-      Serial.print("WPS connection failed. Tryin again ...");
-      Serial.println(timeToTry, DEC);
-      timeToTry += 1;
-    }
-
-    if(WiFi.status() != WL_CONNECTED){
-      displayBuffer[0] = B01000111;
-      displayBuffer[1] = B01110111;
-      displayBuffer[2] = B00000110;
-      displayBuffer[3] = B00001110;
-      updateDisplay();
-      return;
-    }
+    snprintf(status, sizeof(status), "WPS%d", connection.getWPSAttempt());
+    showStatus(status);
+    break;
 
-    //Disable WPS LED
+  case EVENT_WPS_SUCCESS:
+  {
+    LOG_INFO("WPS connected");
     digitalWrite(WPS_LED, LOW);
-
-    Serial.println("");
-    Serial.println("WPS connected");
+    compositor.clear();
 
     struct station_config conf;
     wifi_station_get_config(&conf);
 
-    memcpy(deviceInfo.ssid, conf.ssid, sizeof(conf.ssid));
-    memcpy(deviceInfo.psk, conf.password, sizeof(conf.password));
-
+    //SDK arrays aren't terminated when full, the config takes them bounded
+    Device_Info next = deviceInfo;
+    if(!DeviceConfig::setText(next, FIELD_ssid, (const char*)conf.ssid, sizeof(conf.ssid))
+      || !DeviceConfig::setText(next, FIELD_psk, (const char*)conf.password, sizeof(conf.password))){
+      LOG_WARN("WPS network doesn't fit the config, not saved");
+      break;
+    }
+    deviceInfo = next;
     saveCredentials();
+    break;
+  }
+
+  case EVENT_WPS_FAILED:
+    LOG_WARN("WPS connection failed.");
+    digitalWrite(WPS_LED, LOW);
+    showStatus("FAIL", 50);
+    break;
+
+  case EVENT_AP_STARTED:
+    LOG_INFO("Access point %s at %s", deviceInfo.name, WiFi.softAPIP());
+    provisioner.begin(WiFi.softAPIP());
+    break;
+
+  case EVENT_AP_STOPPED:
+    LOG_INFO("Access point closed");
+    provisioner.stop();
+    break;
+  }
+}
+
+/*
+ * Button presses, caught by interrupts and delivered from loop().
+ * Function button moves the time offset, click forward and double click back.
+ * Holding it dismisses an alarm.
+ */
+void onButtonEvent(uint8_t button, ButtonEvent event){
+  if(button == wpsButton && event == BUTTON_CLICK){
+    connection.startWPS();
+  } else if(button == refreshButton && event == BUTTON_CLICK){
     updateClock();
+  } else if(button == functionButton && event == BUTTON_LONG_PRESS){
+    compositor.clear();
+  } else if(button == functionButton){
+    int16_t offset = deviceInfo.timeOffset + (event == BUTTON_CLICK ? OFFSET_STEP : -OFFSET_STEP);
+    if(offset > OFFSET_MAX){
+      offset = OFFSET_MIN;
+    } else if(offset < OFFSET_MIN){
+      offset = OFFSET_MAX;
+    }
+    deviceInfo.timeOffset = offset;
+    alarms.setOffset(offset, softClock.now());
+    updateDisplayBuffer();
+    saveCredentials();
+  }
+}
+
+/*
+ * Shows a fired alarm until it is dismissed or times out.
+ */
+void onAlarm(uint16_t index, const Alarm &alarm){
+  LOG_INFO("Alarm %u fired, type %u", index, alarm.type);
+  switch (alarm.type)
+  {
+  case ALARM_HOURLY:
+    showStatus("-00-", 20);
+    break;
+
+  case ALARM_COUNTDOWN:
+    showStatus("donE", ALARM_SHOW_TIME);
+    break;
+
+  default:
+    showStatus("ALArM", ALARM_SHOW_TIME);
+    break;
+  }
 }
 
 /*
  *  Updates display buffer with new time values
  */
 uint32_t updateDisplayBuffer(){
-  DateTime now = milliClock.now();
-  if(deviceInfo.timeOffset > 0){
-    now = now + TimeSpan(0, deviceInfo.timeOffset / 60, deviceInfo.timeOffset % 60,0);
-  }else if(deviceInfo.timeOffset < 0){
-    now = now - TimeSpan(0, (-deviceInfo.timeOffset) / 60, (-deviceInfo.timeOffset) % 60,0);
+  //Offset is in minutes, negative ones wrap around as they should
+  uint8_t next[4];
+  renderTime(softClock.now() + deviceInfo.timeOffset * SECONDS_PER_MINUTE, next);
+
+  //Animate minute changes, unless a status message owns the display
+  if(memcmp(next, displayBuffer, 4) != 0 && !compositor.isActive()){
+    if(clockShown){
+      compositor.rollDigits(displayBuffer, next);
+    } else {
+      compositor.fade(displayBuffer, next, deviceInfo.brightness);
+    }
   }
+  memcpy(displayBuffer, next, 4);
+  clockShown = true;
 
-  displayBuffer[0] = numTable[now.hour() / 10];
-  displayBuffer[1] = numTable[now.hour() % 10];
-  displayBuffer[2] = numTable[now.minute() / 10];
-  displayBuffer[3] = numTable[now.minute() % 10];
+  return softClock.now() + 5;
+}
 
-  return milliClock.now().unixtime() + 5;
+/*
+ * Segments showing HH:MM of a local epoch.
+ */
+void renderTime(uint32_t local, uint8_t *cells){
+  Civil_Time now = CivilTime::timeOfDay(local);
+  cells[0] = SegmentFont::digit(now.hour / 10);
+  cells[1] = SegmentFont::digit(now.hour % 10);
+  cells[2] = SegmentFont::digit(now.minute / 10);
+  cells[3] = SegmentFont::digit(now.minute % 10);
 }
 
 /*
 * Passes display buffer values into the drivers registers.
 */
 uint32_t updateDisplay(){
+  if(compositor.isActive()){
+    //Compositor frames are written by renderFrame()
+    return softClock.now() + 1;
+  }
   for(int i = 0; i < 4; i++){
     if((i == 1 || i == 2) && dotStatus){
         sc.WriteDigit(displayBuffer[i] | B10000000, i);
@@ -473,23 +531,286 @@ uint32_t updateDisplay(){
     }
   }
   dotStatus = !dotStatus;
-  return milliClock.now().unixtime() + 1;
+  return softClock.now() + 1;
 }
 
 /*
- * Handles filetype to HTML content type conversion
+ * Writes the next compositor frame, if there is one.
+ * Returns true while the compositor owns the display.
  */
-String getContentType(String filename){
-  if (filename.endsWith(".html")) {
-    return "text/html";
-  } else if (filename.endsWith(".css")) {
-    return "text/css";
-  } else if (filename.endsWith(".js")) {
-    return "application/javascript";
-  } else if (filename.endsWith(".svg")){
-    return "image/svg+xml";
+bool renderFrame(){
+  uint8_t cells[DIGIT_COUNT];
+  uint8_t intensity;
+  if(compositor.tick(cells, intensity)){
+    if(intensity != INTENSITY_KEEP){
+      sc.setBrightness(intensity);
+    }
+    for(int i = 0; i < DIGIT_COUNT; i++){
+      sc.WriteDigit(cells[i], i);
+    }
   }
-  return "text";
+  return compositor.isActive();
+}
+
+/*
+ * Shows a status message like "WPS1" or "Err" right away.
+ * Long messages scroll.
+ */
+void showStatus(const char *text, uint8_t hold){
+  compositor.showText(text, hold);
+  renderFrame();
+}
+
+/*
+ * Served SNTP requests, for LAN monitoring.
+ */
+void handleSntpStats(){
+  char buffer[100];
+  snprintf(buffer, sizeof(buffer), "{\"requests\":%u,\"replies\":%u,\"limited\":%u,\"rate\":%u}",
+    sntpServer.getRequests(), sntpServer.getReplies(), sntpServer.getLimited(), sntpServer.getRate());
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.send(200, "application/json", buffer);
+}
+
+/*
+ * Fleet election state, for site monitoring.
+ */
+void handleFleetStats(){
+  char buffer[100];
+  snprintf(buffer, sizeof(buffer), "{\"role\":%d,\"leader\":%u,\"lost\":%u}",
+    fleet.getRole(), fleet.getLeader(), fleet.getLost());
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.send(200, "application/json", buffer);
+}
+
+/*
+ * Sends the log ring as text, oldest line first.
+ */
+void handleLog(){
+  if(!isAuthenticated()){
+    server.send(401, "text/plain", "");
+    return;
+  }
+  char line[LOG_LINE];
+  snprintf(line, sizeof(line), "dropped %u\n", logger.getDropped());
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain", line);
+
+  uint32_t position = logger.oldest();
+  size_t length;
+  while((length = logger.readLine(position, line, sizeof(line))) > 0){
+    server.sendContent(line, length);
+  }
+  server.sendContent("");
+}
+
+/*
+ * Latency histograms of requests and of the clock, for watching the
+ * clock while the UI is under load. Times are us, percentiles and bucket
+ * bounds ms. "reset=1" starts over, so a load run can be read on its own.
+ */
+void handleMetrics(){
+  if(!isAuthenticated()){
+    server.send(401, "text/plain", "");
+    return;
+  }
+  if(server.arg("reset") == "1"){
+    metrics.reset();
+  }
+
+  char buffer[160];
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  snprintf(buffer, sizeof(buffer), "{\"seconds\":%u,\"series\":[", metrics.getSeconds());
+  server.send(200, "application/json", buffer);
+  for(uint8_t i = 0; i < METRIC_SERIES; i++){
+    snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"count\":%u,\"mean\":%u,\"max\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"buckets\":[",
+      i == 0 ? "" : ",", Metrics::getName(i), metrics.getCount(i), metrics.getMean(i), metrics.getMax(i),
+      metrics.getPercentile(i, 50), metrics.getPercentile(i, 90), metrics.getPercentile(i, 99));
+    server.sendContent(buffer);
+    size_t length = 0;
+    for(uint8_t j = 0; j < METRIC_BUCKETS; j++){
+      length += snprintf(buffer + length, sizeof(buffer) - length, "%s%u", j == 0 ? "" : ",", metrics.getBucket(i, j));
+    }
+    server.sendContent(buffer);
+    server.sendContent("]}");
+  }
+  server.sendContent("]}");
+  server.sendContent("");
+}
+
+/*
+ * Files every served route under its kind of request.
+ */
+void onRouteServed(const Route &route, uint32_t elapsed){
+  if(route.handler == nullptr){
+    metrics.record(METRIC_HTTP_FILE, elapsed);
+  } else if(route.method == HTTP_GET){
+    metrics.record(METRIC_HTTP_READ, elapsed);
+  } else {
+    metrics.record(METRIC_HTTP_WRITE, elapsed);
+  }
+}
+
+/*
+ * Loop stall counters and the last stall as JSON.
+ * reset=1 clears them, phase and budget set a phase's budget in ms.
+ */
+void handleStall(){
+  if(!isAuthenticated()){
+    server.send(401, "text/plain", "");
+    return;
+  }
+  if(server.arg("reset") == "1"){
+    stall.reset();
+  }
+  if(server.hasArg("phase") && server.hasArg("budget")){
+    stall.setBudget(server.arg("phase").toInt(), server.arg("budget").toInt());
+  }
+
+  char buffer[120];
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  snprintf(buffer, sizeof(buffer), "{\"overruns\":%u,\"resets\":%u,\"phases\":[",
+    stall.getOverruns(), stall.getResets());
+  server.send(200, "application/json", buffer);
+  for(uint8_t i = 0; i < STALL_PHASES; i++){
+    snprintf(buffer, sizeof(buffer), "%s{\"name\":\"%s\",\"budget\":%u,\"count\":%u,\"max\":%u}",
+      i == 0 ? "" : ",", StallMonitor::getName(i), stall.getBudget(i), stall.getCount(i), stall.getMaxElapsed(i));
+    server.sendContent(buffer);
+  }
+
+  const volatile Stall_Cache &last = stall.getLast();
+  if(last.overruns == 0 && last.resets == 0){
+    server.sendContent("],\"last\":null}");
+    server.sendContent("");
+    return;
+  }
+  //Elapsed is null for a stall that never ended
+  char elapsed[12] = "null";
+  if(last.elapsed < STALL_RESET){
+    snprintf(elapsed, sizeof(elapsed), "%u", last.elapsed);
+  }
+  snprintf(buffer, sizeof(buffer), "],\"last\":{\"phase\":\"%s\",\"task\":\"%x\",\"elapsed\":%s,\"uptime\":%u,\"pc\":[",
+    StallMonitor::getName(last.phase), last.task, elapsed, last.uptime);
+  server.sendContent(buffer);
+  for(uint32_t i = 0; i < last.samples && i < STALL_SAMPLES; i++){
+    snprintf(buffer, sizeof(buffer), "%s\"%x\"", i == 0 ? "" : ",", last.pc[i]);
+    server.sendContent(buffer);
+  }
+  server.sendContent("]}}");
+  server.sendContent("");
+}
+
+/*
+ * Networks found by the last background scan, strongest first.
+ * Comes from the cache, so it never waits for the radio.
+ */
+void handleScan(){
+  if(!isAuthenticated()){
+    server.send(401, "text/plain", "");
+    return;
+  }
+  char buffer[160];
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  //Address lets a client on the access point follow the clock onto the network
+  snprintf(buffer, sizeof(buffer), "{\"state\":%u,\"ip\":\"%s\",\"ap\":%s,\"age\":%u,\"networks\":[",
+    connection.getState(), connection.getState() == STATE_CONNECTED ? WiFi.localIP().toString().c_str() : "",
+    connection.isAccessPointActive() ? "true" : "false", provisioner.getAge());
+  server.send(200, "application/json", buffer);
+  for(uint8_t i = 0; i < provisioner.getCount(); i++){
+    const Scan_Result &result = provisioner.get(i);
+    //SSIDs are escaped through ArduinoJson, they may hold anything
+    StaticJsonBuffer<100> json;
+    JsonObject &network = json.createObject();
+    network["ssid"] = result.ssid;
+    network["rssi"] = result.rssi;
+    network["channel"] = result.channel;
+    network["secure"] = result.secure;
+    size_t length = 0;
+    if(i > 0){
+      buffer[length++] = ',';
+    }
+    network.printTo(buffer + length, sizeof(buffer) - length);
+    server.sendContent(buffer);
+  }
+  server.sendContent("]}");
+  server.sendContent("");
+}
+
+/*
+ * Receives an update image piece by piece. Query "target=fs" writes the
+ * filesystem instead of firmware, "md5=" checks the uncompressed image.
+ */
+void handleUpdateUpload(){
+  HTTPUpload& upload = server.upload();
+  switch (upload.status)
+  {
+  case UPLOAD_FILE_START:
+  {
+    if(!isAuthenticated()){
+      return;
+    }
+    OtaTarget target = server.arg("target") == "fs" ? OTA_FILESYSTEM : OTA_FIRMWARE;
+    LOG_INFO("Update started: %s", upload.filename);
+    if(ota.begin(target, server.arg("md5").c_str())){
+      showStatus("UPd");
+    }
+    break;
+  }
+
+  case UPLOAD_FILE_WRITE:
+    if(ota.isRunning() && !ota.write(upload.buf, upload.currentSize)){
+      LOG_ERROR("Update failed: %s", ota.getError());
+    }
+    //Upload holds the loop, keep the clock going in between pieces
+    runInterrupts();
+    runFrames();
+    break;
+
+  case UPLOAD_FILE_END:
+    if(ota.end()){
+      LOG_INFO("Update written: %u bytes from %u", ota.getWritten(), ota.getReceived());
+    } else if(ota.getError() != nullptr){
+      LOG_ERROR("Update failed: %s", ota.getError());
+    }
+    break;
+
+  case UPLOAD_FILE_ABORTED:
+    LOG_WARN("Update aborted");
+    ota.abort();
+    break;
+  }
+}
+
+/*
+ * Answers once the upload is over. New firmware boots after the answer is sent.
+ */
+void handleUpdateDone(){
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  if(!isAuthenticated()){
+    server.send(401, "application/json", "{\"success\":false}");
+    return;
+  }
+  if(ota.getError() != nullptr || ota.getReceived() == 0){
+    char buffer[60];
+    snprintf(buffer, sizeof(buffer), "{\"success\":false,\"error\":\"%s\"}",
+      ota.getError() != nullptr ? ota.getError() : "empty");
+    showStatus("FAIL", 50);
+    server.send(500, "application/json", buffer);
+    return;
+  }
+
+  if(ota.getTarget() == OTA_FILESYSTEM){
+    //New image carries default credentials, keep the ones in use
+    saveCredentials();
+    compositor.clear();
+  } else {
+    showStatus("boot");
+    restartPending = true;
+  }
+  server.send(200, "application/json", "{\"success\":true}");
 }
 
 /*
@@ -498,7 +819,7 @@ String getContentType(String filename){
  * Checks auth.
  */
 void buildJsonAnswer(char *output){
-  StaticJsonBuffer<400> buffer;
+  StaticJsonBuffer<API_ANSWER_SIZE> buffer;
   JsonObject& root = buffer.createObject();
 
   bool auth = isAuthenticated();
@@ -506,65 +827,50 @@ void buildJsonAnswer(char *output){
     root["auth"] = false;
   } else {
     root["auth"] = true;
-    root["ssid"] = deviceInfo.ssid; //32 Byte + 4 byte
-    root["psk"] = deviceInfo.psk; //64 Byte + 4 byte
+    fillDeviceJson(root);
+  }
+  root.printTo(output, API_ANSWER_SIZE);
+}
 
-    root["dname"] = deviceInfo.name; //20Byte
-    root["lname"] = deviceInfo.loginName;
-    root["dpass"] = deviceInfo.password; //20byte
-    root["bright"] = deviceInfo.brightness; //byte
+void fillDeviceJson(JsonObject &root){
+  DeviceConfig::toJson(deviceInfo, root);
 
-    root["time"] = milliClock.now().unixtime();
-    root["timezone"] = deviceInfo.timeOffset;
-  }
-  root.printTo(output, 400);
+  root["time"] = softClock.now();
+  root["bootDisplay"] = fastBoot.getDisplayMillis();
+  root["bootConnect"] = fastBoot.getConnectedMillis();
 }
 
 /*
- * Handles reading and uploading of requested files from clients.
- * Blocks access to "/creds.txt"
+ * Path isn't in the route table, static files included, so flash isn't looked at.
  */
-bool handleFileRead(String path){
-  SPIFFS.begin();
-  Serial.println("Handle file read");
-  if(path.endsWith("/")){
-    path += "index.html";
-  }
-  if(path.endsWith("/creds.txt")){
-    SPIFFS.end();
-    return false;
-  }
-  String contentType = getContentType(path);
-  String pathWithGz = path + ".gz";
-  if(SPIFFS.exists(pathWithGz) || SPIFFS.exists(path)){
-    if(SPIFFS.exists(pathWithGz)){
-      path += ".gz";
-    }
-    File file = SPIFFS.open(path ,"r");
-    Serial.print("File open: ");
-    Serial.print(path);
-    server.streamFile(file, contentType);
-    file.close();
-    Serial.println("File closed.");
-
-    return true;
+void handleNotFound(){
+  if (redirectToPortal()) {
+    return;
   }
-  SPIFFS.end();
-  return false;
+  server.send(404, "text/plain", "404: File Not Found");
 }
 
 /*
- * If a page not found we came here.
- * Should update with a real webpage
+ * While provisioning every name resolves to us. Requests meant for other
+ * hosts, like phones checking for internet, are sent to the UI instead.
  */
-void handleNotFound(){
-  if (!handleFileRead(server.uri())) {        // check if the file exists in the flash memory (SPIFFS), if so, send it
-    server.send(404, "text/plain", "404: File Not Found");
+bool redirectToPortal(){
+  //Once joined the clock is reached by its own address too
+  if(!provisioner.isActive() || connection.getState() == STATE_CONNECTED){
+    return false;
+  }
+  String address = provisioner.getAddress().toString();
+  String host = server.hostHeader();
+  if(host.length() == 0 || host == address){
+    return false;
   }
+  server.sendHeader("Location", "http://" + address + "/", true);
+  server.send(302, "text/plain", "");
+  return true;
 }
 
 void handleApiExchange(){
-  char buffer[400];
+  char buffer[API_ANSWER_SIZE];
   buildJsonAnswer(buffer);
   server.sendHeader("Access-Control-Allow-Origin", "*");
   server.send(200, "application/json", buffer);
@@ -572,110 +878,251 @@ void handleApiExchange(){
 
 /*
  * Handles API post request.
- * Parsing, determining key:value pairs etc are all done inside.
+ * Alarm requests go to handleAlarmInput, the rest are patches of device
+ * settings. Their type only told which form sent them, fields present are what counts.
  */
 void handleApiInput(){
+  //Alarms included, nothing is parsed for a stranger
+  if(!isAuthenticated()){
+    server.send(401, "application/json", "{\"success\":false}");
+    return;
+  }
   StaticJsonBuffer<400> newBuffer;
   JsonObject& root = newBuffer.parseObject(server.arg("plain"));
-  Serial.println(server.arg("plain"));
 
   if(!root.success()){
-    Serial.println("parseObject() failed");
+    LOG_WARN("parseObject() failed");
+    server.send(400, "application/json", "{\"success\":false}");
     return;
   }
   uint8_t type = root["type"];
-  Serial.print("Request Type: ");
-  Serial.println(type);
+  LOG_INFO("Request Type: %u", type);
   //Types are
   // 0 - Brightness
   // 1 - Network
   // 2 - Device
   // 3 - Server
+  // 4 - Alarms
+  if(type == 4){
+    handleAlarmInput(root);
+    return;
+  }
+  applyDevicePatch(root);
+}
+
+/*
+ * PATCH /api, a JSON object of only the settings to change, keys as GET /api gives them.
+ */
+void handleApiPatch(){
+  if(!isAuthenticated()){
+    server.send(401, "application/json", "{\"success\":false}");
+    return;
+  }
+  StaticJsonBuffer<400> newBuffer;
+  JsonObject& root = newBuffer.parseObject(server.arg("plain"));
+
+  if(!root.success()){
+    LOG_WARN("parseObject() failed");
+    server.send(400, "application/json", "{\"success\":false}");
+    return;
+  }
+  applyDevicePatch(root);
+}
+
+/*
+ * Applies settings present in root and answers with the keys that changed.
+ * Side effects run only for changed fields, resending a form does nothing.
+ * Callers check the session first.
+ */
+void applyDevicePatch(JsonObject &root){
+  uint16_t changed = 0;
+  const char *error = nullptr;
+  if(!DeviceConfig::patch(root, deviceInfo, changed, error)){
+    LOG_WARN("Rejected setting %s", error);
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "{\"success\":false,\"field\":\"%s\"}", error);
+    server.send(400, "application/json", buffer);
+    return;
+  }
+
+  if(changed & FIELD_BIT(brightness)){
+    sc.setBrightness(deviceInfo.brightness);
+  }
+  if(changed & FIELD_BIT(timeOffset)){
+    alarms.setOffset(deviceInfo.timeOffset, softClock.now());
+  }
+  if(changed & FIELD_BIT(fleetKey)){
+    fleet.setKey(deviceInfo.fleetKey);
+  }
+  if(changed){
+    saveCredentials();
+  }
+
+  StaticJsonBuffer<200> buffer;
+  JsonObject &answer = buffer.createObject();
+  answer["success"] = true;
+  JsonArray &keys = answer.createNestedArray("changed");
+  for(uint8_t field = 0; field < DEVICE_FIELD_COUNT; field++){
+    if(changed & (1 << field)){
+      LOG_INFO("Setting %s changed", DeviceConfig::getKey(field));
+      keys.add(DeviceConfig::getKey(field));
+    }
+  }
+  char output[200];
+  answer.printTo(output, sizeof(output));
+  server.send(200, "application/json", output);
 
-  switch (type)
+  if(changed & (FIELD_BIT(ssid) | FIELD_BIT(psk))){
+    //Connection manager reads credentials from deviceInfo, no restart needed
+    connection.connect();
+  }
+}
+
+/*
+ * Alarm edits from API. Actions are
+ * 0 - Add, with kind, days, hour, minute and seconds for countdowns
+ * 1 - Remove alarm at index
+ * 2 - Remove all
+ */
+void handleAlarmInput(JsonObject &root){
+  uint8_t action = root["action"];
+  int16_t index = -1;
+  bool success = false;
+  switch (action)
   {
   case 0:
   {
-    uint8_t brightness = root["bright"];
-    sc.setBrightness(brightness);
-    deviceInfo.brightness = brightness;
+    Alarm alarm;
+    alarm.type = root["kind"];
+    alarm.days = ALARM_EVERY_DAY;
+    if(root.containsKey("days")){
+      alarm.days = root["days"];
+    }
+    alarm.hour = root["hour"];
+    alarm.minute = root["minute"];
+    alarm.at = softClock.now() + root["seconds"].as<uint32_t>();
+    index = alarms.add(alarm, softClock.now());
+    success = index >= 0;
     break;
   }
 
   case 1:
-  {
-    const char *ssid = root["ssid"];
-    Serial.print("SSID: ");
-    Serial.println(ssid);
-
-    const char *psk = root["psk"];
-    Serial.print("PSK: ");
-    Serial.println(psk);
-    if(!(WiFi.SSID().equals(deviceInfo.ssid)) || (!WiFi.psk().equals(deviceInfo.psk))){
-      //We have updated credentials. Update them
-      memcpy(deviceInfo.ssid, ssid, SSID_SIZE);
-      memcpy(deviceInfo.psk, psk, PASSWORD_SIZE);
-    }
+    success = alarms.remove(root["index"], softClock.now());
     break;
-  }
-  case 2:
-  {
-
-    const char *deviceName = root["dname"];
-    const char *loginName = root["lname"];
-    const char *devicePass = root["dpass"];
-
-    int16_t timezone = root["timezone"];
-    uint8_t brightness = root["bright"];
-
-    memcpy(deviceInfo.name, deviceName, DEVICE_NAME_SIZE);
-    memcpy(deviceInfo.loginName, loginName, 12);
-    memcpy(deviceInfo.password, devicePass, DEVICE_PASS_SIZE);
-    deviceInfo.brightness = brightness;
-    deviceInfo.timeOffset = timezone;
 
+  case 2:
+    alarms.clear();
+    success = true;
     break;
   }
-  case 3:
-  {
-    break;
+
+  if(success){
+    alarms.save();
   }
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "{\"success\":%s,\"index\":%d}", success ? "true" : "false", index);
+  server.send(success ? 200 : 400, "application/json", buffer);
+}
+
+/*
+ * Sync history for charting. "source=archive" gives daily summaries from
+ * flash instead of recent syncs, "format=csv" text instead of packed records.
+ */
+void handleHistory(){
+  bool csv = server.arg("format") == "csv";
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, csv ? "text/csv" : "application/octet-stream", "");
+
+  if(server.arg("source") == "archive"){
+    if(csv){
+      server.sendContent("time,offsetMin,offsetMax,offsetMean,delayMean,drift,count,rssiMean\n");
+    }
+    history.readSummaries(csv ? sendSummaryCsv : sendSummaryBinary);
+  } else {
+    if(csv){
+      server.sendContent("time,offset,delay,server,poll,rssi,stratum,flags\n");
+    }
+    char line[100];
+    for(int i = 0; i < history.getCount(); i++){
+      const Sync_Record &record = history.get(i);
+      if(!csv){
+        server.sendContent((const char*)&record, sizeof(record));
+        continue;
+      }
+      snprintf(line, sizeof(line), "%u,%d,%u,%u.%u.%u.%u,%u,%d,%u,%u\n", record.time, record.offset, record.delay,
+        record.server & 0xFF, record.server >> 8 & 0xFF, record.server >> 16 & 0xFF, record.server >> 24,
+        record.poll, record.rssi, record.stratum, record.flags);
+      server.sendContent(line);
+    }
   }
+  server.sendContent("");
+}
+
+void sendSummaryCsv(const Sync_Summary &summary){
+  char line[100];
+  snprintf(line, sizeof(line), "%u,%d,%d,%d,%u,%d,%u,%d\n", summary.time, summary.offsetMin, summary.offsetMax,
+    summary.offsetMean, summary.delayMean, summary.drift, summary.count, summary.rssiMean);
+  server.sendContent(line);
+}
+
+void sendSummaryBinary(const Sync_Summary &summary){
+  server.sendContent((const char*)&summary, sizeof(summary));
+}
 
-  server.send ( 200, "text/json", "{success:true}" );
-  saveCredentials();
+/*
+ * Lists alarms with their next fire time.
+ */
+void handleAlarmList(){
+  char buffer[100];
+  server.sendHeader("Access-Control-Allow-Origin", "*");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "[");
+  bool first = true;
+  for(int i = 0; i < ALARM_MAX; i++){
+    if(!alarms.isUsed(i)){
+      continue;
+    }
+    const Alarm &alarm = alarms.get(i);
+    snprintf(buffer, sizeof(buffer), "%s{\"index\":%d,\"kind\":%u,\"days\":%u,\"hour\":%u,\"minute\":%u,\"next\":%u}",
+      first ? "" : ",", i, alarm.type, alarm.days, alarm.hour, alarm.minute, alarms.getNextFire(i));
+    server.sendContent(buffer);
+    first = false;
+  }
+  server.sendContent("]");
+  server.sendContent("");
 }
 
 bool isAuthenticated() {
-  Serial.println("Enter isAuthenticated");
   if (server.hasHeader("Cookie")) {
-    Serial.print("Found cookie: ");
     String cookie = server.header("Cookie");
-    Serial.println(cookie);
-    if (cookie.indexOf("ESPSESSIONID=1") != -1) {
-      Serial.println("Authentication Successful");
+    LOG_DEBUG("Found cookie: %s", redact(cookie));
+    if (hasSessionCookie(cookie.c_str())) {
+      LOG_DEBUG("Authentication Successful");
       return true;
     }
   }
-  Serial.println("Authentication Failed");
+  LOG_DEBUG("Authentication Failed");
   return false;
 }
 
+bool hasSessionCookie(const char *cookie){
+  return sessions.check(cookie);
+}
+
 /*
  * Handles checking of credentials, cookies etc.
  */
 void handleLogin(){
-  if(server.hasHeader("Cookie")){
-    Serial.println("Found cookie:");
-    Serial.println(server.header("Cookie"));
-  }
   StaticJsonBuffer<100> newBuffer;
   JsonObject& root = newBuffer.parseObject(server.arg("plain"));
-  Serial.println(server.arg("plain"));
   bool dc = false;
   dc = root["DISCONNECTED"];
 
   if(dc){
+    if(server.hasHeader("Cookie")){
+      sessions.revoke(server.header("Cookie").c_str());
+    }
     server.sendHeader("Cache-Control", "no-cache");
     server.sendHeader("Set-Cookie", "ESPSESSIONID=0");
     server.send(301);
@@ -686,114 +1133,141 @@ void handleLogin(){
 
   if(id != NULL && pw != NULL){
     if(id.equals(deviceInfo.loginName) && pw.equals(deviceInfo.password)){
+      //A fresh token per login, a guessed constant can't open the OTA endpoint
+      String cookie = String(SESSION_COOKIE) + sessions.create() + "; Path=/; HttpOnly";
       server.sendHeader("Cache-Control", "no-cache");
-      server.sendHeader("Set-Cookie", "ESPSESSIONID=1");
+      server.sendHeader("Set-Cookie", cookie);
       server.send(301);
+      return;
     }
   }
-  id.~String();
-  pw.~String();
+  server.send(401);
+}
+
+uint32_t updateSntpStats(){
+  sntpServer.sample();
+  return softClock.now() + 1;
+}
+
+/*
+ * A new leader syncs upstream right away instead of waiting for the schedule.
+ */
+void onFleetRole(FleetRole role){
+  if(role == ROLE_LEADER){
+    LOG_INFO("Fleet leader elected, syncing upstream");
+    updateClock();
+  } else if(role == ROLE_FOLLOWER){
+    LOG_INFO("Following fleet leader %u", fleet.getLeader());
+  }
+}
+
+/*
+ * Followers serve the leader's time, with its root and our error on top.
+ */
+void onFleetSync(const Fleet_Beacon &beacon, uint32_t error){
+  sntpServer.setReference(beacon.stratum, beacon.address, beacon.rootDelay, beacon.rootDispersion, 0, error);
 }
 
 // This methods will be called intervals to get clock from network and update local one.
 uint32_t updateClock() {
-  //deactivate Interrupts so the WiFi can work on it's own.
-
-  getClock();
-  return (milliClock.now() + TimeSpan(0,6,0,0)).unixtime();
+  //In a fleet only the leader goes upstream, the rest follow its beacons
+  if(!FLEET_MODE || fleet.isLeader()){
+    tasks.start(getClock);
+  }
+  return softClock.now() + 6 * SECONDS_PER_HOUR;
 }
 
-//Gets clock from network source and provides soft rtc with the results.
-void getClock(){
-  //Get random ip from pool
-  WiFi.hostByName(ntpServerName, timeServerIP);
-  if(!packetSent){
-    sendNTPpacket(timeServerIP);
-    packetSent = true;
-    return;
+/*
+ * Keeps RTC memory copy of the clock fresh for the next warm reset.
+ */
+uint32_t updateBootCache(){
+  //Unsynced time after a cold boot is not worth keeping
+  if(!softClock.isSynced() && !fastBoot.hasTime()){
+    return softClock.now() + BOOT_CACHE_INTERVAL;
   }
+  fastBoot.saveTime(softClock.now(), softClock.getDrift(), deviceInfo.timeOffset, deviceInfo.brightness);
+  return softClock.now() + BOOT_CACHE_INTERVAL;
+}
 
-  int cb = udp.parsePacket();
-  if(cb == 0) {
-    timeToTry--;
-    Serial.print(".");
-    if(timeToTry > 0){
-      return;
-    } else {
-      packetSent = false;
-      timeToTry = 10;
-      getClock();
+/*
+ * Gets clock from network source and provides soft rtc with the results.
+ * Runs as a task and retries until a reply comes. While the connection
+ * is down it waits for it to come back instead of asking into nothing.
+ */
+PT_THREAD(getClock){
+  PT_BEGIN(pt);
+  while(true){
+    PT_WAIT_UNTIL(pt, connection.getState() == STATE_CONNECTED);
+
+    //Get random ip from pool, the answer comes in from lwIP
+    if(!resolver.begin(ntpServerName)){
+      PT_DELAY(pt, DNS_TIMEOUT);
+      continue;
     }
-  } else {
-    
-    timeToTry = 10;
-    packetSent=false;
-    Serial.print("Packet received, length=");
-    Serial.println(cb);
-
-    udp.read(packetBuffer, NTP_PACKET_SIZE);
+    PT_WAIT_UNTIL_TIMEOUT(pt, resolver.isDone(), DNS_TIMEOUT);
+    if(!resolver.isResolved()){
+      LOG_WARN("%s could not be resolved", ntpServerName);
+      if(resolver.isDone()){
+        //Name is unknown, lwIP answered at once
+        PT_DELAY(pt, DNS_TIMEOUT);
+      }
+      continue;
+    }
+    timeServerIP = resolver.getAddress();
+    LOG_DEBUG("sending NTP packet...");
+    ntpClient.send(timeServerIP);
+
+    //Reply is timestamped and checked on arrival, this only picks it up
+    PT_WAIT_UNTIL_TIMEOUT(pt, ntpClient.hasReply() || connection.getState() != STATE_CONNECTED, NTP_TIMEOUT);
+    if(ntpClient.hasReply()){
+      applyNtpReply(ntpClient.getReply());
+      PT_EXIT(pt);
+    }
+    showStatus("Err", 10);
+  }
+  PT_END(pt);
+}
 
-    unsigned long highWord = word(packetBuffer[40], packetBuffer[41]);
-    unsigned long lowWord = word(packetBuffer[42], packetBuffer[43]);
+void applyNtpReply(const Ntp_Reply &reply){
+  bool first = !softClock.isSynced();
 
-    unsigned long secsSince1900 = highWord << 16 | lowWord;
+  uint64_t corrected = softClock.nowMicros() + reply.offset;
+  parseClock(corrected / 1000000ULL, corrected % 1000000ULL);
+  recordSync(reply, first);
 
-    Serial.print("Seconds from 1900: ");
-    Serial.println(secsSince1900);
+  //We are one stratum below our source, half the round trip bounds our offset error
+  uint32_t delay = reply.delay < 0 ? 0 : (reply.delay > UINT32_MAX ? UINT32_MAX : reply.delay);
+  sntpServer.setReference(reply.stratum, (uint32_t)timeServerIP, reply.rootDelay, reply.rootDispersion, delay, delay / 2);
+  fleet.setReference(reply.stratum + 1, sntpServer.getRootDelay(), sntpServer.getRootDispersion());
+  updateDisplayBuffer();
+  fastBoot.markDisplay();
+}
 
-    // now convert NTP time into everyday time:
-    Serial.print("Unix time = ");
-    // Unix time starts on Jan 1 1970. In seconds, that's 2208988800:
-    const unsigned long seventyYears = 2208988800UL;
-    // subtract seventy years:
-    unsigned long epoch = secsSince1900 - seventyYears;
-    // print Unix time:
-    Serial.println(epoch);
+//Parse unix epoch time to soft rtc and logs it out
+void parseClock(unsigned long epoch, uint32_t micro){
+  Civil_Time time = CivilTime::fromEpoch(epoch);
 
-    parseClock(epoch);
-    updateDisplayBuffer();
-  }
+  LOG_INFO("The GMT time is %u-%02u-%02u %u:%02u:%02u",
+    time.year, time.month, time.day, time.hour, time.minute, time.second);
+  softClock.adjust(epoch, micro);
+  updateBootCache();
 }
 
-//Parse unix epoch time to soft rtc and logs it out
-void parseClock(unsigned long epoch){
-  DateTime time = DateTime(epoch);
-
-  Serial.print("The GMT time is ");
-  Serial.print(time.hour());
-  Serial.print(':');
-  if (time.minute() < 10) {
-    Serial.print('0');
-  }
-  Serial.print(time.minute());
-  Serial.print(':');
-  if (time.second() < 10) {
-    Serial.print('0');
-  }
-  Serial.println(time.second()); 
-  milliClock.adjust(time);
-}
-
-// send an NTP request to the time server at the given address
-void sendNTPpacket(IPAddress& address) {
-  Serial.println("sending NTP packet...");
-  // set all bytes in the buffer to 0
-  memset(packetBuffer, 0, NTP_PACKET_SIZE);
-  // Initialize values needed to form NTP request
-  // (see URL above for details on the packets)
-  packetBuffer[0] = 0b11100011;   // LI, Version, Mode
-  packetBuffer[1] = 2;     // Stratum, or type of clock
-  packetBuffer[2] = 6;     // Polling Interval
-  packetBuffer[3] = 0xEC;  // Peer Clock Precision
-  // 8 bytes of zero for Root Delay & Root Dispersion
-  packetBuffer[12]  = 49;
-  packetBuffer[13]  = 0x4E;
-  packetBuffer[14]  = 49;
-  packetBuffer[15]  = 52;
-
-  // all NTP fields have been given values, now
-  // you can send a packet requesting a timestamp:
-  udp.beginPacket(address, 123); //NTP requests are to port 123
-  udp.write(packetBuffer, NTP_PACKET_SIZE);
-  udp.endPacket();
-}
\ No newline at end of file
+/*
+ * Keeps an upstream sync in history.
+ */
+void recordSync(const Ntp_Reply &reply, bool first){
+  Sync_Record record;
+  record.time = softClock.now();
+  record.offset = reply.offset > INT32_MAX ? INT32_MAX : (reply.offset < INT32_MIN ? INT32_MIN : reply.offset);
+  record.delay = reply.delay < 0 ? 0 : (reply.delay > UINT32_MAX ? UINT32_MAX : reply.delay);
+  record.server = (uint32_t)timeServerIP;
+  uint32_t interval = record.time - lastSync;
+  record.poll = interval > 0 ? 31 - __builtin_clz(interval) : 0;
+  record.rssi = WiFi.RSSI();
+  record.stratum = reply.stratum;
+  record.flags = first ? SYNC_FIRST : 0;
+  history.add(record, softClock.getDrift());
+  lastSync = record.time;
+  LOG_INFO("Synced, offset %d us, delay %u us", record.offset, record.delay);
+}
@@ -4,20 +4,36 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <SerialDriver.h>
+#include <DisplayCompositor.h>
+#include <SoftClock.h>
+#include <CivilTime.h>
+#include <FastBoot.h>
+#include <ConnectionManager.h>
+#include <SntpServer.h>
+#include <FleetSync.h>
+#include <OtaUpdater.h>
+#include <ButtonEvents.h>
+#include <Logger.h>
+#include <AlarmEngine.h>
+#include <SyncHistory.h>
+#include <NtpPacket.h>
+#include <NtpClient.h>
+#include <Resolver.h>
+#include <StallMonitor.h>
+#include <Provisioner.h>
+#include <Protothread.h>
+#include <RouteTable.h>
+#include <DeviceConfig.h>
+#include <Metrics.h>
+#include <SessionStore.h>
+#include <TaskList.h>
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <ESP8266mDNS.h>  
 #include <FS.h>
-#include <WiFiUdp.h>
-#include <RTClib.h>
-#include <Bounce2.h>
 #include <user_interface.h>
 
-#define DEVICE_NAME_SIZE 12
-#define DEVICE_PASS_SIZE 12
-
-#define SSID_SIZE 32
-#define PASSWORD_SIZE 64
+#define CREDENTIALS_SIZE 160 //Whole credentials file
 
 #define DATA_PIN 13
 #define CLOCK_PIN 14
@@ -25,45 +41,92 @@
 
 #define WPS_BUTTON_PIN 4
 #define REFRESH_BUTTON_PIN 5
-#define FUNCTION_BUTTON_PIN 16
+//As wired on physical_device/Schematic_JUL_02_2019.pdf
+#define FUNCTION_BUTTON_PIN 12 //D6, BUT_OFFSET
 
-#define WPS_LED 16 //D3
+#define WPS_LED 16 //D0, LED_WPS
 #define CONN_LED 2 //D4
 
+static_assert(WPS_LED != FUNCTION_BUTTON_PIN && WPS_LED != WPS_BUTTON_PIN && WPS_LED != REFRESH_BUTTON_PIN &&
+  CONN_LED != FUNCTION_BUTTON_PIN && CONN_LED != WPS_BUTTON_PIN && CONN_LED != REFRESH_BUTTON_PIN,
+  "LEDs can't share a pin with a button");
+
+#define OFFSET_STEP 60 //Minutes the function button moves the time offset
+
+#define ALARM_SHOW_TIME 200 //Frames a fired alarm stays on the display
+
+
+#define FRAME_INTERVAL 100 //ms between compositor frames
+#define BOOT_CACHE_INTERVAL 60 //s between saving time to RTC memory
+
+#define SNTP_SERVER false //Serve our time to the LAN on UDP 123
+#define FLEET_MODE false //Share one upstream sync between clocks on the site, set a fleet key in the UI too
+
+#define API_ANSWER_SIZE 512 //Device JSON with every text field full
+
 
 
 // -------- NETWORK
 void createAccessPoint();
 void getNetworkConnection();
-void sendNTPpacket(IPAddress& address);
 void getUDPPacket();
-void getWPSConnection();
+void onConnectionEvent(ConnectionEvent event);
+void onFleetRole(FleetRole role);
+void onFleetSync(const Fleet_Beacon &beacon, uint32_t error);
+void onButtonEvent(uint8_t button, ButtonEvent event);
+void onAlarm(uint16_t index, const Alarm &alarm);
 
 // -------- SERVER
 
 void onIndex();
 void handleLogin();
 bool isAuthenticated();
+bool hasSessionCookie(const char *cookie);
 void handleApiExchange();
+void buildJsonAnswer(char *output);
+void fillDeviceJson(JsonObject &root);
 void handleApiInput();
+void handleApiPatch();
+void applyDevicePatch(JsonObject &root);
+void handleSntpStats();
+void handleFleetStats();
+void handleLog();
+void handleAlarmInput(JsonObject &root);
+void handleAlarmList();
+void handleHistory();
+void handleStall();
+void handleScan();
+void handleMetrics();
+void onRouteServed(const Route &route, uint32_t elapsed);
+void sendSummaryCsv(const Sync_Summary &summary);
+void sendSummaryBinary(const Sync_Summary &summary);
+void handleUpdateUpload();
+void handleUpdateDone();
 void handleNotFound();
-bool handleFileRead(String path);
+bool redirectToPortal();
 
 // -------- DISPLAY
 uint32_t updateDisplayBuffer();
+void renderTime(uint32_t local, uint8_t *cells);
 uint32_t updateDisplay();
+bool renderFrame();
+void showStatus(const char *text, uint8_t hold = HOLD_FOREVER);
 
 // -------- CLOCK
-void getClock();
-void parseClock(unsigned long epoch);
+uint8_t getClock(Protothread *pt);
+void applyNtpReply(const Ntp_Reply &reply);
+void parseClock(unsigned long epoch, uint32_t micro = 0);
+void recordSync(const Ntp_Reply &reply, bool first);
 uint32_t updateClock();
+uint32_t updateBootCache();
+uint32_t updateSntpStats();
 
 // -------- INTERRUPTS
 void activateTickerInts();
 void deactivateTickerInts();
 
 
-struct Node* addInterrupt(uint32_t (*function)(void));
+struct Node* addInterrupt(uint32_t (*function)(void), uint16_t budget = STALL_TASK_BUDGET);
 bool removeInterrupt(struct Node* n);
 
 // -------- FLAGS
@@ -82,6 +145,8 @@ void initPeripherals();
 void initNetwork();
 void initServer();
 void initInterrupts();
+void runInterrupts();
+void runFrames();
 
 
 /*
@@ -99,16 +164,11 @@ unsigned int localPort = 2390;
 IPAddress timeServerIP;
 const char * ntpServerName = "time.nist.gov";
 
-const int NTP_PACKET_SIZE = 48;
-byte packetBuffer[NTP_PACKET_SIZE];
-
-WiFiUDP udp;
-
-bool packetSent = false;
-int timeToTry = 10; //Times to read UDP packet before sending another one
+uint32_t lastSync = 0;
 
 uint8_t displayBuffer[4] = {B01001110, B00011101, B00010101, B00010101};
 bool dotStatus = true;
+bool clockShown = false;
 
 
 // FILESYSTEM ----------
@@ -117,87 +177,62 @@ ESP8266WebServer server(80);
 
 // OBJECTS ------------
 SerialDriver sc(DATA_PIN, CLOCK_PIN, LATCH_PIN);
-RTC_Millis milliClock;
-Bounce wpsButton = Bounce();
-Bounce refreshButton = Bounce();
-Bounce functionButton = Bounce();
+DisplayCompositor compositor;
+SoftClock softClock;
+FastBoot fastBoot;
+ConnectionManager connection(fastBoot);
+SntpServer sntpServer(softClock);
+NtpClient ntpClient(softClock);
+Resolver resolver;
+FleetSync fleet(softClock);
+OtaUpdater ota;
+Logger logger;
+ButtonEvents buttons;
+AlarmEngine alarms;
+SyncHistory history;
+StallMonitor stall;
+Provisioner provisioner;
+SessionStore sessions;
+TaskRunner tasks;
+Metrics metrics;
+uint8_t wpsButton;
+uint8_t refreshButton;
+uint8_t functionButton;
+
+// ROUTES ------------
+constexpr auto routeList = RouteTable::sort(std::array{
+  RouteTable::route(HTTP_POST, "/", handleApiInput),
+  RouteTable::route(HTTP_GET, "/api", handleApiExchange),
+  RouteTable::route(HTTP_POST, "/api", handleApiInput),
+  RouteTable::route(HTTP_PATCH, "/api", handleApiPatch),
+  RouteTable::route(HTTP_POST, "/login", handleLogin),
+  RouteTable::route(HTTP_GET, "/sntp", handleSntpStats),
+  RouteTable::route(HTTP_GET, "/fleet", handleFleetStats),
+  RouteTable::route(HTTP_POST, "/update", handleUpdateDone, handleUpdateUpload),
+  RouteTable::route(HTTP_GET, "/log", handleLog),
+  RouteTable::route(HTTP_GET, "/alarms", handleAlarmList),
+  RouteTable::route(HTTP_GET, "/history", handleHistory),
+  RouteTable::route(HTTP_GET, "/stall", handleStall),
+  RouteTable::route(HTTP_GET, "/scan", handleScan),
+  RouteTable::route(HTTP_GET, "/metrics", handleMetrics),
+
+  //Static files, anything else on flash is never served
+  RouteTable::file("/", "/index.html", "text/html"),
+  RouteTable::file("/index.html", "/index.html", "text/html"),
+  RouteTable::file("/server/main.css", "/server/main.css", "text/css"),
+  RouteTable::file("/server/script.js", "/server/script.js", "application/javascript"),
+  RouteTable::file("/server/home.svg", "/server/home.svg", "image/svg+xml"),
+  RouteTable::file("/server/info.svg", "/server/info.svg", "image/svg+xml"),
+  RouteTable::file("/server/settings.svg", "/server/settings.svg", "image/svg+xml")
+});
+static_assert(RouteTable::isUnique(routeList), "Two routes hash the same, rename one");
+
+RouteHandler routeHandler(routeList.data(), routeList.size());
 
 // ------------ STRUCTS --------------
 
-typedef struct Device_Info_t {
-  char ssid[32];
-  char psk[64];
-  char name[12];
-  char loginName[12];
-  char password[12];
-  uint8_t brightness;
-  int16_t timeOffset;
-}Device_Info;
-
-typedef struct Node {
-  uint32_t time;
-  uint32_t (*function)(void);
-  bool isActive = true;
-  struct Node *next = nullptr;
-}Node;
-
-struct List {
-  struct Node *head = nullptr;
-  struct Node *tail = nullptr;
-  uint8_t length = 0;
-  struct Node *index = nullptr;
-
-  void reset(){
-    index = nullptr;
-  }
-
-  struct Node* getCurrent(){
-    return index;
-  }
-  void setIndex(struct Node* n){
-    struct Node* temp = head;
-    while(temp->next != nullptr){
-      temp = temp->next;
-    }
-    index = temp;
-  }
-  
-  bool advance(){
-    if(index == nullptr){
-      if(head == nullptr){
-        return false;
-      }
-      index = head;
-      return true;
-    }
-    if(index == tail){
-      index = nullptr;
-      return false;
-    }
-    if(index->next != nullptr){
-      index = index->next;
-      return true;
-    }
-    return true;
-  }
-};
-
 Device_Info_t deviceInfo;
-struct List *interruptList = (struct List*)malloc(sizeof(struct List));
-
-// ------------ NUM REF TABLE ---------------
-uint8_t numTable[] = {
-  B01111110,
-  B00110000,
-  B01101101,
-  B01111001,
-  B00110011,
-  B01011011,
-  B00011111,
-  B01110000,
-  B01111111,
-  B01111011,
-};
+struct List *interruptList = new List;
 
 /*
  * Check buttons and determines boot state
@@ -209,11 +244,10 @@ uint8_t numTable[] = {
 uint8_t checkBootState(){
   //bool refreshButton = digitalRead(REFRESH_BUTTON_PIN);
 
-  bool funcButton = functionButton.read();
-  bool wButton = wpsButton.read();
+  bool funcButton = buttons.isPressed(functionButton);
+  bool wButton = buttons.isPressed(wpsButton);
 
-  //We are using pull-ups on pins, they are always 1
-  return !funcButton << 1 | !wButton;
+  return funcButton << 1 | wButton;
 }
 
 
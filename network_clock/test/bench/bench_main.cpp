@@ -0,0 +1,264 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESP8266WebServer.h>
+#include <benchmark/benchmark.h>
+#include <time.h>
+#include <CivilTime.h>
+#include <DeviceConfig.h>
+#include <Metrics.h>
+#include <NtpPacket.h>
+#include <RouteTable.h>
+#include <SessionStore.h>
+#include <TaskList.h>
+#include <string>
+#include <vector>
+
+/*
+ * Host benchmarks of the code the clock runs on every tick or request.
+ * Run with --benchmark_format=json and feed two runs to compare.py to
+ * catch regressions, host times only rank changes, they aren't chip times.
+ */
+
+//From main.cpp, main.h itself defines the globals
+void renderTime(uint32_t local, uint8_t *cells);
+bool hasSessionCookie(const char *cookie);
+void fillDeviceJson(JsonObject &root);
+extern RouteHandler routeHandler;
+extern Metrics metrics;
+extern SessionStore sessions;
+
+static void BM_NtpBuildRequest(benchmark::State &state){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    uint64_t transmit = 0xE1F2A3B4C5D6E7F8ULL;
+    for(auto _ : state){
+        NtpPacket::buildRequest(buffer, transmit++);
+        benchmark::DoNotOptimize(buffer);
+    }
+}
+BENCHMARK(BM_NtpBuildRequest);
+
+static void BM_NtpParseReply(benchmark::State &state){
+    uint64_t sent = 0xE1F2A3B400000000ULL;
+    uint8_t buffer[NTP_PACKET_SIZE] = {0};
+    buffer[0] = 0b00100100;
+    buffer[1] = 2;
+    NtpPacket::writeStamp(buffer + 24, sent);
+    NtpPacket::writeStamp(buffer + 32, sent + 0x10000000ULL);
+    NtpPacket::writeStamp(buffer + 40, sent + 0x10100000ULL);
+    Ntp_Reply reply;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + 0x00400000ULL, reply));
+    }
+}
+BENCHMARK(BM_NtpParseReply);
+
+static void BM_CivilFromEpoch(benchmark::State &state){
+    uint32_t epoch = 1500000000UL;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(CivilTime::fromEpoch(epoch));
+        epoch += 86399;
+    }
+}
+BENCHMARK(BM_CivilFromEpoch);
+
+//What fromEpoch() replaces, for scale
+static void BM_Gmtime(benchmark::State &state){
+    time_t epoch = 1500000000UL;
+    struct tm civil;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(gmtime_r(&epoch, &civil));
+        epoch += 86399;
+    }
+}
+BENCHMARK(BM_Gmtime);
+
+static void BM_CivilToEpoch(benchmark::State &state){
+    uint16_t day = 0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(CivilTime::toEpoch(1970 + day % 136, 1 + day % 12, 1 + day % 28, 12, 34, 56));
+        day++;
+    }
+}
+BENCHMARK(BM_CivilToEpoch);
+
+static void BM_RenderTime(benchmark::State &state){
+    uint8_t cells[8];
+    uint32_t local = 1500000000UL;
+    for(auto _ : state){
+        renderTime(local++, cells);
+        benchmark::DoNotOptimize(cells);
+    }
+}
+BENCHMARK(BM_RenderTime);
+
+//initInterrupts() registers 5 tasks, 16 leaves room for alarms and fleet work
+static void BM_TaskListAdvance(benchmark::State &state){
+    std::vector<Node> nodes(state.range(0));
+    List list;
+    for(Node &node : nodes){
+        list.append(&node);
+    }
+    for(auto _ : state){
+        uint32_t due = 0;
+        list.reset();
+        while(list.advance()){
+            due += list.getCurrent()->time == 0;
+        }
+        benchmark::DoNotOptimize(due);
+    }
+}
+BENCHMARK(BM_TaskListAdvance)->Arg(5)->Arg(16);
+
+//A one shot task finishing at the end of the walk, the longest search, and being added back
+static void BM_TaskListRemove(benchmark::State &state){
+    std::vector<Node> nodes(state.range(0));
+    List list;
+    for(Node &node : nodes){
+        list.append(&node);
+    }
+    for(auto _ : state){
+        Node *last = list.tail;
+        benchmark::DoNotOptimize(list.remove(last));
+        list.append(last);
+    }
+}
+BENCHMARK(BM_TaskListRemove)->Arg(5)->Arg(16);
+
+static void BM_ParseCsv(benchmark::State &state){
+    static const char line[] = "HomeNetwork,correct horse battery,clock,admin,secret,8,180,";
+    char csv[sizeof(line)];
+    Device_Info info;
+    for(auto _ : state){
+        memcpy(csv, line, sizeof(line));
+        benchmark::DoNotOptimize(DeviceConfig::parseCsv(csv, info));
+    }
+}
+BENCHMARK(BM_ParseCsv);
+
+static void BM_DeviceJson(benchmark::State &state){
+    char out[512];
+    for(auto _ : state){
+        StaticJsonBuffer<512> buffer;
+        JsonObject &root = buffer.createObject();
+        fillDeviceJson(root);
+        benchmark::DoNotOptimize(root.printTo(out, sizeof(out)));
+    }
+}
+BENCHMARK(BM_DeviceJson);
+
+//Every slot taken, the cookie holds the newest token
+static void BM_SessionCookie(benchmark::State &state){
+    const char *token = nullptr;
+    for(uint8_t i = 0; i < SESSION_MAX; i++){
+        token = sessions.create();
+    }
+    std::string header = std::string("theme=dark; " SESSION_COOKIE) + token + "; lang=en";
+    const char *cookie = header.c_str();
+    for(auto _ : state){
+        benchmark::DoNotOptimize(hasSessionCookie(cookie));
+    }
+}
+BENCHMARK(BM_SessionCookie);
+
+static void BM_RouteLookup(benchmark::State &state){
+    const String uris[] = {"/", "/api", "/server/main.css", "/metrics", "/no/such/page"};
+    size_t i = 0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(routeHandler.canHandle(HTTP_GET, uris[i++ % 5]));
+    }
+}
+BENCHMARK(BM_RouteLookup);
+
+/*
+ * Synthetic tables of a few hundred routes, to see the lookup stays flat
+ * as routes are added. A linear scan like the server's handler chain is
+ * the baseline.
+ */
+#define BENCH_PATH_LENGTH 12
+
+template<size_t N>
+struct Bench_Paths {
+  char text[N][BENCH_PATH_LENGTH];
+};
+
+template<size_t N>
+static constexpr Bench_Paths<N> makePaths(){
+    Bench_Paths<N> paths = {};
+    const char prefix[] = "/route/";
+    for(size_t i = 0; i < N; i++){
+        size_t j = 0;
+        for(; prefix[j] != '\0'; j++){
+            paths.text[i][j] = prefix[j];
+        }
+        paths.text[i][j++] = '0' + i / 1000 % 10;
+        paths.text[i][j++] = '0' + i / 100 % 10;
+        paths.text[i][j++] = '0' + i / 10 % 10;
+        paths.text[i][j++] = '0' + i % 10;
+    }
+    return paths;
+}
+
+template<size_t N>
+static constexpr Bench_Paths<N> benchPaths = makePaths<N>();
+
+static void benchHandler(){
+}
+
+template<size_t N>
+static constexpr std::array<Route, N> makeRoutes(){
+    std::array<Route, N> routes = {};
+    for(size_t i = 0; i < N; i++){
+        routes[i] = RouteTable::route(HTTP_GET, benchPaths<N>.text[i], benchHandler);
+    }
+    return RouteTable::sort(routes);
+}
+
+//Every 8th lookup misses, like favicons and probes do
+template<size_t N>
+static const char* benchPath(size_t i){
+    return i % 8 == 7 ? "/route/none" : benchPaths<N>.text[i * 7919 % N];
+}
+
+template<size_t N>
+static void BM_RouteTableFind(benchmark::State &state){
+    static constexpr std::array<Route, N> routes = makeRoutes<N>();
+    static_assert(RouteTable::isUnique(routes), "Synthetic paths collide");
+    size_t i = 0;
+    for(auto _ : state){
+        const char *path = benchPath<N>(i++);
+        benchmark::DoNotOptimize(RouteTable::find(routes.data(), N, HTTP_GET, path, strlen(path)));
+    }
+}
+BENCHMARK_TEMPLATE(BM_RouteTableFind, 16);
+BENCHMARK_TEMPLATE(BM_RouteTableFind, 128);
+BENCHMARK_TEMPLATE(BM_RouteTableFind, 512);
+
+template<size_t N>
+static void BM_RouteLinearScan(benchmark::State &state){
+    size_t i = 0;
+    for(auto _ : state){
+        const char *path = benchPath<N>(i++);
+        const char *found = nullptr;
+        for(size_t j = 0; j < N && found == nullptr; j++){
+            if(strcmp(benchPaths<N>.text[j], path) == 0){
+                found = benchPaths<N>.text[j];
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK_TEMPLATE(BM_RouteLinearScan, 16);
+BENCHMARK_TEMPLATE(BM_RouteLinearScan, 128);
+BENCHMARK_TEMPLATE(BM_RouteLinearScan, 512);
+
+static void BM_MetricsRecord(benchmark::State &state){
+    uint32_t elapsed = 1;
+    for(auto _ : state){
+        metrics.record(METRIC_LOOP, elapsed);
+        elapsed = elapsed * 1103515245UL + 12345;
+        elapsed &= 0xFFFFF;
+    }
+}
+BENCHMARK(BM_MetricsRecord);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""
+Compares two Google Benchmark JSON reports, fails when any benchmark got
+slower than the threshold. Medians are used when the runs had repetitions.
+
+  .pio/build/bench/program --benchmark_format=json --benchmark_repetitions=5 > current.json
+  python3 test/bench/compare.py baseline.json current.json --threshold 10
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as report:
+        benchmarks = json.load(report)["benchmarks"]
+    times = {}
+    medians = {}
+    for benchmark in benchmarks:
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[name] = benchmark["cpu_time"]
+        else:
+            times.setdefault(name, []).append(benchmark["cpu_time"])
+    for name, runs in times.items():
+        if name not in medians:
+            runs.sort()
+            medians[name] = runs[len(runs) // 2]
+    return medians
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    failed = False
+    for name in sorted(current):
+        if name not in baseline:
+            print("%-32s %10.1f ns  new" % (name, current[name]))
+            continue
+        change = (current[name] - baseline[name]) * 100.0 / baseline[name]
+        slower = change > args.threshold
+        failed |= slower
+        print("%-32s %10.1f ns  %+6.1f%%%s" % (name, current[name], change, "  REGRESSION" if slower else ""))
+    for name in sorted(set(baseline) - set(current)):
+        print("%-32s missing" % name)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
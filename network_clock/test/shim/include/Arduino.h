@@ -0,0 +1,131 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <WString.h>
+#include <Print.h>
+#include <Stream.h>
+#include <binary.h>
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+
+//Flash strings are plain strings on the host
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) ((const __FlashStringHelper*)(s))
+#define FPSTR(s) ((const __FlashStringHelper*)(s))
+typedef const char* PGM_P;
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+#define digitalPinToInterrupt(pin) (pin)
+#define noInterrupts()
+#define interrupts()
+
+template<typename T, typename L, typename H> auto constrain(T x, L low, H high) -> decltype(x + low + high){
+    return x < low ? low : (x > high ? high : x);
+}
+
+inline uint16_t word(uint8_t high, uint8_t low){
+    return high << 8 | low;
+}
+
+unsigned long millis();
+unsigned long micros();
+uint64_t micros64();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void *arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long high);
+long random(long low, long high);
+
+class HardwareSerial : public Stream{
+public:
+    void begin(unsigned long baud);
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite();
+    void flush() override;
+};
+extern HardwareSerial Serial;
+
+class EspClass{
+public:
+    void restart();
+    uint32_t getChipId();
+    uint32_t getCycleCount();
+    uint8_t getCpuFreqMHz();
+    uint32_t getFreeHeap();
+    uint32_t random();
+    uint32_t getFreeSketchSpace();
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+};
+extern EspClass ESP;
+
+#define TIM_DIV1 0
+#define TIM_DIV16 1
+#define TIM_DIV256 3
+#define TIM_EDGE 0
+#define TIM_LEVEL 1
+#define TIM_SINGLE 0
+#define TIM_LOOP 1
+typedef void (*timercallback)(void);
+void timer1_isr_init(void);
+void timer1_enable(uint8_t divider, uint8_t interrupt, uint8_t reload);
+void timer1_disable(void);
+void timer1_attachInterrupt(timercallback callback);
+void timer1_detachInterrupt(void);
+void timer1_write(uint32_t ticks);
+
+//RTC user memory, 128 words that survive a reset on the chip
+extern volatile uint32_t hostRtcMemory[128];
+#define RTC_USER_MEM (hostRtcMemory)
+
+[[noreturn]] void panic(void);
+
+#include <IPAddress.h>
+#include <Host.h>
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef ESP8266WEBSERVER_H
+#define ESP8266WEBSERVER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <FS.h>
+#include <functional>
+#include <vector>
+#include <utility>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 2048
+#define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+typedef struct {
+    HTTPUploadStatus status;
+    String filename;
+    String name;
+    String type;
+    size_t totalSize;
+    size_t currentSize;
+    size_t contentLength;
+    uint8_t buf[HTTP_UPLOAD_BUFLEN];
+} HTTPUpload;
+
+class ESP8266WebServer;
+
+class RequestHandler{
+public:
+    virtual ~RequestHandler(){}
+    virtual bool canHandle(HTTPMethod method, const String &uri){ return false; }
+    virtual bool canUpload(const String &uri){ return false; }
+    virtual bool handle(ESP8266WebServer &server, HTTPMethod method, const String &uri){ return false; }
+    virtual void upload(ESP8266WebServer &server, const String &uri, HTTPUpload &upload){}
+
+    RequestHandler* next(){ return _next; }
+    void next(RequestHandler *handler){ _next = handler; }
+
+private:
+    RequestHandler *_next = nullptr;
+};
+
+/*
+ * Web server on a loopback TCP socket. Like the core it takes one client
+ * per handleClient(), reads the whole request while the loop waits and
+ * closes the connection after the answer. Multipart bodies are cut into
+ * HTTP_UPLOAD_BUFLEN pieces for the upload handler.
+ */
+class ESP8266WebServer{
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    ESP8266WebServer(int port = 80);
+    ~ESP8266WebServer();
+    void begin();
+    void close();
+    void handleClient();
+
+    void addHandler(RequestHandler *handler);
+    void onNotFound(THandlerFunction handler);
+
+    String uri();
+    HTTPMethod method();
+    HTTPUpload& upload();
+    String arg(const String &name);
+    bool hasArg(const String &name);
+    int args();
+    void collectHeaders(const char *headerKeys[], const size_t count);
+    String header(const String &name);
+    bool hasHeader(const String &name);
+    String hostHeader();
+
+    void send(int code, const char *contentType = nullptr, const String &content = String(""));
+    void send(int code, const char *contentType, const char *content);
+    void send(int code, const String &contentType, const String &content);
+    void setContentLength(size_t length);
+    void sendHeader(const String &name, const String &value, bool first = false);
+    void sendContent(const String &content);
+    void sendContent(const char *content);
+    void sendContent(const char *content, size_t length);
+    size_t streamFile(File &file, const String &contentType);
+
+private:
+    bool readRequest();
+    bool readLine(std::string &line);
+    bool readBody(size_t length, std::string &body);
+    void parseArgs(const std::string &query);
+    void parseMultipart(const std::string &body, const std::string &boundary);
+    void sendHeaders(int code, const char *contentType, size_t length);
+    void writeRaw(const char *data, size_t length);
+
+    int _port;
+    int _listener = -1;
+    int _client = -1;
+    std::string _pending; //Read past the headers
+    RequestHandler *_firstHandler = nullptr;
+    RequestHandler *_lastHandler = nullptr;
+    RequestHandler *_currentHandler = nullptr;
+    THandlerFunction _notFound;
+
+    String _uri;
+    HTTPMethod _method = HTTP_GET;
+    std::vector<std::pair<String, String>> _args;
+    std::vector<String> _headerKeys;
+    std::vector<std::pair<String, String>> _headers;
+    String _hostHeader;
+    HTTPUpload _upload;
+
+    std::string _responseHeaders;
+    size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool _chunked = false;
+    bool _sent = false;
+};
+
+#endif
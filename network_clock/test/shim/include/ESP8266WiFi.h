@@ -0,0 +1,88 @@
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+#include <Arduino.h>
+#include <functional>
+#include <memory>
+
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_SCAN_COMPLETED = 2, WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4, WL_CONNECTION_LOST = 5, WL_WRONG_PASSWORD = 6, WL_DISCONNECTED = 7 };
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum wl_enc_type { ENC_TYPE_WEP = 5, ENC_TYPE_TKIP = 2, ENC_TYPE_CCMP = 4, ENC_TYPE_NONE = 7, ENC_TYPE_AUTO = 8 };
+enum WiFiDisconnectReason { WIFI_DISCONNECT_REASON_ASSOC_LEAVE = 8, WIFI_DISCONNECT_REASON_AUTH_FAIL = 202,
+    WIFI_DISCONNECT_REASON_NO_AP_FOUND = 201 };
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+struct WiFiEventStationModeConnected {
+    String ssid;
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected {
+    String ssid;
+    uint8_t bssid[6];
+    WiFiDisconnectReason reason;
+};
+
+struct WiFiEventStationModeGotIP {
+    IPAddress ip;
+    IPAddress mask;
+    IPAddress gw;
+};
+
+struct WiFiEventHandlerOpaque;
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+/*
+ * Station and soft AP. Joining, scans and events complete in
+ * Host::runSystem() against the networks a test added.
+ */
+class ESP8266WiFiClass{
+public:
+    bool mode(WiFiMode_t mode);
+    WiFiMode_t getMode();
+    bool persistent(bool persistent);
+    bool setAutoReconnect(bool autoReconnect);
+
+    wl_status_t begin(const char *ssid, const char *psk = nullptr, int32_t channel = 0, const uint8_t *bssid = nullptr, bool connect = true);
+    wl_status_t begin();
+    bool config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0);
+    bool disconnect(bool wifiOff = false);
+    wl_status_t status();
+    bool isConnected();
+
+    IPAddress localIP();
+    IPAddress subnetMask();
+    IPAddress gatewayIP();
+    IPAddress dnsIP(uint8_t index = 0);
+    String SSID() const;
+    String psk() const;
+    uint8_t* BSSID();
+    int32_t channel();
+    int32_t RSSI();
+
+    bool softAP(const char *ssid, const char *psk = nullptr, int channel = 1, int hidden = 0, int maxConnections = 4);
+    bool softAPdisconnect(bool wifiOff = false);
+    IPAddress softAPIP();
+
+    int hostByName(const char *name, IPAddress &address);
+
+    int8_t scanNetworks(bool async = false, bool showHidden = false);
+    int8_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t index);
+    int32_t RSSI(uint8_t index);
+    uint8_t encryptionType(uint8_t index);
+    int32_t channel(uint8_t index);
+
+    WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> handler);
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> handler);
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> handler);
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ESP8266MDNS_H
+#define ESP8266MDNS_H
+
+#include <Arduino.h>
+
+class MDNSResponder{
+public:
+    bool begin(const char *hostname);
+    bool update();
+};
+
+extern MDNSResponder MDNS;
+
+#endif
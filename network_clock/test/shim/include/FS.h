@@ -0,0 +1,50 @@
+#ifndef FS_H
+#define FS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+/*
+ * File in the directory standing in for the flash filesystem.
+ */
+class File : public Stream{
+public:
+    File(){}
+    File(std::shared_ptr<FILE> file, const char *name);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t *buffer, size_t size);
+    bool seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    const char* name() const;
+    void flush() override;
+    void close();
+    operator bool() const;
+
+private:
+    std::shared_ptr<FILE> _file;
+    std::string _name;
+};
+
+class FS{
+public:
+    bool begin();
+    void end();
+    File open(const char *path, const char *mode);
+    File open(const String &path, const char *mode);
+    bool exists(const char *path);
+    bool exists(const String &path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+};
+
+extern FS SPIFFS;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include <IPAddress.h>
+
+/*
+ * Controls the host build from tests. Everything the SDK does behind
+ * the sketch, Wi-Fi events, lwIP receive callbacks, DNS answers and scan
+ * results, is queued and only runs from runSystem(), which yield() and
+ * delay() call the way they do on the chip. A test running the sketch
+ * calls loop() and runSystem() in turn, like the core does.
+ */
+class Host{
+public:
+    //Clears all network, flash and pin state between tests
+    static void reset();
+
+    //Time runs on the real clock until a test sets it, then only moves on advance()
+    static void setTime(uint64_t micros);
+    static void advance(uint64_t micros);
+    static void useRealTime();
+    static bool isVirtualTime();
+
+    static void runSystem();
+    static void schedule(std::function<void(void)> work, uint32_t delayMicros = 0);
+
+    static void setPin(uint8_t pin, uint8_t level);
+    static uint8_t getPin(uint8_t pin);
+    static void fireTimer();
+
+    static void setChipId(uint32_t id);
+    static void setResetReason(uint32_t reason);
+    static uint32_t getRestarts();
+    static void echoSerial(bool echo);
+
+    //SPIFFS lives in a directory, a fresh temporary one unless set
+    static void setFsRoot(const char *path);
+    static const char* getFsRoot();
+    static const std::vector<uint8_t>& getUpdateImage();
+    static void setSketchSpace(uint32_t size);
+
+    //Station side, networks a begin() can join and what DHCP hands out
+    static void addNetwork(const char *ssid, const char *psk, IPAddress address, int32_t rssi = -60);
+    static void dropNetwork(uint8_t reason = 8);
+    static void setAssociationDelay(uint32_t micros);
+
+    //Address that pcbs created from now on send from, 0 is the station address
+    static void setNode(IPAddress address);
+    static IPAddress getNode();
+    static void setLatency(uint32_t micros);
+    static void sendUdp(IPAddress from, uint16_t fromPort, IPAddress to, uint16_t toPort, const uint8_t *data, size_t length);
+    static uint32_t getDropped();
+
+    static void addHost(const char *name, IPAddress address);
+    static void setDnsDelay(uint32_t micros);
+
+    //Web server binds 127.0.0.1 on a free port, this is the one it got
+    static uint16_t getServerPort();
+};
+
+#endif
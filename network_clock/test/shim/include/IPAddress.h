@@ -0,0 +1,37 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <stdint.h>
+#include <Print.h>
+
+/*
+ * IPv4 address stored the way lwIP keeps it, first octet in the low byte.
+ */
+class IPAddress : public Printable{
+public:
+    IPAddress();
+    IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth);
+    IPAddress(uint32_t address);
+
+    operator uint32_t() const;
+    uint8_t operator[](int index) const;
+    uint8_t& operator[](int index);
+    bool operator==(const IPAddress &other) const;
+    bool operator!=(const IPAddress &other) const;
+
+    bool fromString(const char *text);
+    String toString() const;
+    size_t printTo(Print &out) const override;
+    bool isSet() const;
+    uint32_t v4() const;
+
+private:
+    union{
+        uint8_t bytes[4];
+        uint32_t dword;
+    } _address;
+};
+
+extern const IPAddress INADDR_NONE;
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MD5BUILDER_H
+#define MD5BUILDER_H
+
+#include <Arduino.h>
+#include <vector>
+
+/*
+ * MD5 of everything added, RFC 1321. Data is kept until calculate(),
+ * images on the host are small enough.
+ */
+class MD5Builder{
+public:
+    void begin();
+    void add(const uint8_t *data, size_t length);
+    void add(const char *data);
+    void calculate();
+    void getBytes(uint8_t *output);
+    String toString();
+
+private:
+    std::vector<uint8_t> _data;
+    uint8_t _digest[16];
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <WString.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print;
+
+class Printable{
+public:
+    virtual ~Printable(){}
+    virtual size_t printTo(Print &out) const = 0;
+};
+
+class Print{
+public:
+    virtual ~Print(){}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *text);
+    size_t write(const char *buffer, size_t size);
+
+    size_t print(const char *text);
+    size_t print(const String &text);
+    size_t print(const __FlashStringHelper *text);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+    size_t print(const Printable &value);
+
+    size_t println();
+    template<typename T> size_t println(const T &value){
+        size_t written = print(value);
+        return written + println();
+    }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    size_t printf_P(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    virtual void flush(){}
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0
+
+struct SPISettings{
+    SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0){}
+};
+
+//Shift register bytes go nowhere, the display buffer is what tests look at
+class SPIClass{
+public:
+    void begin();
+    void end();
+    void beginTransaction(SPISettings settings);
+    void endTransaction();
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <Print.h>
+
+class Stream : public Print{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytesUntil(char terminator, char *buffer, size_t length);
+    String readStringUntil(char terminator);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef UPDATER_H
+#define UPDATER_H
+
+#include <Arduino.h>
+#include <string>
+
+#define U_FLASH 0
+#define U_FS 100
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_SPACE 4
+#define UPDATE_ERROR_SIZE 5
+#define UPDATE_ERROR_MD5 8
+#define UPDATE_ERROR_MAGIC_BYTE 10
+
+/*
+ * Writes the image into a file standing in for the update partition.
+ */
+class UpdaterClass{
+public:
+    bool begin(size_t size, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW);
+    size_t write(uint8_t *data, size_t length);
+    bool end(bool evenIfRemaining = false);
+    bool setMD5(const char *expected);
+    bool isRunning();
+    bool hasError();
+    uint8_t getError();
+    size_t progress();
+
+private:
+    FILE *_file = nullptr;
+    size_t _size = 0;
+    size_t _written = 0;
+    uint8_t _error = UPDATE_ERROR_OK;
+    std::string _md5;
+};
+
+extern UpdaterClass Update;
+
+#endif
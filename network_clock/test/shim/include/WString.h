@@ -0,0 +1,60 @@
+#ifndef WSTRING_H
+#define WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class __FlashStringHelper;
+
+/*
+ * Arduino String on top of std::string, only what the firmware uses.
+ */
+class String{
+public:
+    String(const char *text = "");
+    String(const String &other) = default;
+    String(const __FlashStringHelper *text);
+    explicit String(char c);
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+
+    String& operator=(const String &other) = default;
+    String& operator=(const char *text);
+    String& operator+=(const String &other);
+    String& operator+=(const char *text);
+    String& operator+=(char c);
+    friend String operator+(const String &left, const String &right);
+    friend String operator+(const String &left, const char *right);
+
+    bool operator==(const String &other) const;
+    bool operator!=(const String &other) const;
+    bool operator==(const char *text) const;
+    bool operator!=(const char *text) const;
+    bool equals(const String &other) const;
+    bool equals(const char *text) const;
+    bool startsWith(const String &prefix) const;
+    bool endsWith(const String &suffix) const;
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const char *text, unsigned int from = 0) const;
+    int indexOf(const String &text, unsigned int from = 0) const;
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    void toLowerCase();
+    void trim();
+
+    long toInt() const;
+    const char* c_str() const;
+    unsigned int length() const;
+    bool reserve(unsigned int size);
+    char operator[](unsigned int index) const;
+    char& operator[](unsigned int index);
+
+private:
+    std::string _text;
+};
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef FLASH_HAL_H
+#define FLASH_HAL_H
+
+//Layout of a 4M board with 1M of filesystem
+#define FS_start 0x200000
+#define FS_end 0x3FA000
+
+#endif
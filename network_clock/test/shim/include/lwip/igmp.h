@@ -0,0 +1,12 @@
+#ifndef LWIP_IGMP_H
+#define LWIP_IGMP_H
+
+#include <lwip/err.h>
+#include <lwip/ip_addr.h>
+
+extern "C" {
+err_t igmp_joingroup(const ip4_addr_t *local, const ip4_addr_t *group);
+err_t igmp_leavegroup(const ip4_addr_t *local, const ip4_addr_t *group);
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef LWIP_IP_ADDR_H
+#define LWIP_IP_ADDR_H
+
+#include <stdint.h>
+
+typedef struct ip_addr {
+    uint32_t addr;
+} ip_addr_t;
+typedef ip_addr_t ip4_addr_t;
+
+extern "C" const ip_addr_t ip_addr_any;
+
+#define IP_ADDR_ANY (&ip_addr_any)
+#define ip_2_ip4(address) (address)
+#define ip4_addr_get_u32(address) ((address)->addr)
+#define ip_addr_get_ip4_u32(address) ((address)->addr)
+#define ip_addr_set_ip4_u32(address, value) ((address)->addr = (value))
+
+#endif
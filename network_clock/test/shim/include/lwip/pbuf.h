@@ -0,0 +1,26 @@
+#ifndef LWIP_PBUF_H
+#define LWIP_PBUF_H
+
+#include <stdint.h>
+
+typedef enum { PBUF_TRANSPORT, PBUF_IP, PBUF_LINK, PBUF_RAW } pbuf_layer;
+typedef enum { PBUF_RAM, PBUF_ROM, PBUF_REF, PBUF_POOL } pbuf_type;
+
+//Always a single buffer on the host, next stays null
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    uint16_t tot_len;
+    uint16_t len;
+    uint16_t ref;
+};
+
+extern "C" {
+struct pbuf* pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type);
+uint8_t pbuf_free(struct pbuf *p);
+void pbuf_ref(struct pbuf *p);
+void pbuf_realloc(struct pbuf *p, uint16_t length);
+uint16_t pbuf_copy_partial(const struct pbuf *p, void *data, uint16_t length, uint16_t offset);
+}
+
+#endif
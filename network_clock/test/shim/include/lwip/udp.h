@@ -0,0 +1,20 @@
+#ifndef LWIP_UDP_H
+#define LWIP_UDP_H
+
+#include <lwip/err.h>
+#include <lwip/ip_addr.h>
+#include <lwip/pbuf.h>
+
+struct udp_pcb;
+typedef void (*udp_recv_fn)(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port);
+
+extern "C" {
+struct udp_pcb* udp_new(void);
+void udp_remove(struct udp_pcb *pcb);
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *address, uint16_t port);
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn receive, void *arg);
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *address, uint16_t port);
+void udp_set_multicast_ttl(struct udp_pcb *pcb, uint8_t ttl);
+}
+
+#endif
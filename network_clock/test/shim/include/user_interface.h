@@ -0,0 +1,41 @@
+#ifndef USER_INTERFACE_H
+#define USER_INTERFACE_H
+
+#include <stdint.h>
+
+struct station_config {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    uint8_t bssid_set;
+    uint8_t bssid[6];
+};
+
+enum wps_type { WPS_TYPE_DISABLE = 0, WPS_TYPE_PBC, WPS_TYPE_PIN, WPS_TYPE_DISPLAY, WPS_TYPE_MAX };
+enum wps_cb_status { WPS_CB_ST_SUCCESS = 0, WPS_CB_ST_FAILED, WPS_CB_ST_TIMEOUT, WPS_CB_ST_WEP, WPS_CB_ST_UNK };
+typedef void (*wps_st_cb_t)(int status);
+
+enum rst_reason { REASON_DEFAULT_RST = 0, REASON_WDT_RST, REASON_EXCEPTION_RST, REASON_SOFT_WDT_RST,
+    REASON_SOFT_RESTART, REASON_DEEP_SLEEP_AWAKE, REASON_EXT_SYS_RST };
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+extern "C" {
+bool wifi_station_get_config(struct station_config *config);
+bool wifi_station_connect(void);
+bool wifi_wps_enable(wps_type type);
+bool wifi_wps_disable(void);
+bool wifi_wps_start(void);
+bool wifi_set_wps_cb(wps_st_cb_t callback);
+uint32_t system_get_rtc_time(void);
+uint32_t system_rtc_clock_cali_proc(void);
+struct rst_info* system_get_rst_info(void);
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include <Arduino.h>
+#include <user_interface.h>
+#include "HostInternal.h"
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+volatile uint32_t hostRtcMemory[128];
+
+static bool virtualTime = false;
+static uint64_t virtualMicros = 0;
+static const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+static bool echo = false;
+
+uint32_t hostChipId = 0x00C0FFEE;
+static uint32_t resetReason = REASON_DEFAULT_RST;
+static uint32_t restarts = 0;
+
+static timercallback timerCallback = nullptr;
+
+typedef struct Pin_State_t {
+    uint8_t level;
+    void (*handler)(void*);
+    void *arg;
+    int mode;
+}Pin_State;
+static Pin_State pins[17];
+
+static void callHandler(void *arg){
+    ((void (*)(void))arg)();
+}
+
+uint64_t micros64(){
+    if(virtualTime){
+        return virtualMicros;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+unsigned long micros(){
+    return (uint32_t)micros64();
+}
+
+unsigned long millis(){
+    return (uint32_t)(micros64() / 1000);
+}
+
+void delay(unsigned long ms){
+    if(virtualTime){
+        virtualMicros += (uint64_t)ms * 1000;
+    } else if(ms > 0){
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+    Host::runSystem();
+}
+
+void delayMicroseconds(unsigned int us){
+    if(virtualTime){
+        virtualMicros += us;
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+void yield(){
+    Host::runSystem();
+}
+
+void Host::setTime(uint64_t micros){
+    virtualTime = true;
+    virtualMicros = micros;
+}
+
+void Host::advance(uint64_t micros){
+    if(!virtualTime){
+        setTime(micros64());
+    }
+    virtualMicros += micros;
+}
+
+void Host::useRealTime(){
+    virtualTime = false;
+}
+
+bool Host::isVirtualTime(){
+    return virtualTime;
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+    if(pin < 17 && mode == INPUT_PULLUP){
+        pins[pin].level = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level){
+    if(pin < 17){
+        pins[pin].level = level ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin){
+    return pin < 17 ? pins[pin].level : LOW;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode){
+    attachInterruptArg(pin, callHandler, (void*)handler, mode);
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void *arg, int mode){
+    if(pin < 17){
+        pins[pin].handler = handler;
+        pins[pin].arg = arg;
+        pins[pin].mode = mode;
+    }
+}
+
+void detachInterrupt(uint8_t pin){
+    if(pin < 17){
+        pins[pin].handler = nullptr;
+    }
+}
+
+/*
+ * Drives an input like the outside world would, the edge interrupt runs right away.
+ */
+void Host::setPin(uint8_t pin, uint8_t level){
+    if(pin >= 17){
+        return;
+    }
+    Pin_State &state = pins[pin];
+    uint8_t previous = state.level;
+    state.level = level ? HIGH : LOW;
+    if(state.handler == nullptr || previous == state.level){
+        return;
+    }
+    if(state.mode == CHANGE || (state.mode == RISING && state.level == HIGH) || (state.mode == FALLING && state.level == LOW)){
+        state.handler(state.arg);
+    }
+}
+
+uint8_t Host::getPin(uint8_t pin){
+    return pin < 17 ? pins[pin].level : LOW;
+}
+
+long random(long high){
+    return high > 0 ? rand() % high : 0;
+}
+
+long random(long low, long high){
+    return high > low ? low + random(high - low) : low;
+}
+
+void HardwareSerial::begin(unsigned long baud){
+}
+
+size_t HardwareSerial::write(uint8_t c){
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size){
+    if(echo){
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+int HardwareSerial::available(){
+    return 0;
+}
+
+int HardwareSerial::read(){
+    return -1;
+}
+
+int HardwareSerial::peek(){
+    return -1;
+}
+
+int HardwareSerial::availableForWrite(){
+    return 128;
+}
+
+void HardwareSerial::flush(){
+    if(echo){
+        fflush(stdout);
+    }
+}
+
+void Host::echoSerial(bool enabled){
+    echo = enabled;
+}
+
+void EspClass::restart(){
+    restarts++;
+}
+
+uint32_t EspClass::getChipId(){
+    return hostChipId;
+}
+
+uint32_t EspClass::getCycleCount(){
+    return (uint32_t)(micros64() * getCpuFreqMHz());
+}
+
+uint8_t EspClass::getCpuFreqMHz(){
+    return 80;
+}
+
+uint32_t EspClass::getFreeHeap(){
+    return 40000;
+}
+
+uint32_t EspClass::random(){
+    return (uint32_t)rand() << 16 ^ (uint32_t)rand();
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size){
+    if(offset * 4 + size > sizeof(hostRtcMemory) || size % 4 != 0){
+        return false;
+    }
+    for(size_t i = 0; i < size / 4; i++){
+        data[i] = hostRtcMemory[offset + i];
+    }
+    return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size){
+    if(offset * 4 + size > sizeof(hostRtcMemory) || size % 4 != 0){
+        return false;
+    }
+    for(size_t i = 0; i < size / 4; i++){
+        hostRtcMemory[offset + i] = data[i];
+    }
+    return true;
+}
+
+void Host::setChipId(uint32_t id){
+    hostChipId = id;
+}
+
+void Host::setResetReason(uint32_t reason){
+    resetReason = reason;
+}
+
+uint32_t Host::getRestarts(){
+    return restarts;
+}
+
+void timer1_isr_init(void){
+}
+
+void timer1_enable(uint8_t divider, uint8_t interrupt, uint8_t reload){
+}
+
+void timer1_disable(void){
+}
+
+void timer1_attachInterrupt(timercallback callback){
+    timerCallback = callback;
+}
+
+void timer1_detachInterrupt(void){
+    timerCallback = nullptr;
+}
+
+void timer1_write(uint32_t ticks){
+}
+
+void Host::fireTimer(){
+    if(timerCallback != nullptr){
+        timerCallback();
+    }
+}
+
+void panic(void){
+    fflush(stdout);
+    abort();
+}
+
+//RTC ticks are 5.75us at the calibration the SDK usually reports
+extern "C" uint32_t system_rtc_clock_cali_proc(void){
+    return 23552;
+}
+
+extern "C" uint32_t system_get_rtc_time(void){
+    return (uint32_t)((micros64() << 12) / system_rtc_clock_cali_proc());
+}
+
+extern "C" struct rst_info* system_get_rst_info(void){
+    static struct rst_info info;
+    info.reason = resetReason;
+    return &info;
+}
+
+void hostResetPins(){
+    for(Pin_State &state : pins){
+        state = Pin_State{HIGH, nullptr, nullptr, 0};
+    }
+    timerCallback = nullptr;
+    restarts = 0;
+    resetReason = REASON_DEFAULT_RST;
+}
@@ -0,0 +1,464 @@
+#include "ESP8266WebServer.h"
+#include "HostInternal.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <strings.h>
+
+static const char* reason(int code){
+    switch(code){
+    case 200: return "OK";
+    case 302: return "Found";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 500: return "Internal Server Error";
+    default: return "";
+    }
+}
+
+static String urlDecode(const std::string &text){
+    std::string decoded;
+    for(size_t i = 0; i < text.size(); i++){
+        if(text[i] == '+'){
+            decoded += ' ';
+        } else if(text[i] == '%' && i + 2 < text.size()){
+            decoded += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else {
+            decoded += text[i];
+        }
+    }
+    return String(decoded.c_str());
+}
+
+ESP8266WebServer::ESP8266WebServer(int port) : _port(port){
+}
+
+ESP8266WebServer::~ESP8266WebServer(){
+    close();
+}
+
+void ESP8266WebServer::begin(){
+    close();
+    _listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    if(bind(_listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(_listener, 128) != 0){
+        ::close(_listener);
+        _listener = -1;
+        return;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(_listener, (sockaddr*)&address, &length);
+    hostServerPort = ntohs(address.sin_port);
+    fcntl(_listener, F_SETFL, fcntl(_listener, F_GETFL) | O_NONBLOCK);
+}
+
+void ESP8266WebServer::close(){
+    if(_listener >= 0){
+        ::close(_listener);
+        _listener = -1;
+    }
+}
+
+void ESP8266WebServer::handleClient(){
+    if(_listener < 0){
+        return;
+    }
+    _client = accept(_listener, nullptr, nullptr);
+    if(_client < 0){
+        return;
+    }
+    timeval timeout = {HTTP_MAX_DATA_WAIT / 1000, 0};
+    setsockopt(_client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(_client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int noDelay = 1;
+    setsockopt(_client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    if(readRequest()){
+        bool handled = false;
+        if(_currentHandler != nullptr){
+            handled = _currentHandler->handle(*this, _method, _uri);
+        }
+        if(!handled && _notFound){
+            _notFound();
+            handled = true;
+        }
+        if(!handled){
+            send(404, "text/html", String("Not found: ") + _uri);
+        }
+    }
+    ::close(_client);
+    _client = -1;
+}
+
+bool ESP8266WebServer::readLine(std::string &line){
+    while(true){
+        size_t end = _pending.find("\r\n");
+        if(end != std::string::npos){
+            line = _pending.substr(0, end);
+            _pending.erase(0, end + 2);
+            return true;
+        }
+        char buffer[1024];
+        ssize_t received = recv(_client, buffer, sizeof(buffer), 0);
+        if(received <= 0){
+            return false;
+        }
+        _pending.append(buffer, received);
+    }
+}
+
+bool ESP8266WebServer::readBody(size_t length, std::string &body){
+    while(_pending.size() < length){
+        char buffer[4096];
+        ssize_t received = recv(_client, buffer, sizeof(buffer), 0);
+        if(received <= 0){
+            return false;
+        }
+        _pending.append(buffer, received);
+    }
+    body = _pending.substr(0, length);
+    _pending.erase(0, length);
+    return true;
+}
+
+bool ESP8266WebServer::readRequest(){
+    _pending.clear();
+    _args.clear();
+    _headers.clear();
+    _hostHeader = "";
+    _responseHeaders.clear();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _chunked = false;
+    _sent = false;
+    _currentHandler = nullptr;
+
+    std::string line;
+    if(!readLine(line)){
+        return false;
+    }
+    size_t methodEnd = line.find(' ');
+    size_t uriEnd = line.find(' ', methodEnd + 1);
+    if(methodEnd == std::string::npos || uriEnd == std::string::npos){
+        return false;
+    }
+    std::string method = line.substr(0, methodEnd);
+    std::string target = line.substr(methodEnd + 1, uriEnd - methodEnd - 1);
+    _method = method == "POST" ? HTTP_POST : method == "PUT" ? HTTP_PUT : method == "PATCH" ? HTTP_PATCH :
+        method == "DELETE" ? HTTP_DELETE : method == "OPTIONS" ? HTTP_OPTIONS : method == "HEAD" ? HTTP_HEAD : HTTP_GET;
+    size_t query = target.find('?');
+    _uri = String(target.substr(0, query).c_str());
+    if(query != std::string::npos){
+        parseArgs(target.substr(query + 1));
+    }
+
+    size_t contentLength = 0;
+    std::string contentType;
+    while(readLine(line) && !line.empty()){
+        size_t colon = line.find(':');
+        if(colon == std::string::npos){
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+        if(strcasecmp(name.c_str(), "Host") == 0){
+            _hostHeader = value.c_str();
+        } else if(strcasecmp(name.c_str(), "Content-Length") == 0){
+            contentLength = strtoul(value.c_str(), nullptr, 10);
+        } else if(strcasecmp(name.c_str(), "Content-Type") == 0){
+            contentType = value;
+        }
+        for(const String &key : _headerKeys){
+            if(strcasecmp(key.c_str(), name.c_str()) == 0){
+                _headers.emplace_back(key, String(value.c_str()));
+            }
+        }
+    }
+    if(!line.empty()){
+        return false;
+    }
+
+    for(RequestHandler *handler = _firstHandler; handler != nullptr; handler = handler->next()){
+        if(handler->canHandle(_method, _uri)){
+            _currentHandler = handler;
+            break;
+        }
+    }
+
+    if(contentLength > 0){
+        std::string body;
+        if(!readBody(contentLength, body)){
+            return false;
+        }
+        size_t boundary = contentType.find("boundary=");
+        if(contentType.find("application/x-www-form-urlencoded") == 0){
+            parseArgs(body);
+        } else if(contentType.find("multipart/form-data") == 0 && boundary != std::string::npos){
+            parseMultipart(body, contentType.substr(boundary + 9));
+        } else {
+            _args.emplace_back(String("plain"), String(body.c_str()));
+        }
+    }
+    return true;
+}
+
+void ESP8266WebServer::parseArgs(const std::string &query){
+    size_t start = 0;
+    while(start < query.size()){
+        size_t end = query.find('&', start);
+        if(end == std::string::npos){
+            end = query.size();
+        }
+        std::string pair = query.substr(start, end - start);
+        size_t equals = pair.find('=');
+        if(!pair.empty()){
+            _args.emplace_back(urlDecode(pair.substr(0, equals)),
+                equals == std::string::npos ? String("") : urlDecode(pair.substr(equals + 1)));
+        }
+        start = end + 1;
+    }
+}
+
+/*
+ * Form fields become args, files go to the upload handler in pieces.
+ */
+void ESP8266WebServer::parseMultipart(const std::string &body, const std::string &boundary){
+    std::string delimiter = "--" + boundary;
+    size_t position = body.find(delimiter);
+    while(position != std::string::npos){
+        position += delimiter.size();
+        if(body.compare(position, 2, "--") == 0){
+            return;
+        }
+        size_t headersEnd = body.find("\r\n\r\n", position);
+        if(headersEnd == std::string::npos){
+            return;
+        }
+        std::string headers = body.substr(position, headersEnd - position);
+        size_t dataStart = headersEnd + 4;
+        size_t next = body.find("\r\n" + delimiter, dataStart);
+        if(next == std::string::npos){
+            return;
+        }
+        std::string data = body.substr(dataStart, next - dataStart);
+
+        auto field = [&headers](const char *key) -> std::string{
+            size_t start = headers.find(key);
+            if(start == std::string::npos){
+                return "";
+            }
+            start += strlen(key);
+            return headers.substr(start, headers.find('"', start) - start);
+        };
+        std::string name = field("name=\"");
+        std::string filename = field("filename=\"");
+        if(filename.empty()){
+            _args.emplace_back(String(name.c_str()), String(data.c_str()));
+        } else if(_currentHandler != nullptr && _currentHandler->canUpload(_uri)){
+            _upload.status = UPLOAD_FILE_START;
+            _upload.name = name.c_str();
+            _upload.filename = filename.c_str();
+            _upload.type = field("Content-Type: ").c_str();
+            _upload.totalSize = 0;
+            _upload.currentSize = 0;
+            _upload.contentLength = body.size();
+            _currentHandler->upload(*this, _uri, _upload);
+            for(size_t offset = 0; offset < data.size(); offset += HTTP_UPLOAD_BUFLEN){
+                _upload.status = UPLOAD_FILE_WRITE;
+                _upload.currentSize = std::min((size_t)HTTP_UPLOAD_BUFLEN, data.size() - offset);
+                memcpy(_upload.buf, data.data() + offset, _upload.currentSize);
+                _upload.totalSize += _upload.currentSize;
+                _currentHandler->upload(*this, _uri, _upload);
+            }
+            _upload.status = UPLOAD_FILE_END;
+            _upload.currentSize = 0;
+            _currentHandler->upload(*this, _uri, _upload);
+        }
+        position = next + 2;
+    }
+}
+
+void ESP8266WebServer::addHandler(RequestHandler *handler){
+    if(_lastHandler == nullptr){
+        _firstHandler = handler;
+    } else {
+        _lastHandler->next(handler);
+    }
+    _lastHandler = handler;
+}
+
+void ESP8266WebServer::onNotFound(THandlerFunction handler){
+    _notFound = handler;
+}
+
+String ESP8266WebServer::uri(){
+    return _uri;
+}
+
+HTTPMethod ESP8266WebServer::method(){
+    return _method;
+}
+
+HTTPUpload& ESP8266WebServer::upload(){
+    return _upload;
+}
+
+String ESP8266WebServer::arg(const String &name){
+    for(auto &arg : _args){
+        if(arg.first == name){
+            return arg.second;
+        }
+    }
+    return String("");
+}
+
+bool ESP8266WebServer::hasArg(const String &name){
+    for(auto &arg : _args){
+        if(arg.first == name){
+            return true;
+        }
+    }
+    return false;
+}
+
+int ESP8266WebServer::args(){
+    return _args.size();
+}
+
+void ESP8266WebServer::collectHeaders(const char *headerKeys[], const size_t count){
+    _headerKeys.clear();
+    for(size_t i = 0; i < count; i++){
+        _headerKeys.emplace_back(headerKeys[i]);
+    }
+}
+
+String ESP8266WebServer::header(const String &name){
+    for(auto &header : _headers){
+        if(strcasecmp(header.first.c_str(), name.c_str()) == 0){
+            return header.second;
+        }
+    }
+    return String("");
+}
+
+bool ESP8266WebServer::hasHeader(const String &name){
+    for(auto &header : _headers){
+        if(strcasecmp(header.first.c_str(), name.c_str()) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+String ESP8266WebServer::hostHeader(){
+    return _hostHeader;
+}
+
+void ESP8266WebServer::writeRaw(const char *data, size_t length){
+    while(_client >= 0 && length > 0){
+        ssize_t written = ::send(_client, data, length, MSG_NOSIGNAL);
+        if(written <= 0){
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+void ESP8266WebServer::sendHeaders(int code, const char *contentType, size_t length){
+    char line[64];
+    snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, reason(code));
+    std::string head = line;
+    if(contentType != nullptr && contentType[0] != '\0'){
+        head += std::string("Content-Type: ") + contentType + "\r\n";
+    }
+    if(_contentLength == CONTENT_LENGTH_UNKNOWN){
+        _chunked = true;
+        head += "Transfer-Encoding: chunked\r\n";
+    } else {
+        snprintf(line, sizeof(line), "Content-Length: %u\r\n", (unsigned int)(_contentLength == CONTENT_LENGTH_NOT_SET ? length : _contentLength));
+        head += line;
+    }
+    head += _responseHeaders;
+    head += "Connection: close\r\n\r\n";
+    writeRaw(head.data(), head.size());
+    _responseHeaders.clear();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _sent = true;
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const String &content){
+    send(code, contentType, content.c_str());
+}
+
+void ESP8266WebServer::send(int code, const String &contentType, const String &content){
+    send(code, contentType.c_str(), content.c_str());
+}
+
+void ESP8266WebServer::send(int code, const char *contentType, const char *content){
+    size_t length = content != nullptr ? strlen(content) : 0;
+    sendHeaders(code, contentType, length);
+    if(length > 0){
+        sendContent(content, length);
+    }
+}
+
+void ESP8266WebServer::setContentLength(size_t length){
+    _contentLength = length;
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first){
+    std::string line = std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    _responseHeaders = first ? line + _responseHeaders : _responseHeaders + line;
+}
+
+void ESP8266WebServer::sendContent(const String &content){
+    sendContent(content.c_str(), content.length());
+}
+
+void ESP8266WebServer::sendContent(const char *content){
+    sendContent(content, strlen(content));
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t length){
+    if(!_chunked){
+        writeRaw(content, length);
+        return;
+    }
+    char size[16];
+    snprintf(size, sizeof(size), "%x\r\n", (unsigned int)length);
+    writeRaw(size, strlen(size));
+    writeRaw(content, length);
+    writeRaw("\r\n", 2);
+    if(length == 0){
+        _chunked = false;
+    }
+}
+
+size_t ESP8266WebServer::streamFile(File &file, const String &contentType){
+    String name(file.name());
+    if(name.endsWith(".gz") && contentType != "application/x-gzip" && contentType != "application/octet-stream"){
+        sendHeader("Content-Encoding", "gzip");
+    }
+    setContentLength(file.size());
+    sendHeaders(200, contentType.c_str(), file.size());
+    uint8_t buffer[1460];
+    size_t total = 0;
+    size_t length;
+    while((length = file.read(buffer, sizeof(buffer))) > 0){
+        writeRaw((const char*)buffer, length);
+        total += length;
+    }
+    return total;
+}
@@ -0,0 +1,351 @@
+#include "ESP8266WiFi.h"
+#include "HostInternal.h"
+#include <user_interface.h>
+#include <string>
+#include <vector>
+
+ESP8266WiFiClass WiFi;
+
+struct WiFiEventHandlerOpaque {
+    std::function<void(const WiFiEventStationModeConnected&)> connected;
+    std::function<void(const WiFiEventStationModeDisconnected&)> disconnected;
+    std::function<void(const WiFiEventStationModeGotIP&)> gotIP;
+};
+
+typedef struct Host_Network_t {
+    std::string ssid;
+    std::string psk;
+    IPAddress address;
+    int32_t rssi;
+}Host_Network;
+
+static std::vector<Host_Network> networks;
+static std::vector<std::weak_ptr<WiFiEventHandlerOpaque>> handlers;
+static std::vector<Host_Network> scanResults;
+static int8_t scanState = WIFI_SCAN_FAILED;
+static uint32_t associationDelay = 0;
+static uint32_t attempt = 0; //Joins in flight are dropped when a newer one starts
+
+static WiFiMode_t wifiMode = WIFI_OFF;
+static wl_status_t stationStatus = WL_DISCONNECTED;
+static std::string stationSsid;
+static std::string stationPsk;
+static uint8_t stationBssid[6];
+static int32_t stationChannel = 0;
+static int32_t stationRssi = 0;
+static IPAddress stationAddress;
+static IPAddress staticAddress;
+static IPAddress staticGateway;
+static IPAddress staticSubnet;
+static IPAddress staticDns;
+static bool apActive = false;
+
+static void emitDisconnected(WiFiDisconnectReason reason){
+    WiFiEventStationModeDisconnected event;
+    event.ssid = stationSsid.c_str();
+    memcpy(event.bssid, stationBssid, sizeof(event.bssid));
+    event.reason = reason;
+    for(auto &weak : handlers){
+        auto handler = weak.lock();
+        if(handler && handler->disconnected){
+            handler->disconnected(event);
+        }
+    }
+}
+
+static void join(uint32_t id){
+    if(id != attempt){
+        return;
+    }
+    for(const Host_Network &network : networks){
+        if(network.ssid != stationSsid){
+            continue;
+        }
+        if(network.psk != stationPsk){
+            stationStatus = WL_WRONG_PASSWORD;
+            emitDisconnected(WIFI_DISCONNECT_REASON_AUTH_FAIL);
+            return;
+        }
+        stationStatus = WL_CONNECTED;
+        stationRssi = network.rssi;
+        stationAddress = staticAddress.isSet() ? staticAddress : network.address;
+        if(stationChannel == 0){
+            stationChannel = 1;
+        }
+        WiFiEventStationModeConnected connected;
+        connected.ssid = stationSsid.c_str();
+        memcpy(connected.bssid, stationBssid, sizeof(connected.bssid));
+        connected.channel = stationChannel;
+        WiFiEventStationModeGotIP gotIP;
+        gotIP.ip = stationAddress;
+        gotIP.mask = WiFi.subnetMask();
+        gotIP.gw = WiFi.gatewayIP();
+        for(auto &weak : handlers){
+            auto handler = weak.lock();
+            if(handler && handler->connected){
+                handler->connected(connected);
+            }
+        }
+        for(auto &weak : handlers){
+            auto handler = weak.lock();
+            if(handler && handler->gotIP){
+                handler->gotIP(gotIP);
+            }
+        }
+        return;
+    }
+    stationStatus = WL_NO_SSID_AVAIL;
+    emitDisconnected(WIFI_DISCONNECT_REASON_NO_AP_FOUND);
+}
+
+void hostAddNetwork(const char *ssid, const char *psk, IPAddress address, int32_t rssi){
+    networks.push_back(Host_Network{ssid, psk != nullptr ? psk : "", address, rssi});
+}
+
+void hostDropNetwork(uint8_t reason){
+    if(stationStatus != WL_CONNECTED){
+        return;
+    }
+    attempt++;
+    stationStatus = WL_CONNECTION_LOST;
+    Host::schedule([reason](){ emitDisconnected((WiFiDisconnectReason)reason); });
+}
+
+void hostSetAssociationDelay(uint32_t micros){
+    associationDelay = micros;
+}
+
+IPAddress hostStationAddress(){
+    return WiFi.localIP();
+}
+
+void hostResetWiFi(){
+    networks.clear();
+    //Handlers belong to objects that outlive a reset, dead ones are skipped anyway
+    scanResults.clear();
+    scanState = WIFI_SCAN_FAILED;
+    associationDelay = 0;
+    attempt++;
+    wifiMode = WIFI_OFF;
+    stationStatus = WL_DISCONNECTED;
+    stationSsid.clear();
+    stationPsk.clear();
+    memset(stationBssid, 0, sizeof(stationBssid));
+    stationChannel = 0;
+    stationAddress = IPAddress();
+    staticAddress = IPAddress();
+    staticGateway = IPAddress();
+    staticSubnet = IPAddress();
+    staticDns = IPAddress();
+    apActive = false;
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t mode){
+    wifiMode = mode;
+    return true;
+}
+
+WiFiMode_t ESP8266WiFiClass::getMode(){
+    return wifiMode;
+}
+
+bool ESP8266WiFiClass::persistent(bool persistent){
+    return true;
+}
+
+bool ESP8266WiFiClass::setAutoReconnect(bool autoReconnect){
+    return true;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *psk, int32_t channel, const uint8_t *bssid, bool connect){
+    stationSsid = ssid != nullptr ? ssid : "";
+    stationPsk = psk != nullptr ? psk : "";
+    stationChannel = channel;
+    if(bssid != nullptr){
+        memcpy(stationBssid, bssid, sizeof(stationBssid));
+    }
+    return connect ? begin() : stationStatus;
+}
+
+wl_status_t ESP8266WiFiClass::begin(){
+    stationStatus = WL_DISCONNECTED;
+    stationAddress = IPAddress();
+    uint32_t id = ++attempt;
+    Host::schedule([id](){ join(id); }, associationDelay);
+    return stationStatus;
+}
+
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2){
+    staticAddress = local;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns1;
+    return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff){
+    attempt++;
+    bool connected = stationStatus == WL_CONNECTED;
+    stationStatus = WL_DISCONNECTED;
+    stationAddress = IPAddress();
+    if(connected){
+        Host::schedule([](){ emitDisconnected(WIFI_DISCONNECT_REASON_ASSOC_LEAVE); });
+    }
+    return true;
+}
+
+wl_status_t ESP8266WiFiClass::status(){
+    return stationStatus;
+}
+
+bool ESP8266WiFiClass::isConnected(){
+    return stationStatus == WL_CONNECTED;
+}
+
+IPAddress ESP8266WiFiClass::localIP(){
+    return isConnected() ? stationAddress : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::subnetMask(){
+    return staticSubnet.isSet() ? staticSubnet : IPAddress(255, 255, 255, 0);
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP(){
+    if(staticGateway.isSet()){
+        return staticGateway;
+    }
+    IPAddress gateway = stationAddress;
+    gateway[3] = 1;
+    return gateway;
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t index){
+    return staticDns.isSet() ? staticDns : gatewayIP();
+}
+
+String ESP8266WiFiClass::SSID() const{
+    return String(stationSsid.c_str());
+}
+
+String ESP8266WiFiClass::psk() const{
+    return String(stationPsk.c_str());
+}
+
+uint8_t* ESP8266WiFiClass::BSSID(){
+    return stationBssid;
+}
+
+int32_t ESP8266WiFiClass::channel(){
+    return stationChannel;
+}
+
+int32_t ESP8266WiFiClass::RSSI(){
+    return isConnected() ? stationRssi : 31;
+}
+
+bool ESP8266WiFiClass::softAP(const char *ssid, const char *psk, int channel, int hidden, int maxConnections){
+    apActive = true;
+    return true;
+}
+
+bool ESP8266WiFiClass::softAPdisconnect(bool wifiOff){
+    apActive = false;
+    return true;
+}
+
+IPAddress ESP8266WiFiClass::softAPIP(){
+    return apActive ? IPAddress(192, 168, 4, 1) : IPAddress();
+}
+
+int ESP8266WiFiClass::hostByName(const char *name, IPAddress &address){
+    return hostResolve(name, address) ? 1 : 0;
+}
+
+int8_t ESP8266WiFiClass::scanNetworks(bool async, bool showHidden){
+    scanState = WIFI_SCAN_RUNNING;
+    auto complete = [](){
+        scanResults = networks;
+        scanState = scanResults.size();
+    };
+    if(!async){
+        complete();
+        return scanState;
+    }
+    Host::schedule(complete);
+    return WIFI_SCAN_RUNNING;
+}
+
+int8_t ESP8266WiFiClass::scanComplete(){
+    return scanState;
+}
+
+void ESP8266WiFiClass::scanDelete(){
+    scanResults.clear();
+    scanState = WIFI_SCAN_FAILED;
+}
+
+String ESP8266WiFiClass::SSID(uint8_t index){
+    return index < scanResults.size() ? String(scanResults[index].ssid.c_str()) : String("");
+}
+
+int32_t ESP8266WiFiClass::RSSI(uint8_t index){
+    return index < scanResults.size() ? scanResults[index].rssi : 0;
+}
+
+uint8_t ESP8266WiFiClass::encryptionType(uint8_t index){
+    return index < scanResults.size() && !scanResults[index].psk.empty() ? ENC_TYPE_CCMP : ENC_TYPE_NONE;
+}
+
+int32_t ESP8266WiFiClass::channel(uint8_t index){
+    return 1 + index % 11;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> handler){
+    WiFiEventHandler opaque = std::make_shared<WiFiEventHandlerOpaque>();
+    opaque->connected = handler;
+    handlers.push_back(opaque);
+    return opaque;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> handler){
+    WiFiEventHandler opaque = std::make_shared<WiFiEventHandlerOpaque>();
+    opaque->disconnected = handler;
+    handlers.push_back(opaque);
+    return opaque;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> handler){
+    WiFiEventHandler opaque = std::make_shared<WiFiEventHandlerOpaque>();
+    opaque->gotIP = handler;
+    handlers.push_back(opaque);
+    return opaque;
+}
+
+extern "C" bool wifi_station_get_config(struct station_config *config){
+    memset(config, 0, sizeof(*config));
+    strncpy((char*)config->ssid, stationSsid.c_str(), sizeof(config->ssid));
+    strncpy((char*)config->password, stationPsk.c_str(), sizeof(config->password));
+    return true;
+}
+
+extern "C" bool wifi_station_connect(void){
+    WiFi.begin();
+    return true;
+}
+
+//WPS never completes on the host
+extern "C" bool wifi_wps_enable(wps_type type){
+    return true;
+}
+
+extern "C" bool wifi_wps_disable(void){
+    return true;
+}
+
+extern "C" bool wifi_wps_start(void){
+    return true;
+}
+
+extern "C" bool wifi_set_wps_cb(wps_st_cb_t callback){
+    return true;
+}
@@ -0,0 +1,142 @@
+#include "FS.h"
+#include "HostInternal.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+FS SPIFFS;
+
+static std::string fsRoot;
+
+static const std::string& root(){
+    if(fsRoot.empty()){
+        char path[] = "/tmp/spiffs-XXXXXX";
+        fsRoot = mkdtemp(path);
+    }
+    return fsRoot;
+}
+
+static std::string hostPath(const char *path){
+    return root() + (path[0] == '/' ? "" : "/") + path;
+}
+
+void hostSetFsRoot(const char *path){
+    fsRoot = path != nullptr ? path : "";
+}
+
+const char* hostGetFsRoot(){
+    return root().c_str();
+}
+
+File::File(std::shared_ptr<FILE> file, const char *name) : _file(file), _name(name){
+}
+
+size_t File::write(uint8_t c){
+    return _file ? fwrite(&c, 1, 1, _file.get()) : 0;
+}
+
+size_t File::write(const uint8_t *buffer, size_t size){
+    return _file ? fwrite(buffer, 1, size, _file.get()) : 0;
+}
+
+int File::available(){
+    return _file ? size() - position() : 0;
+}
+
+int File::read(){
+    return _file ? fgetc(_file.get()) : -1;
+}
+
+int File::peek(){
+    if(!_file){
+        return -1;
+    }
+    int c = fgetc(_file.get());
+    if(c >= 0){
+        ungetc(c, _file.get());
+    }
+    return c;
+}
+
+size_t File::read(uint8_t *buffer, size_t size){
+    return _file ? fread(buffer, 1, size, _file.get()) : 0;
+}
+
+bool File::seek(uint32_t position){
+    return _file && fseek(_file.get(), position, SEEK_SET) == 0;
+}
+
+size_t File::position() const{
+    return _file ? ftell(_file.get()) : 0;
+}
+
+size_t File::size() const{
+    if(!_file){
+        return 0;
+    }
+    fflush(_file.get());
+    struct stat info;
+    return fstat(fileno(_file.get()), &info) == 0 ? info.st_size : 0;
+}
+
+const char* File::name() const{
+    return _name.c_str();
+}
+
+void File::flush(){
+    if(_file){
+        fflush(_file.get());
+    }
+}
+
+void File::close(){
+    _file.reset();
+}
+
+File::operator bool() const{
+    return (bool)_file;
+}
+
+bool FS::begin(){
+    return true;
+}
+
+void FS::end(){
+}
+
+File FS::open(const char *path, const char *mode){
+    std::string full = hostPath(path);
+    if(mode[0] != 'r'){
+        //SPIFFS names just hold slashes, the host needs the directories
+        for(size_t slash = full.find('/', root().size() + 1); slash != std::string::npos; slash = full.find('/', slash + 1)){
+            mkdir(full.substr(0, slash).c_str(), 0755);
+        }
+    }
+    std::string fileMode = std::string(mode) + "b";
+    FILE *file = fopen(full.c_str(), fileMode.c_str());
+    if(file == nullptr){
+        return File();
+    }
+    return File(std::shared_ptr<FILE>(file, fclose), path);
+}
+
+File FS::open(const String &path, const char *mode){
+    return open(path.c_str(), mode);
+}
+
+bool FS::exists(const char *path){
+    struct stat info;
+    return stat(hostPath(path).c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+bool FS::exists(const String &path){
+    return exists(path.c_str());
+}
+
+bool FS::remove(const char *path){
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char *from, const char *to){
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include "HostInternal.h"
+#include <algorithm>
+
+uint16_t hostServerPort = 0;
+
+typedef struct Host_Work_t {
+    uint64_t due;
+    uint64_t order; //Same due time runs in the order it was scheduled
+    std::function<void(void)> work;
+}Host_Work;
+
+static std::vector<Host_Work> queue;
+static uint64_t scheduled = 0;
+static bool running = false;
+
+void Host::reset(){
+    queue.clear();
+    hostResetWiFi();
+    hostResetLwip();
+    hostResetUpdate();
+    hostResetPins();
+    for(size_t i = 0; i < sizeof(hostRtcMemory) / sizeof(hostRtcMemory[0]); i++){
+        hostRtcMemory[i] = 0;
+    }
+}
+
+void Host::schedule(std::function<void(void)> work, uint32_t delayMicros){
+    queue.push_back(Host_Work{micros64() + delayMicros, scheduled++, work});
+}
+
+/*
+ * Runs everything that is due, including work the callbacks schedule for now.
+ * Nested calls from a yield() inside a callback return right away.
+ */
+void Host::runSystem(){
+    if(running){
+        return;
+    }
+    running = true;
+    while(true){
+        uint64_t now = micros64();
+        auto next = queue.end();
+        for(auto item = queue.begin(); item != queue.end(); item++){
+            if(item->due <= now && (next == queue.end() || item->due < next->due ||
+                (item->due == next->due && item->order < next->order))){
+                next = item;
+            }
+        }
+        if(next == queue.end()){
+            break;
+        }
+        std::function<void(void)> work = std::move(next->work);
+        queue.erase(next);
+        work();
+    }
+    running = false;
+}
+
+void Host::setFsRoot(const char *path){
+    hostSetFsRoot(path);
+}
+
+const char* Host::getFsRoot(){
+    return hostGetFsRoot();
+}
+
+void Host::addNetwork(const char *ssid, const char *psk, IPAddress address, int32_t rssi){
+    hostAddNetwork(ssid, psk, address, rssi);
+}
+
+void Host::dropNetwork(uint8_t reason){
+    hostDropNetwork(reason);
+}
+
+void Host::setAssociationDelay(uint32_t micros){
+    hostSetAssociationDelay(micros);
+}
+
+uint16_t Host::getServerPort(){
+    return hostServerPort;
+}
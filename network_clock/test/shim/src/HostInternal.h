@@ -0,0 +1,25 @@
+#ifndef HOSTINTERNAL_H
+#define HOSTINTERNAL_H
+
+#include <stdint.h>
+#include <IPAddress.h>
+
+//Shared between the shim sources, tests only see Host.h
+extern uint16_t hostServerPort;
+extern uint32_t hostChipId;
+
+void hostSetFsRoot(const char *path);
+const char* hostGetFsRoot();
+
+void hostAddNetwork(const char *ssid, const char *psk, IPAddress address, int32_t rssi);
+void hostDropNetwork(uint8_t reason);
+void hostSetAssociationDelay(uint32_t micros);
+bool hostResolve(const char *name, IPAddress &address);
+IPAddress hostStationAddress();
+
+void hostResetWiFi();
+void hostResetLwip();
+void hostResetUpdate();
+void hostResetPins();
+
+#endif
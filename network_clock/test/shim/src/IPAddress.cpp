@@ -0,0 +1,73 @@
+#include "IPAddress.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+
+IPAddress::IPAddress(){
+    _address.dword = 0;
+}
+
+IPAddress::IPAddress(uint8_t first, uint8_t second, uint8_t third, uint8_t fourth){
+    _address.bytes[0] = first;
+    _address.bytes[1] = second;
+    _address.bytes[2] = third;
+    _address.bytes[3] = fourth;
+}
+
+IPAddress::IPAddress(uint32_t address){
+    _address.dword = address;
+}
+
+IPAddress::operator uint32_t() const{
+    return _address.dword;
+}
+
+uint8_t IPAddress::operator[](int index) const{
+    return _address.bytes[index];
+}
+
+uint8_t& IPAddress::operator[](int index){
+    return _address.bytes[index];
+}
+
+bool IPAddress::operator==(const IPAddress &other) const{
+    return _address.dword == other._address.dword;
+}
+
+bool IPAddress::operator!=(const IPAddress &other) const{
+    return _address.dword != other._address.dword;
+}
+
+bool IPAddress::fromString(const char *text){
+    uint8_t bytes[4];
+    for(uint8_t i = 0; i < 4; i++){
+        char *end;
+        long part = strtol(text, &end, 10);
+        if(end == text || part < 0 || part > 255 || (i < 3 ? *end != '.' : *end != '\0')){
+            return false;
+        }
+        bytes[i] = part;
+        text = end + 1;
+    }
+    *this = IPAddress(bytes[0], bytes[1], bytes[2], bytes[3]);
+    return true;
+}
+
+String IPAddress::toString() const{
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", _address.bytes[0], _address.bytes[1], _address.bytes[2], _address.bytes[3]);
+    return String(text);
+}
+
+size_t IPAddress::printTo(Print &out) const{
+    return out.print(toString());
+}
+
+bool IPAddress::isSet() const{
+    return _address.dword != 0;
+}
+
+uint32_t IPAddress::v4() const{
+    return _address.dword;
+}
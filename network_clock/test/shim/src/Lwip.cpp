@@ -0,0 +1,286 @@
+#include <Arduino.h>
+#include <lwip/udp.h>
+#include <lwip/igmp.h>
+#include <lwip/dns.h>
+#include "HostInternal.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * In-process UDP network. Every pcb belongs to a node address, the
+ * station's own unless a test set another one before creating it, so
+ * several firmware instances and fake servers share one process.
+ * Datagrams are queued and reach their receive callbacks in
+ * Host::runSystem(), never inside udp_sendto().
+ */
+struct udp_pcb {
+    uint32_t node; //0 follows the station address
+    uint16_t port;
+    udp_recv_fn receive;
+    void *arg;
+};
+
+extern "C" const ip_addr_t ip_addr_any = {0};
+
+static std::vector<udp_pcb*> pcbs;
+static std::vector<udp_pcb*> removed; //Freed once no delivery is walking the list
+static std::set<std::pair<uint32_t, uint32_t>> groups; //Node and group
+static uint32_t node = 0;
+static uint32_t latency = 0;
+static uint32_t dropped = 0;
+static uint16_t nextPort = 49152;
+static uint8_t delivering = 0;
+
+static std::map<std::string, IPAddress> hosts;
+static std::set<std::string> dnsCache;
+static uint32_t dnsDelay = 0;
+
+static uint32_t nodeOf(const udp_pcb *pcb){
+    return pcb->node != 0 ? pcb->node : (uint32_t)hostStationAddress();
+}
+
+static bool isMulticast(uint32_t address){
+    return (address & 0xF0) == 0xE0;
+}
+
+static bool isMember(uint32_t address, uint32_t group){
+    return groups.count({address, group}) > 0 ||
+        (address == (uint32_t)hostStationAddress() && groups.count({0, group}) > 0);
+}
+
+static bool isBound(uint32_t address, uint16_t port){
+    for(udp_pcb *pcb : pcbs){
+        if(pcb->port == port && nodeOf(pcb) == address){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void receive(udp_pcb *pcb, const std::vector<uint8_t> &data, uint32_t from, uint16_t fromPort){
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, data.size(), PBUF_RAM);
+    memcpy(p->payload, data.data(), data.size());
+    ip_addr_t address = {from};
+    pcb->receive(pcb->arg, pcb, p, &address, fromPort);
+}
+
+static void deliver(uint32_t from, uint16_t fromPort, uint32_t to, uint16_t toPort, const std::vector<uint8_t> &data){
+    bool multicast = isMulticast(to) || to == 0xFFFFFFFF;
+    bool received = false;
+    delivering++;
+    for(size_t i = 0; i < pcbs.size(); i++){
+        udp_pcb *pcb = pcbs[i];
+        if(pcb->port != toPort || pcb->receive == nullptr){
+            continue;
+        }
+        uint32_t address = nodeOf(pcb);
+        if(multicast){
+            //Multicast isn't looped back to the sending node
+            if(address == from || (to != 0xFFFFFFFF && !isMember(address, to))){
+                continue;
+            }
+        } else if(address != to){
+            continue;
+        }
+        receive(pcb, data, from, fromPort);
+        received = true;
+        if(!multicast){
+            break;
+        }
+    }
+    delivering--;
+    if(delivering == 0){
+        for(udp_pcb *pcb : removed){
+            delete pcb;
+        }
+        removed.clear();
+    }
+    if(!received){
+        dropped++;
+    }
+}
+
+void hostResetLwip(){
+    groups.clear();
+    node = 0;
+    latency = 0;
+    dropped = 0;
+    hosts.clear();
+    dnsCache.clear();
+    dnsDelay = 0;
+}
+
+bool hostResolve(const char *name, IPAddress &address){
+    if(address.fromString(name)){
+        return true;
+    }
+    auto found = hosts.find(name);
+    if(found == hosts.end()){
+        return false;
+    }
+    address = found->second;
+    return true;
+}
+
+void Host::setNode(IPAddress address){
+    node = address;
+}
+
+IPAddress Host::getNode(){
+    return IPAddress(node);
+}
+
+void Host::setLatency(uint32_t micros){
+    latency = micros;
+}
+
+void Host::sendUdp(IPAddress from, uint16_t fromPort, IPAddress to, uint16_t toPort, const uint8_t *data, size_t length){
+    std::vector<uint8_t> datagram(data, data + length);
+    schedule([=](){ deliver(from, fromPort, to, toPort, datagram); }, latency);
+}
+
+uint32_t Host::getDropped(){
+    return dropped;
+}
+
+void Host::addHost(const char *name, IPAddress address){
+    hosts[name] = address;
+}
+
+void Host::setDnsDelay(uint32_t micros){
+    dnsDelay = micros;
+}
+
+extern "C" struct pbuf* pbuf_alloc(pbuf_layer layer, uint16_t length, pbuf_type type){
+    struct pbuf *p = (struct pbuf*)malloc(sizeof(struct pbuf) + length);
+    if(p == nullptr){
+        return nullptr;
+    }
+    p->next = nullptr;
+    p->payload = p + 1;
+    p->tot_len = length;
+    p->len = length;
+    p->ref = 1;
+    return p;
+}
+
+extern "C" uint8_t pbuf_free(struct pbuf *p){
+    if(p == nullptr || --p->ref > 0){
+        return 0;
+    }
+    free(p);
+    return 1;
+}
+
+extern "C" void pbuf_ref(struct pbuf *p){
+    p->ref++;
+}
+
+extern "C" void pbuf_realloc(struct pbuf *p, uint16_t length){
+    if(length < p->tot_len){
+        p->tot_len = length;
+        p->len = length;
+    }
+}
+
+extern "C" uint16_t pbuf_copy_partial(const struct pbuf *p, void *data, uint16_t length, uint16_t offset){
+    if(offset >= p->tot_len){
+        return 0;
+    }
+    uint16_t copied = std::min<uint16_t>(length, p->tot_len - offset);
+    memcpy(data, (const uint8_t*)p->payload + offset, copied);
+    return copied;
+}
+
+extern "C" struct udp_pcb* udp_new(void){
+    udp_pcb *pcb = new udp_pcb{node, 0, nullptr, nullptr};
+    pcbs.push_back(pcb);
+    return pcb;
+}
+
+extern "C" void udp_remove(struct udp_pcb *pcb){
+    for(size_t i = 0; i < pcbs.size(); i++){
+        if(pcbs[i] == pcb){
+            pcbs.erase(pcbs.begin() + i);
+            break;
+        }
+    }
+    if(delivering > 0){
+        pcb->receive = nullptr;
+        removed.push_back(pcb);
+    } else {
+        delete pcb;
+    }
+}
+
+extern "C" err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *address, uint16_t port){
+    if(port == 0){
+        while(isBound(nodeOf(pcb), nextPort)){
+            nextPort++;
+        }
+        port = nextPort++;
+    } else if(isBound(nodeOf(pcb), port)){
+        return ERR_USE;
+    }
+    pcb->port = port;
+    return ERR_OK;
+}
+
+extern "C" void udp_recv(struct udp_pcb *pcb, udp_recv_fn receive, void *arg){
+    pcb->receive = receive;
+    pcb->arg = arg;
+}
+
+extern "C" err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *address, uint16_t port){
+    uint32_t from = nodeOf(pcb);
+    if(from == 0){
+        return ERR_RTE;
+    }
+    if(pcb->port == 0 && udp_bind(pcb, IP_ADDR_ANY, 0) != ERR_OK){
+        return ERR_USE;
+    }
+    Host::sendUdp(IPAddress(from), pcb->port, IPAddress(address->addr), port, (const uint8_t*)p->payload, p->len);
+    return ERR_OK;
+}
+
+extern "C" void udp_set_multicast_ttl(struct udp_pcb *pcb, uint8_t ttl){
+}
+
+extern "C" err_t igmp_joingroup(const ip4_addr_t *local, const ip4_addr_t *group){
+    groups.insert({local->addr != 0 ? local->addr : node, group->addr});
+    return ERR_OK;
+}
+
+extern "C" err_t igmp_leavegroup(const ip4_addr_t *local, const ip4_addr_t *group){
+    groups.erase({local->addr != 0 ? local->addr : node, group->addr});
+    return ERR_OK;
+}
+
+/*
+ * Names a test added answer after the DNS delay, unknown ones fail the
+ * same way. Answers are cached like lwIP does, later lookups return at once.
+ */
+extern "C" err_t dns_gethostbyname(const char *name, ip_addr_t *address, dns_found_callback found, void *arg){
+    if(name == nullptr || address == nullptr){
+        return ERR_ARG;
+    }
+    IPAddress resolved;
+    if(resolved.fromString(name) || (dnsCache.count(name) > 0 && hostResolve(name, resolved))){
+        address->addr = resolved;
+        return ERR_OK;
+    }
+    std::string key = name;
+    Host::schedule([key, found, arg](){
+        IPAddress answer;
+        if(!hostResolve(key.c_str(), answer)){
+            found(key.c_str(), nullptr, arg);
+            return;
+        }
+        dnsCache.insert(key);
+        ip_addr_t result = {answer};
+        found(key.c_str(), &result, arg);
+    }, dnsDelay);
+    return ERR_INPROGRESS;
+}
@@ -0,0 +1,47 @@
+#include <Arduino.h>
+#include <ESP8266mDNS.h>
+#include <DNSServer.h>
+#include <SPI.h>
+
+MDNSResponder MDNS;
+SPIClass SPI;
+
+bool MDNSResponder::begin(const char *hostname){
+    return true;
+}
+
+bool MDNSResponder::update(){
+    return true;
+}
+
+bool DNSServer::start(const uint16_t &port, const String &domainName, const IPAddress &resolvedIP){
+    return true;
+}
+
+void DNSServer::stop(){
+}
+
+void DNSServer::processNextRequest(){
+}
+
+void DNSServer::setErrorReplyCode(const DNSReplyCode &replyCode){
+}
+
+void DNSServer::setTTL(const uint32_t &ttl){
+}
+
+void SPIClass::begin(){
+}
+
+void SPIClass::end(){
+}
+
+void SPIClass::beginTransaction(SPISettings settings){
+}
+
+void SPIClass::endTransaction(){
+}
+
+uint8_t SPIClass::transfer(uint8_t data){
+    return 0;
+}
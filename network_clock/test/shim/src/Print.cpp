@@ -0,0 +1,139 @@
+#include "Print.h"
+#include "Stream.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <vector>
+
+size_t Print::write(const uint8_t *buffer, size_t size){
+    size_t written = 0;
+    while(size-- > 0){
+        written += write(*buffer++);
+    }
+    return written;
+}
+
+size_t Print::write(const char *text){
+    return text == nullptr ? 0 : write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::write(const char *buffer, size_t size){
+    return write((const uint8_t*)buffer, size);
+}
+
+size_t Print::print(const char *text){
+    return write(text);
+}
+
+size_t Print::print(const String &text){
+    return write(text.c_str(), text.length());
+}
+
+size_t Print::print(const __FlashStringHelper *text){
+    return write((const char*)text);
+}
+
+size_t Print::print(char c){
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base){
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base){
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base){
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base){
+    return print(String(value, base));
+}
+
+size_t Print::print(unsigned long value, int base){
+    return print(String(value, base));
+}
+
+size_t Print::print(double value, int digits){
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+}
+
+size_t Print::print(const Printable &value){
+    return value.printTo(*this);
+}
+
+size_t Print::println(){
+    return write("\r\n");
+}
+
+size_t Print::printf(const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    if(length <= 0){
+        return 0;
+    }
+    std::vector<char> buffer(length + 1);
+    va_start(args, format);
+    vsnprintf(buffer.data(), buffer.size(), format, args);
+    va_end(args);
+    return write(buffer.data(), length);
+}
+
+size_t Print::printf_P(const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    if(length <= 0){
+        return 0;
+    }
+    std::vector<char> buffer(length + 1);
+    va_start(args, format);
+    vsnprintf(buffer.data(), buffer.size(), format, args);
+    va_end(args);
+    return write(buffer.data(), length);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length){
+    return readBytes((uint8_t*)buffer, length);
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length){
+    size_t count = 0;
+    while(count < length){
+        int c = read();
+        if(c < 0){
+            break;
+        }
+        buffer[count++] = c;
+    }
+    return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buffer, size_t length){
+    size_t count = 0;
+    while(count < length){
+        int c = read();
+        if(c < 0 || c == terminator){
+            break;
+        }
+        buffer[count++] = c;
+    }
+    return count;
+}
+
+String Stream::readStringUntil(char terminator){
+    String text;
+    int c;
+    while((c = read()) >= 0 && c != terminator){
+        text += (char)c;
+    }
+    return text;
+}
@@ -0,0 +1,128 @@
+#include "Updater.h"
+#include <MD5Builder.h>
+#include "HostInternal.h"
+#include <flash_hal.h>
+#include <ctype.h>
+#include <vector>
+
+UpdaterClass Update;
+
+static std::string flashPath;
+static std::vector<uint8_t> image; //Last image that ended well
+static uint32_t sketchSpace = 0x100000;
+
+static std::string md5(const std::vector<uint8_t> &data){
+    MD5Builder builder;
+    builder.begin();
+    builder.add(data.data(), data.size());
+    builder.calculate();
+    return builder.toString().c_str();
+}
+
+static const std::string& path(){
+    if(flashPath.empty()){
+        flashPath = std::string(hostGetFsRoot()) + ".flash";
+    }
+    return flashPath;
+}
+
+void hostResetUpdate(){
+    flashPath.clear();
+    image.clear();
+    sketchSpace = 0x100000;
+}
+
+const std::vector<uint8_t>& Host::getUpdateImage(){
+    return image;
+}
+
+void Host::setSketchSpace(uint32_t size){
+    sketchSpace = size;
+}
+
+uint32_t EspClass::getFreeSketchSpace(){
+    return sketchSpace;
+}
+
+bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn){
+    if(_file != nullptr){
+        fclose(_file);
+    }
+    _size = size;
+    _written = 0;
+    _error = UPDATE_ERROR_OK;
+    _md5.clear();
+    if(size == 0 || size > (command == U_FS ? (size_t)(FS_end - FS_start) : (size_t)sketchSpace)){
+        _error = UPDATE_ERROR_SPACE;
+        _file = nullptr;
+        return false;
+    }
+    _file = fopen(path().c_str(), "w+b");
+    return _file != nullptr;
+}
+
+size_t UpdaterClass::write(uint8_t *data, size_t length){
+    if(_file == nullptr || _error != UPDATE_ERROR_OK){
+        return 0;
+    }
+    if(_written + length > _size){
+        _error = UPDATE_ERROR_SPACE;
+        return 0;
+    }
+    size_t written = fwrite(data, 1, length, _file);
+    _written += written;
+    if(written != length){
+        _error = UPDATE_ERROR_WRITE;
+    }
+    return written;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining){
+    if(_file == nullptr){
+        return false;
+    }
+    if(!evenIfRemaining && _written != _size){
+        _error = UPDATE_ERROR_SIZE;
+    }
+    std::vector<uint8_t> written(_written);
+    fflush(_file);
+    rewind(_file);
+    written.resize(fread(written.data(), 1, written.size(), _file));
+    fclose(_file);
+    _file = nullptr;
+    if(_error == UPDATE_ERROR_OK && !_md5.empty() && md5(written) != _md5){
+        _error = UPDATE_ERROR_MD5;
+    }
+    if(_error != UPDATE_ERROR_OK){
+        return false;
+    }
+    image = written;
+    return true;
+}
+
+bool UpdaterClass::setMD5(const char *expected){
+    if(strlen(expected) != 32){
+        return false;
+    }
+    _md5 = expected;
+    for(char &c : _md5){
+        c = tolower(c);
+    }
+    return true;
+}
+
+bool UpdaterClass::isRunning(){
+    return _file != nullptr;
+}
+
+bool UpdaterClass::hasError(){
+    return _error != UPDATE_ERROR_OK;
+}
+
+uint8_t UpdaterClass::getError(){
+    return _error;
+}
+
+size_t UpdaterClass::progress(){
+    return _written;
+}
@@ -0,0 +1,157 @@
+#include "WString.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+static std::string number(unsigned long value, bool negative, unsigned char base){
+    char digits[40];
+    uint8_t length = 0;
+    do{
+        uint8_t digit = value % base;
+        digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    }while(value > 0);
+    std::string text = negative ? "-" : "";
+    while(length > 0){
+        text += digits[--length];
+    }
+    return text;
+}
+
+String::String(const char *text) : _text(text != nullptr ? text : ""){}
+String::String(const __FlashStringHelper *text) : String((const char*)text){}
+String::String(char c) : _text(1, c){}
+String::String(int value, unsigned char base) : String((long)value, base){}
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base){}
+String::String(long value, unsigned char base)
+    : _text(base == 10 && value < 0 ? number(-(unsigned long)value, true, base) : number((unsigned long)value, false, base)){}
+String::String(unsigned long value, unsigned char base) : _text(number(value, false, base)){}
+
+String& String::operator=(const char *text){
+    _text = text != nullptr ? text : "";
+    return *this;
+}
+
+String& String::operator+=(const String &other){
+    _text += other._text;
+    return *this;
+}
+
+String& String::operator+=(const char *text){
+    _text += text != nullptr ? text : "";
+    return *this;
+}
+
+String& String::operator+=(char c){
+    _text += c;
+    return *this;
+}
+
+String operator+(const String &left, const String &right){
+    String result(left);
+    result += right;
+    return result;
+}
+
+String operator+(const String &left, const char *right){
+    String result(left);
+    result += right;
+    return result;
+}
+
+bool String::operator==(const String &other) const{
+    return _text == other._text;
+}
+
+bool String::operator!=(const String &other) const{
+    return _text != other._text;
+}
+
+bool String::operator==(const char *text) const{
+    return _text == (text != nullptr ? text : "");
+}
+
+bool String::operator!=(const char *text) const{
+    return !(*this == text);
+}
+
+bool String::equals(const String &other) const{
+    return *this == other;
+}
+
+bool String::equals(const char *text) const{
+    return *this == text;
+}
+
+bool String::startsWith(const String &prefix) const{
+    return _text.compare(0, prefix._text.size(), prefix._text) == 0;
+}
+
+bool String::endsWith(const String &suffix) const{
+    return _text.size() >= suffix._text.size() &&
+        _text.compare(_text.size() - suffix._text.size(), suffix._text.size(), suffix._text) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const{
+    size_t found = _text.find(c, from);
+    return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::indexOf(const char *text, unsigned int from) const{
+    size_t found = _text.find(text, from);
+    return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::indexOf(const String &text, unsigned int from) const{
+    return indexOf(text.c_str(), from);
+}
+
+String String::substring(unsigned int from) const{
+    return substring(from, _text.size());
+}
+
+String String::substring(unsigned int from, unsigned int to) const{
+    if(from > to){
+        std::swap(from, to);
+    }
+    if(from >= _text.size()){
+        return String();
+    }
+    return String(_text.substr(from, to - from).c_str());
+}
+
+void String::toLowerCase(){
+    for(char &c : _text){
+        c = tolower(c);
+    }
+}
+
+void String::trim(){
+    size_t start = _text.find_first_not_of(" \t\r\n");
+    size_t end = _text.find_last_not_of(" \t\r\n");
+    _text = start == std::string::npos ? "" : _text.substr(start, end - start + 1);
+}
+
+long String::toInt() const{
+    return atol(_text.c_str());
+}
+
+const char* String::c_str() const{
+    return _text.c_str();
+}
+
+unsigned int String::length() const{
+    return _text.size();
+}
+
+bool String::reserve(unsigned int size){
+    _text.reserve(size);
+    return true;
+}
+
+char String::operator[](unsigned int index) const{
+    return index < _text.size() ? _text[index] : '\0';
+}
+
+char& String::operator[](unsigned int index){
+    return _text[index];
+}
@@ -0,0 +1,97 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <AlarmEngine.h>
+#include <vector>
+
+#define MONDAY 1600041600UL //2020-09-14 00:00 UTC
+
+static std::vector<uint32_t> fired;
+
+static void onAlarm(uint16_t index, const Alarm &alarm){
+    fired.push_back(index);
+}
+
+class AlarmEngineTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        fired.clear();
+        engine.setCallback(onAlarm);
+        engine.begin(MONDAY, 0);
+    }
+
+    //Ticks once a second, loop() does it far more often
+    void run(uint32_t from, uint32_t to){
+        for(uint32_t now = from; now <= to; now++){
+            engine.tick(now);
+        }
+    }
+
+    AlarmEngine engine;
+};
+
+TEST_F(AlarmEngineTest, EverySlotFiresInOrder){
+    //Slot i at minute i of the day, added in reverse so the order has to be sorted
+    for(int i = ALARM_MAX - 1; i >= 0; i--){
+        Alarm alarm = {ALARM_DAILY, ALARM_EVERY_DAY, (uint8_t)(i / 60), (uint8_t)(i % 60), 0};
+        ASSERT_GE(engine.add(alarm, MONDAY), 0);
+    }
+    Alarm extra = {ALARM_HOURLY, 0, 0, 30, 0};
+    EXPECT_EQ(engine.add(extra, MONDAY), -1);
+    EXPECT_EQ(engine.getCount(), ALARM_MAX);
+
+    run(MONDAY, MONDAY + SECONDS_PER_DAY - 1);
+    ASSERT_EQ(fired.size(), (size_t)ALARM_MAX - 1); //Minute 0 is today's, already past
+    for(size_t i = 1; i < fired.size(); i++){
+        EXPECT_EQ(engine.get(fired[i]).hour * 60 + engine.get(fired[i]).minute, (int)i + 1);
+    }
+    //All of them are waiting for the next day again
+    EXPECT_EQ(engine.getCount(), ALARM_MAX);
+}
+
+TEST_F(AlarmEngineTest, CountdownsAndOnceAreRemoved){
+    Alarm countdown = {ALARM_COUNTDOWN, 0, 0, 0, MONDAY + 90};
+    Alarm once = {ALARM_ONCE, ALARM_EVERY_DAY, 0, 1, 0};
+    int16_t first = engine.add(countdown, MONDAY);
+    int16_t second = engine.add(once, MONDAY);
+    run(MONDAY, MONDAY + 120);
+    EXPECT_EQ(fired, (std::vector<uint32_t>{(uint32_t)second, (uint32_t)first}));
+    EXPECT_FALSE(engine.isUsed(first));
+    EXPECT_FALSE(engine.isUsed(second));
+    EXPECT_EQ(engine.getCount(), 0);
+}
+
+/*
+ * Booted without a time, the schedule is worked out from 1970 and has to
+ * be redone once the real time is known.
+ */
+TEST_F(AlarmEngineTest, RescheduleAfterFirstSync){
+    engine.begin(0, 0);
+    Alarm alarm = {ALARM_DAILY, ALARM_EVERY_DAY, 7, 30, 0};
+    int16_t index = engine.add(alarm, 0);
+    EXPECT_EQ(engine.getNextFire(index), 7 * SECONDS_PER_HOUR + 30 * SECONDS_PER_MINUTE);
+
+    engine.reschedule(MONDAY + 8 * SECONDS_PER_HOUR);
+    EXPECT_EQ(engine.getNextFire(index), MONDAY + SECONDS_PER_DAY + 7 * SECONDS_PER_HOUR + 30 * SECONDS_PER_MINUTE);
+    run(MONDAY + 8 * SECONDS_PER_HOUR, MONDAY + 8 * SECONDS_PER_HOUR + 10);
+    EXPECT_TRUE(fired.empty());
+}
+
+TEST_F(AlarmEngineTest, SavedAlarmsLoadBack){
+    Alarm alarm = {ALARM_DAILY, 0b0111110, 6, 45, 0};
+    for(int i = 0; i < 300; i++){
+        engine.add(alarm, MONDAY);
+    }
+    ASSERT_TRUE(engine.save());
+
+    AlarmEngine loaded;
+    loaded.begin(MONDAY, 0);
+    EXPECT_EQ(loaded.getCount(), ALARM_MAX);
+    EXPECT_EQ(loaded.get(ALARM_MAX - 1).days, 0b0111110);
+    EXPECT_EQ(loaded.getNextFire(ALARM_MAX - 1), MONDAY + 6 * SECONDS_PER_HOUR + 45 * SECONDS_PER_MINUTE);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
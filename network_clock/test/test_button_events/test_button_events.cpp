@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <ButtonEvents.h>
+#include <vector>
+
+#define FUNCTION_PIN 12 //BUT_OFFSET on the schematic
+
+static std::vector<ButtonEvent> events;
+
+static void onButton(uint8_t button, ButtonEvent event){
+    events.push_back(event);
+}
+
+class ButtonEventsTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(0);
+        events.clear();
+        buttons.setCallback(onButton);
+        button = buttons.attach(FUNCTION_PIN, true);
+    }
+
+    //Loop is blocked while the pin moves, only the interrupt sees it
+    void press(uint32_t ms){
+        Host::setPin(FUNCTION_PIN, LOW);
+        Host::advance(ms * 1000ULL);
+        Host::setPin(FUNCTION_PIN, HIGH);
+    }
+
+    void run(uint32_t ms){
+        for(uint32_t i = 0; i < ms; i++){
+            Host::advance(1000);
+            buttons.tick();
+        }
+    }
+
+    ButtonEvents buttons;
+    uint8_t button;
+};
+
+TEST_F(ButtonEventsTest, PressWhileLoopBlockedIsCaught){
+    press(80);
+    run(DOUBLE_CLICK_TIME + 50);
+    ASSERT_EQ(events.size(), 1U);
+    EXPECT_EQ(events[0], BUTTON_CLICK);
+}
+
+TEST_F(ButtonEventsTest, DoubleClickAndLongPress){
+    press(60);
+    Host::advance(100000);
+    press(60);
+    run(DOUBLE_CLICK_TIME + 50);
+    ASSERT_EQ(events.size(), 1U);
+    EXPECT_EQ(events[0], BUTTON_DOUBLE_CLICK);
+
+    Host::setPin(FUNCTION_PIN, LOW);
+    run(LONG_PRESS_TIME + 10);
+    EXPECT_TRUE(buttons.isPressed(button));
+    Host::setPin(FUNCTION_PIN, HIGH);
+    run(DOUBLE_CLICK_TIME + 50);
+    ASSERT_EQ(events.size(), 2U);
+    EXPECT_EQ(events[1], BUTTON_LONG_PRESS);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+//Four billion conversions take most of a minute per core, several times that unoptimised
+#pragma GCC optimize("O2")
+
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <CivilTime.h>
+#include <atomic>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#define LAST_DAY 49710 //2106-02-07, holds the last second of 32 bit time
+
+static struct tm reference(uint32_t epoch){
+    time_t time = epoch;
+    struct tm civil;
+    gmtime_r(&time, &civil);
+    return civil;
+}
+
+static bool sameDate(const Civil_Time &time, const struct tm &civil){
+    return time.year == civil.tm_year + 1900 && time.month == civil.tm_mon + 1 &&
+        time.day == civil.tm_mday && time.weekday == civil.tm_wday;
+}
+
+static bool sameTime(const Civil_Time &time, const struct tm &civil){
+    return time.hour == civil.tm_hour && time.minute == civil.tm_min && time.second == civil.tm_sec;
+}
+
+TEST(CivilTime, EveryDayMatchesGmtime){
+    for(uint32_t day = 0; day <= LAST_DAY; day++){
+        struct tm civil = reference(day * SECONDS_PER_DAY);
+        Civil_Time time = CivilTime::civilFromDays(day);
+        ASSERT_TRUE(sameDate(time, civil)) << "day " << day << " is " << time.year << "-" << (int)time.month << "-" << (int)time.day;
+        ASSERT_EQ(CivilTime::daysFromCivil(time.year, time.month, time.day), day);
+        ASSERT_EQ(CivilTime::weekday(day), civil.tm_wday);
+    }
+}
+
+TEST(CivilTime, EverySecondOfDayMatchesGmtime){
+    for(uint32_t second = 0; second < SECONDS_PER_DAY; second++){
+        struct tm civil = reference(second);
+        Civil_Time time = CivilTime::timeOfDay(second);
+        ASSERT_TRUE(sameTime(time, civil)) << "second " << second;
+        ASSERT_EQ(CivilTime::toEpoch(1970, 1, 1, time.hour, time.minute, time.second), second);
+    }
+}
+
+//Fields packed into one word, so the loop over every epoch compares integers
+static uint32_t packDate(const Civil_Time &time){
+    return (uint32_t)time.year << 16 | time.month << 8 | time.day << 3 | time.weekday;
+}
+
+static uint32_t packTime(const Civil_Time &time){
+    return time.hour << 16 | time.minute << 8 | time.second;
+}
+
+static Civil_Time fromTm(const struct tm &civil){
+    return Civil_Time{(uint16_t)(civil.tm_year + 1900), (uint8_t)(civil.tm_mon + 1), (uint8_t)civil.tm_mday,
+        (uint8_t)civil.tm_hour, (uint8_t)civil.tm_min, (uint8_t)civil.tm_sec, (uint8_t)civil.tm_wday};
+}
+
+/*
+ * fromEpoch() for all 2^32 inputs, against gmtime answers for each day
+ * and each second of the day. Days are split between threads.
+ */
+TEST(CivilTime, EveryEpochMatchesGmtime){
+    std::vector<uint32_t> seconds(SECONDS_PER_DAY);
+    for(uint32_t second = 0; second < SECONDS_PER_DAY; second++){
+        seconds[second] = packTime(fromTm(reference(second)));
+    }
+
+    std::atomic<uint64_t> checked(0);
+    std::atomic<uint32_t> firstBad(0);
+    std::atomic<bool> failed(false);
+    uint32_t workers = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::thread> threads;
+    for(uint32_t worker = 0; worker < workers; worker++){
+        threads.emplace_back([&, worker](){
+            uint64_t count = 0;
+            for(uint32_t day = worker; day <= LAST_DAY && !failed; day += workers){
+                uint32_t start = day * SECONDS_PER_DAY;
+                uint32_t date = packDate(fromTm(reference(start)));
+                //The last day ends at 06:28:15
+                uint32_t length = day < LAST_DAY ? SECONDS_PER_DAY : 0xFFFFFFFFUL - start + 1;
+                for(uint32_t second = 0; second < length; second++){
+                    Civil_Time time = CivilTime::fromEpoch(start + second);
+                    if(packDate(time) != date || packTime(time) != seconds[second]){
+                        if(!failed.exchange(true)){
+                            firstBad = start + second;
+                        }
+                        break;
+                    }
+                }
+                count += length;
+            }
+            checked += count;
+        });
+    }
+    for(std::thread &thread : threads){
+        thread.join();
+    }
+    ASSERT_FALSE(failed) << "epoch " << firstBad;
+    EXPECT_EQ(checked, 1ULL << 32);
+}
+
+TEST(CivilTime, ToEpochOfEveryDayMatchesTimegm){
+    for(uint32_t day = 0; day <= LAST_DAY; day++){
+        struct tm civil = reference(day * SECONDS_PER_DAY + 12345);
+        uint32_t epoch = CivilTime::toEpoch(civil.tm_year + 1900, civil.tm_mon + 1, civil.tm_mday,
+            civil.tm_hour, civil.tm_min, civil.tm_sec);
+        ASSERT_EQ(epoch, (uint32_t)timegm(&civil)) << "day " << day;
+    }
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <ConnectionManager.h>
+#include <vector>
+
+static std::vector<ConnectionEvent> events;
+
+static void onEvent(ConnectionEvent event){
+    events.push_back(event);
+}
+
+class ConnectionManagerTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(0);
+        events.clear();
+        strcpy(ssid, "home");
+        strcpy(psk, "secret");
+        Host::addNetwork("home", "secret", IPAddress(10, 0, 0, 7), -60);
+        fastBoot.load();
+        manager.setCallback(onEvent);
+        manager.begin(ssid, psk, "clock");
+    }
+
+    //Ticks every 10 ms like loop() would, SDK events in between
+    void run(uint32_t ms){
+        for(uint32_t i = 0; i < ms; i += 10){
+            Host::advance(10000);
+            Host::runSystem();
+            manager.tick();
+        }
+    }
+
+    char ssid[33];
+    char psk[65];
+    FastBoot fastBoot;
+    ConnectionManager manager = ConnectionManager(fastBoot);
+};
+
+TEST_F(ConnectionManagerTest, AccessPointOutlivesJoinByGracePeriod){
+    manager.startAccessPoint();
+    EXPECT_TRUE(manager.isAccessPointActive());
+    EXPECT_EQ(WiFi.softAPIP(), IPAddress(192, 168, 4, 1));
+
+    //Credentials saved from the UI
+    manager.connect();
+    run(1000);
+    ASSERT_EQ(manager.getState(), STATE_CONNECTED);
+    EXPECT_TRUE(manager.isAccessPointActive());
+    EXPECT_EQ(WiFi.softAPIP(), IPAddress(192, 168, 4, 1));
+
+    run(AP_GRACE_PERIOD - 2000);
+    EXPECT_TRUE(manager.isAccessPointActive());
+    run(2000);
+    EXPECT_FALSE(manager.isAccessPointActive());
+    EXPECT_EQ(WiFi.softAPIP(), IPAddress());
+    ASSERT_FALSE(events.empty());
+    EXPECT_EQ(events.back(), EVENT_AP_STOPPED);
+    EXPECT_EQ(manager.getState(), STATE_CONNECTED);
+}
+
+TEST_F(ConnectionManagerTest, DropInGracePeriodRestartsIt){
+    manager.startAccessPoint();
+    manager.connect();
+    run(1000);
+    ASSERT_EQ(manager.getState(), STATE_CONNECTED);
+
+    run(AP_GRACE_PERIOD / 2);
+    Host::dropNetwork(WIFI_DISCONNECT_REASON_ASSOC_LEAVE);
+    run(100);
+    EXPECT_NE(manager.getState(), STATE_CONNECTED);
+
+    //Rejoins after the backoff, the access point is kept a full period from then
+    run(AP_GRACE_PERIOD / 2 + 5000);
+    ASSERT_EQ(manager.getState(), STATE_CONNECTED);
+    EXPECT_TRUE(manager.isAccessPointActive());
+    run(AP_GRACE_PERIOD);
+    EXPECT_FALSE(manager.isAccessPointActive());
+}
+
+TEST_F(ConnectionManagerTest, NoAccessPointWithoutFallback){
+    manager.connect();
+    run(1000);
+    ASSERT_EQ(manager.getState(), STATE_CONNECTED);
+    run(AP_GRACE_PERIOD * 2);
+    EXPECT_FALSE(manager.isAccessPointActive());
+    for(ConnectionEvent event : events){
+        EXPECT_NE(event, EVENT_AP_STOPPED);
+        EXPECT_NE(event, EVENT_AP_STARTED);
+    }
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <DeviceConfig.h>
+#include <string>
+
+class StringPrint : public Print{
+public:
+    size_t write(uint8_t c) override{
+        text += (char)c;
+        return 1;
+    }
+    std::string text;
+};
+
+static Device_Info defaults(){
+    Device_Info info = {"home", "secret", "clock", "admin", "admin", 8, 180, "site"};
+    return info;
+}
+
+TEST(DeviceConfigTest, CsvRoundTrips){
+    Device_Info info = defaults();
+    StringPrint out;
+    DeviceConfig::printCsv(out, info);
+    EXPECT_STREQ(out.text.c_str(), "home,secret,clock,admin,admin,8,180,site,");
+
+    Device_Info read = {};
+    char csv[200];
+    strcpy(csv, out.text.c_str());
+    EXPECT_EQ(DeviceConfig::parseCsv(csv, read), DEVICE_FIELD_COUNT);
+    EXPECT_EQ(DeviceConfig::diff(info, read), 0);
+}
+
+TEST(DeviceConfigTest, CsvNumbersOutOfRangeAreKept){
+    Device_Info info = defaults();
+    char csv[] = "home,secret,clock,admin,admin,255,-9999,";
+    DeviceConfig::parseCsv(csv, info);
+    EXPECT_EQ(info.brightness, 8);
+    EXPECT_EQ(info.timeOffset, 180);
+    //Files saved before the fleet key leave it as it was
+    EXPECT_STREQ(info.fleetKey, "site");
+
+    char edges[] = "home,secret,clock,admin,admin,15,-720,";
+    DeviceConfig::parseCsv(edges, info);
+    EXPECT_EQ(info.brightness, 15);
+    EXPECT_EQ(info.timeOffset, OFFSET_MIN);
+
+    char garbage[] = "home,secret,clock,admin,admin,bright,,";
+    DeviceConfig::parseCsv(garbage, info);
+    EXPECT_EQ(info.brightness, 15);
+    EXPECT_EQ(info.timeOffset, OFFSET_MIN);
+}
+
+TEST(DeviceConfigTest, CsvTextIsBounded){
+    Device_Info info = defaults();
+    char csv[] = "home,secret,averyveryverylongname,";
+    DeviceConfig::parseCsv(csv, info);
+    EXPECT_EQ(strlen(info.name), DEVICE_NAME_SIZE - 1U);
+    EXPECT_EQ(info.brightness, 8);
+}
+
+TEST(DeviceConfigTest, SetTextTakesUnterminatedArrays){
+    Device_Info info = defaults();
+    //Full SDK arrays have no terminator, what follows must not be read
+    struct { char ssid[8]; char after[8]; } conf = {{'n', 'e', 'i', 'g', 'h', 'b', 'o', 'r'}, "XXXXXXX"};
+    EXPECT_TRUE(DeviceConfig::setText(info, FIELD_ssid, conf.ssid, sizeof(conf.ssid)));
+    EXPECT_STREQ(info.ssid, "neighbor");
+
+    char full[SSID_SIZE];
+    memset(full, 'a', sizeof(full));
+    EXPECT_FALSE(DeviceConfig::setText(info, FIELD_ssid, full, sizeof(full)));
+    EXPECT_STREQ(info.ssid, "neighbor");
+    EXPECT_FALSE(DeviceConfig::setText(info, FIELD_brightness, "3", 1));
+    EXPECT_EQ(info.brightness, 8);
+}
+
+TEST(DeviceConfigTest, PatchIsAllOrNothing){
+    Device_Info info = defaults();
+    StaticJsonBuffer<200> json;
+    JsonObject &root = json.parseObject("{\"bright\":3,\"timezone\":900}");
+    uint16_t changed = 0;
+    const char *error = nullptr;
+    EXPECT_FALSE(DeviceConfig::patch(root, info, changed, error));
+    EXPECT_STREQ(error, "timezone");
+    EXPECT_EQ(info.brightness, 8);
+
+    root["timezone"] = "-60";
+    EXPECT_TRUE(DeviceConfig::patch(root, info, changed, error));
+    EXPECT_EQ(changed, FIELD_BIT(brightness) | FIELD_BIT(timeOffset));
+    EXPECT_EQ(info.timeOffset, -60);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
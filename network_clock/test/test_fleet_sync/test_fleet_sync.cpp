@@ -0,0 +1,243 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <FleetSync.h>
+#include <memory>
+#include <vector>
+
+#define EPOCH 1600000000UL
+
+typedef struct Synced_t {
+  Fleet_Beacon beacon;
+  uint32_t error;
+}Synced;
+
+static std::vector<Synced> synced;
+
+static void onSync(const Fleet_Beacon &beacon, uint32_t error){
+    synced.push_back(Synced{beacon, error});
+}
+
+/*
+ * One clock of the site, on its own address and chip id.
+ */
+struct Clock{
+    Clock(uint32_t id, uint32_t epoch) : id(id), address(10, 0, 0, (uint8_t)id){
+        Host::setChipId(id);
+        fleet.reset(new FleetSync(clock));
+        clock.begin(epoch);
+    }
+
+    void start(const char *key){
+        Host::setNode(address);
+        fleet->setKey(key);
+        fleet->setSyncCallback(onSync);
+        ASSERT_TRUE(fleet->begin(address));
+    }
+
+    uint32_t id;
+    IPAddress address;
+    SoftClock clock;
+    std::unique_ptr<FleetSync> fleet;
+};
+
+/*
+ * Several clocks on one multicast group, each ticked like its loop() would.
+ */
+class FleetSyncTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(1000000000ULL);
+        synced.clear();
+    }
+
+    void TearDown() override{
+        for(auto &clock : clocks){
+            clock->fleet->stop();
+        }
+    }
+
+    Clock& add(uint32_t id, uint32_t epoch = EPOCH, const char *key = ""){
+        clocks.emplace_back(new Clock(id, epoch));
+        clocks.back()->start(key);
+        return *clocks.back();
+    }
+
+    void run(uint32_t ms){
+        for(uint32_t i = 0; i < ms; i += 10){
+            Host::advance(10000);
+            //Beacons reach the others as soon as they are sent, like on a quiet LAN
+            for(auto &clock : clocks){
+                clock->fleet->tick();
+                Host::runSystem();
+            }
+        }
+    }
+
+    void expectLeader(uint32_t id){
+        for(auto &clock : clocks){
+            EXPECT_EQ(clock->fleet->getLeader(), id) << "clock " << clock->id;
+            EXPECT_EQ(clock->fleet->isLeader(), clock->id == id) << "clock " << clock->id;
+        }
+    }
+
+    //A synced leader beacon at our time plus shift, from a clock that isn't simulated
+    void sendBeacon(IPAddress from, uint32_t id, uint32_t boot, uint32_t sequence, const char *key = "", int64_t shift = 0){
+        uint8_t packet[FLEET_BEACON_SIZE] = {0};
+        uint64_t stamp = SoftClock::toNtp(micros64() + (uint64_t)EPOCH * 1000000ULL + shift);
+        uint32_t words[] = {sequence, id, (uint32_t)(stamp >> 32), (uint32_t)stamp, boot, 0, 0};
+        packet[0] = FLEET_MAGIC >> 8;
+        packet[1] = FLEET_MAGIC & 0xFF;
+        packet[2] = FLEET_VERSION;
+        packet[3] = BEACON_LEADER | BEACON_SYNCED;
+        packet[4] = 2;
+        for(size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++){
+            for(uint8_t j = 0; j < 4; j++){
+                packet[8 + i * 4 + j] = words[i] >> (24 - j * 8);
+            }
+        }
+        uint64_t tag = FleetSync::sipHash(FleetSync::deriveKey(key), packet, FLEET_SIGNED_SIZE);
+        for(uint8_t j = 0; j < 8; j++){
+            packet[FLEET_SIGNED_SIZE + j] = tag >> (56 - j * 8);
+        }
+        Host::sendUdp(from, FLEET_PORT, IPAddress(FLEET_GROUP), FLEET_PORT, packet, sizeof(packet));
+    }
+
+    std::vector<std::unique_ptr<Clock>> clocks;
+};
+
+TEST_F(FleetSyncTest, LowestIdLeads){
+    add(30);
+    add(10);
+    add(20);
+    run(10000);
+    expectLeader(10);
+}
+
+TEST_F(FleetSyncTest, LowerIdJoiningTakesOver){
+    //17 has the shorter holdoff and claims first, 12 takes over once it hears it
+    add(12);
+    add(17);
+    run(10000);
+    expectLeader(12);
+
+    add(9);
+    run(3000);
+    expectLeader(9);
+}
+
+TEST_F(FleetSyncTest, NextLowestTakesOverWhenLeaderGoes){
+    add(10);
+    add(20);
+    add(30);
+    run(10000);
+    expectLeader(10);
+
+    clocks[0]->fleet->stop();
+    clocks.erase(clocks.begin());
+    run(FLEET_TIMEOUT + FLEET_HOLDOFF_SLOTS * FLEET_INTERVAL);
+    expectLeader(20);
+}
+
+TEST_F(FleetSyncTest, FollowersTakeLeaderTimeAndReference){
+    Clock &leader = add(10);
+    leader.clock.adjust(EPOCH);
+    leader.fleet->setReference(2, 0x0100, 0x0080);
+    Clock &follower = add(20, EPOCH + 3);
+    run(10000);
+    expectLeader(10);
+
+    int64_t error = (int64_t)(follower.clock.nowMicros() - leader.clock.nowMicros());
+    EXPECT_LE(error < 0 ? -error : error, FLEET_MAX_OFFSET);
+    EXPECT_TRUE(follower.clock.isSynced());
+
+    ASSERT_FALSE(synced.empty());
+    const Synced &last = synced.back();
+    EXPECT_EQ(last.beacon.id, 10U);
+    EXPECT_EQ(last.beacon.address, (uint32_t)leader.address);
+    EXPECT_EQ(last.beacon.stratum, 2);
+    EXPECT_EQ(last.beacon.rootDelay, 0x0100U);
+    EXPECT_EQ(last.beacon.rootDispersion, 0x0080U);
+    //Beacons within the tolerance leave the follower that far off
+    EXPECT_LE(last.error, (uint32_t)FLEET_MAX_OFFSET);
+}
+
+/*
+ * A leader that restarts quickly comes back with its sequence at 1, its
+ * beacons are followed right away instead of being dropped as old ones.
+ */
+TEST_F(FleetSyncTest, RebootedLeaderIsFollowedRightAway){
+    Clock &follower = add(20);
+    IPAddress leader(10, 0, 0, 10);
+    uint32_t sequence = 1000;
+    for(int i = 0; i < 5; i++){
+        sendBeacon(leader, 10, 0xB007, sequence++);
+        run(FLEET_INTERVAL);
+    }
+    ASSERT_EQ(synced.size(), 5U);
+
+    synced.clear();
+    for(uint32_t i = 1; i <= 3; i++){
+        sendBeacon(leader, 10, 0xB008, i);
+        run(FLEET_INTERVAL);
+    }
+    EXPECT_EQ(synced.size(), 3U);
+    EXPECT_EQ(follower.fleet->getRole(), ROLE_FOLLOWER);
+    EXPECT_EQ(follower.fleet->getLeader(), 10U);
+    EXPECT_EQ(follower.fleet->getLost(), 0U);
+
+    //Same boot going backwards is still an old beacon
+    sendBeacon(leader, 10, 0xB008, 2);
+    run(FLEET_INTERVAL);
+    EXPECT_EQ(synced.size(), 3U);
+}
+
+TEST_F(FleetSyncTest, SipHashMatchesReference){
+    //Vectors from the SipHash paper, key and message are 0, 1, 2...
+    Fleet_Key key = {0x0706050403020100ULL, 0x0F0E0D0C0B0A0908ULL};
+    uint8_t message[15];
+    for(uint8_t i = 0; i < sizeof(message); i++){
+        message[i] = i;
+    }
+    EXPECT_EQ(FleetSync::sipHash(key, message, 0), 0x726FDB47DD0E0E31ULL);
+    EXPECT_EQ(FleetSync::sipHash(key, message, 8), 0x93F5F5799A932462ULL);
+    EXPECT_EQ(FleetSync::sipHash(key, message, 15), 0xA129CA6149BE45E5ULL);
+}
+
+TEST_F(FleetSyncTest, ClocksWithTheSiteKeyElect){
+    add(30, EPOCH, "site");
+    add(10, EPOCH, "site");
+    add(20, EPOCH, "site");
+    run(10000);
+    expectLeader(10);
+}
+
+/*
+ * A host without the site key can't take the lead with a low id, nor
+ * move the clocks, however it signs.
+ */
+TEST_F(FleetSyncTest, BeaconsWithoutTheSiteKeyAreDropped){
+    add(10, EPOCH, "site");
+    add(20, EPOCH, "site");
+    run(10000);
+    expectLeader(10);
+    synced.clear();
+
+    IPAddress stranger(10, 0, 0, 99);
+    for(uint32_t i = 1; i <= 5; i++){
+        sendBeacon(stranger, 0, 0xBAD, i, "", 3600000000LL);
+        sendBeacon(stranger, 0, 0xBAD, i + 100, "guess", 3600000000LL);
+        run(FLEET_INTERVAL);
+    }
+    expectLeader(10);
+    for(const Synced &sync : synced){
+        EXPECT_EQ(sync.beacon.id, 10U);
+    }
+    int64_t error = (int64_t)(clocks[1]->clock.nowMicros() - clocks[0]->clock.nowMicros());
+    EXPECT_LE(error < 0 ? -error : error, FLEET_MAX_OFFSET);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,263 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <Metrics.h>
+#include <SessionStore.h>
+#include <FS.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Firmware, main.h can't be included twice
+void setup();
+void loop();
+extern Metrics metrics;
+
+#define LOAD_CLIENTS 8
+#define LOAD_REQUESTS 60 //Per client
+#define LOAD_P99 250 //ms a client may wait, queueing behind the others included
+#define LOAD_LOOP_MAX 100 //ms one loop() pass may take under load
+
+#define LOGIN "{\"USERNAME\":\"admin\",\"PASSWORD\":\"123456\"}"
+
+typedef struct Load_Request_t {
+  const char *request;
+  const char *body;
+  int status;
+  bool session; //Sends the cookie the test logged in with
+}Load_Request;
+
+/*
+ * What a browser with the UI open sends, plus a few strangers. Settings
+ * writes only touch brightness, the rest of the file stays as it was.
+ * Logins in the mix fail, a good one would push out the shared session.
+ */
+static const Load_Request mix[] = {
+    {"GET / HTTP/1.1\r\n", nullptr, 200},
+    {"GET /server/script.js HTTP/1.1\r\n", nullptr, 200},
+    {"GET /server/main.css HTTP/1.1\r\n", nullptr, 200},
+    {"GET /api HTTP/1.1\r\n", nullptr, 200, true},
+    {"GET /api HTTP/1.1\r\n", nullptr, 200, true},
+    {"GET /metrics HTTP/1.1\r\n", nullptr, 200, true},
+    {"GET /scan HTTP/1.1\r\n", nullptr, 200, true},
+    {"GET /alarms HTTP/1.1\r\n", nullptr, 200, true},
+    {"GET /history HTTP/1.1\r\n", nullptr, 200, true},
+    {"PATCH /api HTTP/1.1\r\n", "{\"bright\":7}", 200, true},
+    {"POST /api HTTP/1.1\r\n", "{\"type\":0,\"bright\":\"9\"}", 200, true},
+    {"POST /login HTTP/1.1\r\n", "{\"USERNAME\":\"admin\",\"PASSWORD\":\"654321\"}", 401},
+    {"GET /metrics HTTP/1.1\r\nCookie: ESPSESSIONID=1\r\n", nullptr, 401},
+    {"PATCH /api HTTP/1.1\r\n", "{\"bright\":1}", 401},
+    {"POST /api HTTP/1.1\r\n", "{\"type\":4,\"action\":2}", 401},
+    {"GET /metrics HTTP/1.1\r\n", nullptr, 401},
+    {"GET /no/such/page HTTP/1.1\r\n", nullptr, 404},
+};
+#define MIX_SIZE (sizeof(mix) / sizeof(mix[0]))
+
+static void writeFile(const char *path, const char *content){
+    File file = SPIFFS.open(path, "w");
+    file.print(content);
+    file.close();
+}
+
+//Cookie header of the login made in start()
+static std::string session;
+
+/*
+ * One request on a fresh connection, the server closes it after the
+ * answer. Returns the status, 0 if the exchange failed.
+ */
+static int exchange(const Load_Request &request, std::string *answer = nullptr){
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(Host::getServerPort());
+    timeval timeout = {10, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if(connect(client, (sockaddr*)&address, sizeof(address)) != 0){
+        close(client);
+        return 0;
+    }
+    std::string text = request.request;
+    text += "Host: 127.0.0.1\r\n";
+    if(request.session){
+        text += session;
+    }
+    if(request.body != nullptr){
+        text += "Content-Type: application/json\r\nContent-Length: " + std::to_string(strlen(request.body)) + "\r\n\r\n";
+        text += request.body;
+    } else {
+        text += "\r\n";
+    }
+    send(client, text.data(), text.size(), MSG_NOSIGNAL);
+
+    std::string response;
+    char buffer[2048];
+    ssize_t received;
+    while((received = recv(client, buffer, sizeof(buffer), 0)) > 0){
+        response.append(buffer, received);
+    }
+    close(client);
+    if(answer != nullptr){
+        *answer = response;
+    }
+    if(response.compare(0, 9, "HTTP/1.1 ") != 0){
+        return 0;
+    }
+    return atoi(response.c_str() + 9);
+}
+
+/*
+ * Firmware runs on its own thread the way it runs on the chip, one
+ * loop() after another. Clients hit it over loopback on real time.
+ */
+class LoadTest : public ::testing::Test{
+protected:
+    static void SetUpTestSuite(){
+        Host::reset();
+        Host::useRealTime();
+        Host::addNetwork("home", "secret", IPAddress(10, 0, 0, 7));
+        writeFile("/creds.txt", "home,secret,Clocky,admin,123456,4,180,");
+        writeFile("/index.html", "<html><body>clock</body></html>");
+        writeFile("/server/script.js", "function onPageLoad(){}");
+        writeFile("/server/main.css", "body{}");
+        setup();
+    }
+
+    void TearDown() override{
+        stop();
+    }
+
+    void start(){
+        running = true;
+        firmware = std::thread([this](){
+            while(running){
+                loop();
+                Host::runSystem();
+            }
+        });
+        //Let the station join before the clients come
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        session = login();
+    }
+
+    //Logs in the way the UI does, returns the cookie header to send back
+    static std::string login(){
+        std::string answer;
+        EXPECT_EQ(exchange({"POST /login HTTP/1.1\r\n", LOGIN, 301}, &answer), 301);
+        size_t start = answer.find("ESPSESSIONID=");
+        if(start == std::string::npos){
+            ADD_FAILURE() << "login set no session cookie";
+            return "";
+        }
+        return "Cookie: " + answer.substr(start, answer.find_first_of(";\r", start) - start) + "\r\n";
+    }
+
+    //Firmware state is only read once its thread is done with it
+    void stop(){
+        running = false;
+        if(firmware.joinable()){
+            firmware.join();
+        }
+    }
+
+    //Every client walks the mix from its own place, returns sorted latencies in ms
+    std::vector<double> runClients(uint32_t clients, uint32_t requests){
+        std::vector<std::thread> threads;
+        std::vector<std::vector<double>> latencies(clients);
+        for(uint32_t c = 0; c < clients; c++){
+            threads.emplace_back([this, c, requests, &latencies](){
+                for(uint32_t i = 0; i < requests; i++){
+                    const Load_Request &request = mix[(c * 5 + i) % MIX_SIZE];
+                    auto start = std::chrono::steady_clock::now();
+                    int status = exchange(request);
+                    latencies[c].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                    if(status != request.status){
+                        failures++;
+                        ADD_FAILURE() << request.request << "answered " << status << ", expected " << request.status;
+                    }
+                }
+            });
+        }
+        for(std::thread &thread : threads){
+            thread.join();
+        }
+        std::vector<double> all;
+        for(auto &client : latencies){
+            all.insert(all.end(), client.begin(), client.end());
+        }
+        std::sort(all.begin(), all.end());
+        return all;
+    }
+
+    static double percentile(const std::vector<double> &sorted, uint8_t percent){
+        return sorted[(sorted.size() * percent + 99) / 100 - 1];
+    }
+
+    std::thread firmware;
+    std::atomic<bool> running{false};
+    std::atomic<uint32_t> failures{0};
+};
+
+TEST_F(LoadTest, ConcurrentMixIsServed){
+    metrics.reset();
+    start();
+    std::vector<double> latencies = runClients(LOAD_CLIENTS, LOAD_REQUESTS);
+    stop();
+
+    EXPECT_EQ(failures, 0U);
+    ASSERT_EQ(latencies.size(), (size_t)LOAD_CLIENTS * LOAD_REQUESTS);
+    double p99 = percentile(latencies, 99);
+    printf("%u clients: p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", LOAD_CLIENTS, percentile(latencies, 50), p99, latencies.back());
+    EXPECT_LT(p99, LOAD_P99);
+
+    //Route table saw every request it serves, 404s never reach it
+    uint32_t served = metrics.getCount(METRIC_HTTP_READ) + metrics.getCount(METRIC_HTTP_WRITE) + metrics.getCount(METRIC_HTTP_FILE);
+    uint32_t expected = 1; //The login start() makes
+    for(uint32_t c = 0; c < LOAD_CLIENTS; c++){
+        for(uint32_t i = 0; i < LOAD_REQUESTS; i++){
+            expected += mix[(c * 5 + i) % MIX_SIZE].status != 404;
+        }
+    }
+    EXPECT_EQ(served, expected);
+    EXPECT_LT(metrics.getMax(METRIC_LOOP) / 1000, (uint32_t)LOAD_LOOP_MAX);
+}
+
+TEST_F(LoadTest, BurstOfClientsIsServed){
+    //More clients at once than the chip would take, they queue on the listen backlog
+    start();
+    std::vector<double> latencies = runClients(LOAD_CLIENTS * 8, 1);
+    EXPECT_EQ(failures, 0U);
+    EXPECT_EQ(latencies.size(), (size_t)LOAD_CLIENTS * 8);
+}
+
+TEST_F(LoadTest, SessionsAreIssuedPerLogin){
+    start();
+    std::string first = session;
+    std::string second = login();
+    EXPECT_NE(first, second);
+    EXPECT_EQ(first.size(), strlen("Cookie: ESPSESSIONID=\r\n") + SESSION_TOKEN_SIZE);
+
+    //Both logins stay good, a guessed constant doesn't get near the updater
+    EXPECT_EQ(exchange({"GET /metrics HTTP/1.1\r\n", nullptr, 200, true}), 200);
+    session = second;
+    EXPECT_EQ(exchange({"GET /metrics HTTP/1.1\r\n", nullptr, 200, true}), 200);
+    EXPECT_EQ(exchange({"POST /update HTTP/1.1\r\nCookie: ESPSESSIONID=1\r\n", "", 401}), 401);
+
+    //Logging out ends only the session it was sent with
+    EXPECT_EQ(exchange({"POST /login HTTP/1.1\r\n", "{\"DISCONNECTED\":true}", 301, true}), 301);
+    EXPECT_EQ(exchange({"GET /metrics HTTP/1.1\r\n", nullptr, 401, true}), 401);
+    session = first;
+    EXPECT_EQ(exchange({"GET /metrics HTTP/1.1\r\n", nullptr, 200, true}), 200);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,89 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <NtpClient.h>
+#include <SntpServer.h>
+
+#define TRUE_OFFSET 100000000LL //us the server is ahead of us
+#define LATENCY 5000 //us each way
+
+static const IPAddress station(10, 0, 0, 7);
+static const IPAddress responder(10, 0, 0, 123);
+
+/*
+ * Asks a local responder that answers at once, the only delay left
+ * is the one the test puts on the network or on the loop.
+ */
+class NtpClientTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(1000000000ULL);
+        Host::setLatency(LATENCY);
+        clock.begin(1600000000UL);
+        serverClock.begin(1600000000UL + TRUE_OFFSET / 1000000);
+
+        Host::setNode(responder);
+        ASSERT_TRUE(server.begin());
+        server.setReference(1, IPAddress(127, 127, 1, 0), 0, 0, 0, 0);
+        Host::setNode(station);
+        ASSERT_TRUE(client.begin(2390));
+    }
+
+    void TearDown() override{
+        client.stop();
+        server.stop();
+    }
+
+    //Steps in 1 ms like a loop that returns quickly
+    void run(uint32_t ms){
+        for(uint32_t i = 0; i < ms; i++){
+            Host::advance(1000);
+            Host::runSystem();
+        }
+    }
+
+    SoftClock clock;
+    SoftClock serverClock;
+    NtpClient client{clock};
+    SntpServer server{serverClock};
+};
+
+TEST_F(NtpClientTest, QuickLoopMeasuresTheNetwork){
+    ASSERT_TRUE(client.send(responder));
+    run(20);
+    ASSERT_TRUE(client.hasReply());
+    const Ntp_Reply &reply = client.getReply();
+    EXPECT_NEAR((double)reply.delay, 2.0 * LATENCY, 100.0);
+    EXPECT_NEAR((double)reply.offset, (double)TRUE_OFFSET, 100.0);
+}
+
+/*
+ * Reply comes in while a long loop pass holds the SDK, its receive
+ * callback runs when the pass is over. The wait counts as delay on the
+ * way back, the offset is off by half of it and stays inside delay / 2.
+ */
+TEST_F(NtpClientTest, HeldLoopStaysWithinHalfTheDelay){
+    for(uint32_t held : {20U, 100U, 300U, 1000U}){
+        ASSERT_TRUE(client.send(responder));
+        //Request gets out and answered, the reply is queued
+        run(LATENCY / 1000);
+        EXPECT_FALSE(client.hasReply());
+        Host::advance(held * 1000ULL);
+        EXPECT_FALSE(client.hasReply());
+        Host::runSystem();
+        ASSERT_TRUE(client.hasReply());
+
+        const Ntp_Reply &reply = client.getReply();
+        int64_t error = reply.offset - TRUE_OFFSET;
+        EXPECT_GE(reply.delay, (int64_t)held * 1000) << held << " ms";
+        EXPECT_LE(llabs(error), reply.delay / 2 + 100) << held << " ms";
+        //Not hidden either, the late timestamp shows in the offset
+        EXPECT_GE(llabs(error), (int64_t)held * 1000 / 2 - LATENCY) << held << " ms";
+        run(1000);
+    }
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
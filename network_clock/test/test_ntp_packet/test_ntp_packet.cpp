@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <NtpPacket.h>
+
+#define SECOND (1ULL << 32)
+
+static const uint64_t sent = 3900000000ULL * SECOND;
+
+/*
+ * A server's reply to the request we sent at sent.
+ */
+static void makeReply(uint8_t *buffer, uint64_t serverReceived, uint64_t serverSent){
+    memset(buffer, 0, NTP_PACKET_SIZE);
+    buffer[0] = 0b00100100; //No warning, version 4, server
+    buffer[1] = 2;
+    buffer[7] = 0x80; //Root delay 0.5 ms
+    buffer[11] = 0x40;
+    NtpPacket::writeStamp(buffer + 24, sent);
+    NtpPacket::writeStamp(buffer + 32, serverReceived);
+    NtpPacket::writeStamp(buffer + 40, serverSent);
+}
+
+TEST(NtpPacket, RequestCarriesTransmitTime){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    memset(buffer, 0xAA, sizeof(buffer));
+    NtpPacket::buildRequest(buffer, sent + 12345);
+    EXPECT_EQ(buffer[0] & 0x07, 3); //Client
+    EXPECT_EQ((buffer[0] >> 3) & 0x07, 4);
+    EXPECT_EQ(NtpPacket::readStamp(buffer + 24), 0ULL);
+    EXPECT_EQ(NtpPacket::readStamp(buffer + 40), sent + 12345);
+}
+
+TEST(NtpPacket, OffsetAndDelay){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    //We are 1 s behind, 10 ms each way, server holds it 2 ms
+    uint64_t serverReceived = sent + SECOND + SECOND / 100;
+    uint64_t serverSent = serverReceived + SECOND / 500;
+    uint64_t received = serverSent - SECOND + SECOND / 100;
+    makeReply(buffer, serverReceived, serverSent);
+
+    Ntp_Reply reply;
+    ASSERT_TRUE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, received, reply));
+    EXPECT_NEAR(reply.offset, 1000000, 2);
+    EXPECT_NEAR(reply.delay, 20000, 2);
+    EXPECT_EQ(reply.stratum, 2);
+    EXPECT_EQ(reply.rootDelay, 0x80U);
+    EXPECT_EQ(reply.rootDispersion, 0x40U);
+}
+
+TEST(NtpPacket, RejectsKissOfDeath){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    buffer[1] = 0;
+    Ntp_Reply reply;
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+}
+
+TEST(NtpPacket, RejectsUnsynchronisedServer){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    buffer[0] |= NTP_LEAP_ALARM << 6;
+    Ntp_Reply reply;
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+
+    //A leap second warning is still a good reply
+    buffer[0] = (buffer[0] & 0x3F) | 1 << 6;
+    EXPECT_TRUE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+}
+
+TEST(NtpPacket, RejectsOtherReplies){
+    uint8_t buffer[NTP_PACKET_SIZE];
+    Ntp_Reply reply;
+
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    buffer[0] = (buffer[0] & 0xF8) | 3; //Client mode
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent + 1, sent, sent + SECOND / 50, reply));
+
+    makeReply(buffer, sent + SECOND, 0);
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    buffer[1] = 16;
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, sizeof(buffer), sent, sent, sent + SECOND / 50, reply));
+
+    makeReply(buffer, sent + SECOND, sent + SECOND);
+    EXPECT_FALSE(NtpPacket::parseReply(buffer, NTP_PACKET_SIZE - 1, sent, sent, sent + SECOND / 50, reply));
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
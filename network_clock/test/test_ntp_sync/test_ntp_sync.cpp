@@ -0,0 +1,159 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <SoftClock.h>
+#include <SntpServer.h>
+#include <NtpClient.h>
+#include <Resolver.h>
+#include <ConnectionManager.h>
+#include <Protothread.h>
+
+//Firmware globals, main.h can't be included twice
+extern SoftClock softClock;
+extern NtpClient ntpClient;
+extern ConnectionManager connection;
+extern TaskRunner tasks;
+extern const char *ntpServerName;
+uint8_t getClock(Protothread *pt);
+
+#define UPSTREAM_TIME 1600000000UL
+
+static const IPAddress station(10, 0, 0, 7);
+static const IPAddress upstreamAddress(10, 0, 0, 123);
+
+static char ssid[33] = "home";
+static char psk[65] = "secret";
+
+/*
+ * Runs the sync task against a local SNTP server, all under virtual time.
+ * The task only ever sees the time the runner hands it.
+ */
+class NtpSyncTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(1000000000ULL);
+        Host::addNetwork(ssid, psk, station, -60);
+        Host::addHost("time.nist.gov", upstreamAddress);
+        Host::setDnsDelay(300000);
+        Host::setLatency(5000);
+        ntpServerName = "time.nist.gov";
+
+        upstreamClock.begin(UPSTREAM_TIME);
+        Host::setNode(upstreamAddress);
+        ASSERT_TRUE(upstream.begin());
+        upstream.setReference(1, IPAddress(127, 127, 1, 0), 0, 0, 0, 0);
+        Host::setNode(IPAddress());
+
+        softClock.begin(0);
+        ASSERT_TRUE(ntpClient.begin(2390));
+        tasks.stop(getClock);
+        connection.begin(ssid, psk, "clock");
+        //Drops what an earlier test joined, nothing reconnects until connect()
+        connection.startAccessPoint();
+    }
+
+    void TearDown() override{
+        upstream.stop();
+        ntpClient.stop();
+        tasks.stop(getClock);
+    }
+
+    //Steps like loop() does, SDK work happens between the steps
+    void run(uint32_t ms){
+        for(uint32_t i = 0; i < ms; i += 10){
+            Host::advance(10000);
+            Host::runSystem();
+            connection.tick();
+            tasks.tick(millis());
+        }
+    }
+
+    //ms until the clock is synced, or past limit
+    uint32_t runUntilSynced(uint32_t limit){
+        uint32_t ms = 0;
+        while(!softClock.isSynced() && ms <= limit){
+            run(10);
+            ms += 10;
+        }
+        return ms;
+    }
+
+    SoftClock upstreamClock;
+    SntpServer upstream{upstreamClock};
+};
+
+TEST_F(NtpSyncTest, LookupDoesNotHoldTheTask){
+    connection.connect();
+    run(1000);
+    ASSERT_EQ(connection.getState(), STATE_CONNECTED);
+
+    ASSERT_TRUE(tasks.start(getClock));
+    //Name takes 300 ms, every tick in between returns
+    run(200);
+    EXPECT_TRUE(tasks.isRunning(getClock));
+    EXPECT_FALSE(softClock.isSynced());
+
+    uint32_t ms = runUntilSynced(1000);
+    EXPECT_LE(ms, 200U);
+    EXPECT_FALSE(tasks.isRunning(getClock));
+    EXPECT_NEAR((double)softClock.now(), (double)(UPSTREAM_TIME + 1), 1.0);
+    EXPECT_EQ(ntpClient.getServer(), (uint32_t)upstreamAddress);
+}
+
+TEST_F(NtpSyncTest, WaitsForTheConnection){
+    ASSERT_TRUE(tasks.start(getClock));
+    run(30000);
+    EXPECT_TRUE(tasks.isRunning(getClock));
+    EXPECT_FALSE(softClock.isSynced());
+    EXPECT_EQ(Host::getDropped(), 0U);
+
+    //Same task picks up once connected, nothing starts it again
+    connection.connect();
+    EXPECT_LE(runUntilSynced(3000), 2000U);
+    EXPECT_FALSE(tasks.isRunning(getClock));
+}
+
+TEST_F(NtpSyncTest, SlowLookupIsNotStartedTwice){
+    Host::setDnsDelay((DNS_TIMEOUT + 3000) * 1000ULL);
+    connection.connect();
+    run(1000);
+    ASSERT_TRUE(tasks.start(getClock));
+
+    //The one lookup in flight is waited out past the timeout
+    uint32_t ms = runUntilSynced(DNS_TIMEOUT * 3);
+    EXPECT_GE(ms, DNS_TIMEOUT + 3000U);
+    EXPECT_LE(ms, DNS_TIMEOUT + 3100U);
+}
+
+TEST_F(NtpSyncTest, UnknownNameIsRetried){
+    ntpServerName = "pool.invalid";
+    connection.connect();
+    run(1000);
+    ASSERT_TRUE(tasks.start(getClock));
+    run(DNS_TIMEOUT * 2);
+    EXPECT_TRUE(tasks.isRunning(getClock));
+    EXPECT_FALSE(softClock.isSynced());
+
+    Host::addHost("pool.invalid", upstreamAddress);
+    EXPECT_LE(runUntilSynced(DNS_TIMEOUT * 2), (uint32_t)DNS_TIMEOUT + 500);
+}
+
+TEST_F(NtpSyncTest, SilentServerIsAskedAgain){
+    connection.connect();
+    run(1000);
+    upstream.stop();
+    ASSERT_TRUE(tasks.start(getClock));
+    run(NTP_TIMEOUT * 3);
+    EXPECT_TRUE(tasks.isRunning(getClock));
+    EXPECT_GE(Host::getDropped(), 2U);
+
+    Host::setNode(upstreamAddress);
+    ASSERT_TRUE(upstream.begin());
+    Host::setNode(IPAddress());
+    EXPECT_LE(runUntilSynced(NTP_TIMEOUT * 2), (uint32_t)NTP_TIMEOUT + 100);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
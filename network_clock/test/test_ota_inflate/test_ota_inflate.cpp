@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <MD5Builder.h>
+#include <ESP8266WebServer.h>
+#include <OtaUpdater.h>
+#include <zlib.h>
+#include <random>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+/*
+ * Firmware-like image, runs of code-ish bytes, zero padding and noise,
+ * so deflate picks all block types over it.
+ */
+static Bytes makeImage(size_t size, uint32_t seed){
+    std::mt19937 random(seed);
+    Bytes image;
+    while(image.size() < size){
+        switch (random() % 3)
+        {
+        case 0:
+            for(uint32_t i = random() % 4096; i > 0; i--){
+                image.push_back(random());
+            }
+            break;
+        case 1:
+            image.insert(image.end(), random() % 2048, 0xFF);
+            break;
+        default:
+            for(uint32_t i = random() % 8192; i > 0; i--){
+                image.push_back("\x12\xc1\xf0\x09\x21\x66\x4e\x0c"[i % 8] ^ (i / 512));
+            }
+        }
+    }
+    image.resize(size);
+    return image;
+}
+
+/*
+ * gzip of data with zlib, with a name, comment and header CRC so every
+ * optional header field is read too.
+ */
+static Bytes gzip(const Bytes &data, int level, int strategy = Z_DEFAULT_STRATEGY, bool fields = true){
+    z_stream stream = {};
+    EXPECT_EQ(deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 9, strategy), Z_OK);
+    gz_header header = {};
+    char name[] = "firmware.bin";
+    char comment[] = "built on the host";
+    if(fields){
+        header.name = (Bytef*)name;
+        header.comment = (Bytef*)comment;
+        header.hcrc = 1;
+        deflateSetHeader(&stream, &header);
+    }
+    Bytes out(deflateBound(&stream, data.size()) + 128);
+    stream.next_in = (Bytef*)data.data();
+    stream.avail_in = data.size();
+    stream.next_out = out.data();
+    stream.avail_out = out.size();
+    EXPECT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+static String md5(const Bytes &data){
+    MD5Builder builder;
+    builder.begin();
+    builder.add(data.data(), data.size());
+    builder.calculate();
+    return builder.toString();
+}
+
+class OtaInflateTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setSketchSpace(0x100000);
+    }
+
+    //Uploads like the web server hands it over, in pieces of up to 2K
+    bool upload(const Bytes &data, OtaTarget target, const char *digest, uint32_t seed = 1){
+        std::mt19937 random(seed);
+        if(!ota.begin(target, digest)){
+            return false;
+        }
+        for(size_t sent = 0; sent < data.size();){
+            size_t length = std::min<size_t>(data.size() - sent, 1 + random() % HTTP_UPLOAD_BUFLEN);
+            if(!ota.write(data.data() + sent, length)){
+                return false;
+            }
+            sent += length;
+        }
+        return ota.end();
+    }
+
+    OtaUpdater ota;
+};
+
+TEST_F(OtaInflateTest, RoundTripsAtEveryLevel){
+    Bytes image = makeImage(300000, 7);
+    for(int level : {0, 1, 6, 9}){
+        Bytes compressed = gzip(image, level);
+        ASSERT_TRUE(upload(compressed, OTA_FIRMWARE, md5(image).c_str(), level)) << "level " << level << " " << ota.getError();
+        EXPECT_TRUE(Host::getUpdateImage() == image) << "level " << level;
+        EXPECT_EQ(ota.getReceived(), compressed.size());
+        EXPECT_EQ(ota.getWritten(), image.size());
+    }
+}
+
+TEST_F(OtaInflateTest, RoundTripsFixedCodesAndPlainHeader){
+    Bytes image = makeImage(100000, 11);
+    ASSERT_TRUE(upload(gzip(image, 6, Z_FIXED, false), OTA_FIRMWARE, md5(image).c_str())) << ota.getError();
+    EXPECT_TRUE(Host::getUpdateImage() == image);
+}
+
+TEST_F(OtaInflateTest, ChunkBoundariesDontMatter){
+    Bytes image = makeImage(120000, 3);
+    Bytes compressed = gzip(image, 9);
+    for(uint32_t seed = 1; seed <= 20; seed++){
+        ASSERT_TRUE(upload(compressed, OTA_FIRMWARE, "", seed)) << "seed " << seed << " " << ota.getError();
+        ASSERT_TRUE(Host::getUpdateImage() == image) << "seed " << seed;
+    }
+}
+
+TEST_F(OtaInflateTest, FilesystemImage){
+    Bytes image = makeImage(200000, 5);
+    ASSERT_TRUE(upload(gzip(image, 6), OTA_FILESYSTEM, md5(image).c_str())) << ota.getError();
+    EXPECT_TRUE(Host::getUpdateImage() == image);
+}
+
+TEST_F(OtaInflateTest, PlainImagePassesThrough){
+    Bytes image = makeImage(50000, 9);
+    ASSERT_TRUE(upload(image, OTA_FIRMWARE, md5(image).c_str())) << ota.getError();
+    EXPECT_TRUE(Host::getUpdateImage() == image);
+    EXPECT_EQ(ota.getWritten(), image.size());
+}
+
+TEST_F(OtaInflateTest, BadImagesKeepTheOldOne){
+    Bytes good = makeImage(80000, 13);
+    ASSERT_TRUE(upload(gzip(good, 6), OTA_FIRMWARE, md5(good).c_str()));
+
+    Bytes image = makeImage(80000, 17);
+    Bytes compressed = gzip(image, 6);
+
+    Bytes corrupt = compressed;
+    corrupt[corrupt.size() / 2] ^= 0x55;
+    EXPECT_FALSE(upload(corrupt, OTA_FIRMWARE, ""));
+    EXPECT_STREQ(ota.getError(), "inflate");
+
+    Bytes truncated(compressed.begin(), compressed.end() - 100);
+    EXPECT_FALSE(upload(truncated, OTA_FIRMWARE, ""));
+    EXPECT_STREQ(ota.getError(), "inflate");
+
+    //Whether it comes with the trailer or after it, nothing may follow the stream
+    for(size_t extra : {16, 4096}){
+        Bytes trailing = compressed;
+        trailing.insert(trailing.end(), extra, 0);
+        EXPECT_FALSE(upload(trailing, OTA_FIRMWARE, "")) << extra << " bytes";
+        EXPECT_NE(ota.getError(), nullptr);
+    }
+
+    EXPECT_FALSE(upload(compressed, OTA_FIRMWARE, md5(good).c_str()));
+    EXPECT_STREQ(ota.getError(), "verify");
+
+    EXPECT_TRUE(Host::getUpdateImage() == good);
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <SessionStore.h>
+#include <string>
+
+static std::string cookie(const char *token){
+    return std::string("theme=dark; " SESSION_COOKIE) + token + "; lang=en";
+}
+
+TEST(SessionStoreTest, IssuedTokenIsAccepted){
+    SessionStore store;
+    std::string token = store.create();
+    EXPECT_EQ(token.size(), (size_t)SESSION_TOKEN_SIZE);
+    EXPECT_TRUE(store.check(cookie(token.c_str()).c_str()));
+    EXPECT_TRUE(store.check((SESSION_COOKIE + token).c_str()));
+}
+
+TEST(SessionStoreTest, GuessedTokensAreRejected){
+    SessionStore store;
+    //Nothing issued yet, not even an empty or all zero token gets in
+    EXPECT_FALSE(store.check(SESSION_COOKIE));
+    EXPECT_FALSE(store.check(cookie("00000000000000000000000000000000").c_str()));
+
+    std::string token = store.create();
+    EXPECT_FALSE(store.check(SESSION_COOKIE "1"));
+    EXPECT_FALSE(store.check(cookie(token.substr(0, SESSION_TOKEN_SIZE - 1).c_str()).c_str()));
+    EXPECT_FALSE(store.check(cookie((token + "0").c_str()).c_str()));
+    token[SESSION_TOKEN_SIZE - 1] ^= 1;
+    EXPECT_FALSE(store.check(cookie(token.c_str()).c_str()));
+    EXPECT_FALSE(store.check("theme=dark"));
+}
+
+TEST(SessionStoreTest, OldestSessionMakesRoom){
+    SessionStore store;
+    std::string tokens[SESSION_MAX + 1];
+    for(uint8_t i = 0; i <= SESSION_MAX; i++){
+        tokens[i] = store.create();
+    }
+    EXPECT_FALSE(store.check(cookie(tokens[0].c_str()).c_str()));
+    for(uint8_t i = 1; i <= SESSION_MAX; i++){
+        EXPECT_TRUE(store.check(cookie(tokens[i].c_str()).c_str()));
+    }
+}
+
+TEST(SessionStoreTest, RevokeEndsOneSession){
+    SessionStore store;
+    std::string first = store.create();
+    std::string second = store.create();
+    store.revoke(cookie(first.c_str()).c_str());
+    EXPECT_FALSE(store.check(cookie(first.c_str()).c_str()));
+    EXPECT_TRUE(store.check(cookie(second.c_str()).c_str()));
+
+    store.clear();
+    EXPECT_FALSE(store.check(cookie(second.c_str()).c_str()));
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
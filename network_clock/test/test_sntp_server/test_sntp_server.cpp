@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <NtpPacket.h>
+#include <SntpServer.h>
+#include <map>
+
+static const IPAddress serverAddress(192, 168, 1, 10);
+static const IPAddress upstream(162, 159, 200, 1);
+
+/*
+ * Counts the replies each client address got back.
+ */
+static std::map<uint32_t, uint32_t> answered;
+static uint8_t lastReply[SNTP_PACKET_SIZE];
+
+static void onReply(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, uint16_t port){
+    answered[(uint32_t)(uintptr_t)arg]++;
+    pbuf_copy_partial(p, lastReply, sizeof(lastReply), 0);
+    pbuf_free(p);
+}
+
+class SntpServerTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(1000000000ULL);
+        answered.clear();
+        clock.begin(1600000000UL);
+        Host::setNode(serverAddress);
+        ASSERT_TRUE(server.begin());
+    }
+
+    void TearDown() override{
+        server.stop();
+        for(auto &client : clients){
+            udp_remove(client.second);
+        }
+    }
+
+    //Sends one request from address, the client socket is made on first use
+    void request(IPAddress address){
+        if(clients.count(address) == 0){
+            Host::setNode(address);
+            udp_pcb *pcb = udp_new();
+            udp_bind(pcb, IP_ADDR_ANY, 50123);
+            udp_recv(pcb, onReply, (void*)(uintptr_t)(uint32_t)address);
+            clients[address] = pcb;
+        }
+        uint8_t packet[SNTP_PACKET_SIZE];
+        NtpPacket::buildRequest(packet, clock.nowNtp());
+        Host::sendUdp(address, 50123, serverAddress, SNTP_PORT, packet, sizeof(packet));
+    }
+
+    SoftClock clock;
+    SntpServer server{clock};
+    std::map<uint32_t, udp_pcb*> clients;
+};
+
+TEST_F(SntpServerTest, SilentBeforeFirstSync){
+    request(IPAddress(192, 168, 1, 20));
+    Host::runSystem();
+    EXPECT_EQ(server.getRequests(), 1U);
+    EXPECT_EQ(server.getReplies(), 0U);
+}
+
+TEST_F(SntpServerTest, AddsOwnDelayAndErrorToRoot){
+    //Upstream 10 ms root delay, 5 ms dispersion, our round trip 20 ms
+    server.setReference(2, upstream, 655, 327, 20000, 10000);
+    request(IPAddress(192, 168, 1, 20));
+    Host::runSystem();
+    ASSERT_EQ(server.getReplies(), 1U);
+
+    EXPECT_EQ(lastReply[0] & 0x07, NTP_MODE_SERVER);
+    EXPECT_EQ(lastReply[1], 3);
+    EXPECT_EQ((int8_t)lastReply[3], SNTP_PRECISION);
+    //20 ms is 1310.72 units, 10 ms another 655.36, both rounded up
+    EXPECT_EQ(NtpPacket::readWord(lastReply + 4), 655U + 1311U);
+    EXPECT_EQ(NtpPacket::readWord(lastReply + 8), 327U + 656U + SNTP_PRECISION_SHORT);
+
+    //Dispersion keeps growing from there while the clock runs free
+    Host::advance(1000000000ULL);
+    server.sample();
+    request(IPAddress(192, 168, 1, 20));
+    Host::runSystem();
+    EXPECT_EQ(NtpPacket::readWord(lastReply + 8), 327U + 656U + SNTP_PRECISION_SHORT + 983U);
+}
+
+TEST_F(SntpServerTest, LimitsBurstsPerClient){
+    server.setReference(2, upstream, 0, 0, 0, 0);
+    for(int i = 0; i < RATE_BURST * 4; i++){
+        request(IPAddress(192, 168, 1, 20));
+    }
+    Host::runSystem();
+    EXPECT_EQ(server.getReplies(), (uint32_t)RATE_BURST);
+    EXPECT_EQ(server.getLimited(), (uint32_t)RATE_BURST * 3);
+
+    Host::advance(RATE_REFILL * 1000ULL);
+    request(IPAddress(192, 168, 1, 20));
+    Host::runSystem();
+    EXPECT_EQ(server.getReplies(), (uint32_t)RATE_BURST + 1);
+}
+
+/*
+ * Regular clients poll once a second while thousands of new addresses
+ * flood the server. The flood shares one bucket, so it can't take the
+ * regular clients' slots and gets no more than one client's rate.
+ */
+TEST_F(SntpServerTest, FloodOfNewClientsDoesNotEvictKnownOnes){
+    server.setReference(2, upstream, 0, 0, 0, 0);
+    const int regular = RATE_CLIENTS - 1;
+    const int seconds = 30;
+    uint32_t flooded = 0;
+
+    for(int second = 0; second < seconds; second++){
+        for(int i = 0; i < regular; i++){
+            request(IPAddress(192, 168, 1, 100 + i));
+        }
+        Host::runSystem();
+        for(int burst = 0; burst < 10; burst++){
+            for(int i = 0; i < 100; i++){
+                request(IPAddress(10, (uint8_t)(flooded >> 16), (uint8_t)(flooded >> 8), (uint8_t)flooded));
+                flooded++;
+            }
+            Host::runSystem();
+            Host::advance(100000);
+        }
+    }
+
+    for(int i = 0; i < regular; i++){
+        EXPECT_EQ(answered[IPAddress(192, 168, 1, 100 + i)], (uint32_t)seconds) << "client " << i;
+    }
+    uint32_t floodReplies = server.getReplies() - regular * seconds;
+    //The shared bucket at its refill rate, and the one free slot each time it went idle
+    EXPECT_LE(floodReplies, (uint32_t)(RATE_BURST + seconds * 1000 / RATE_REFILL + seconds * 1000 / (RATE_BURST * RATE_REFILL) + 1));
+    EXPECT_GT(server.getLimited(), flooded - floodReplies - 1);
+}
+
+TEST_F(SntpServerTest, IdleSlotsGoToNewClients){
+    server.setReference(2, upstream, 0, 0, 0, 0);
+    for(int i = 0; i < RATE_CLIENTS; i++){
+        request(IPAddress(192, 168, 1, 100 + i));
+    }
+    Host::runSystem();
+
+    //Shared bucket is drained by strangers while the table is busy
+    for(int i = 0; i < RATE_BURST * 2; i++){
+        request(IPAddress(10, 0, 0, 1 + i));
+    }
+    Host::runSystem();
+    EXPECT_EQ(server.getLimited(), (uint32_t)RATE_BURST);
+
+    //Once the known clients went quiet for a full refill their slots are reused
+    Host::advance(RATE_BURST * RATE_REFILL * 1000ULL);
+    uint32_t replies = server.getReplies();
+    for(int i = 0; i < RATE_CLIENTS; i++){
+        for(int j = 0; j < RATE_BURST; j++){
+            request(IPAddress(10, 0, 1, 1 + i));
+        }
+    }
+    Host::runSystem();
+    EXPECT_EQ(server.getReplies() - replies, (uint32_t)(RATE_CLIENTS * RATE_BURST));
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
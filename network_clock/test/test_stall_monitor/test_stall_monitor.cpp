@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <StallMonitor.h>
+
+class StallMonitorTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        Host::reset();
+        Host::setTime(0);
+        monitor.begin();
+        monitor.reset();
+    }
+
+    StallMonitor monitor;
+};
+
+TEST_F(StallMonitorTest, InnerPhaseDoesNotClobberOuter){
+    //Upload runs tasks inside the http phase
+    monitor.enter(STALL_HTTP);
+    Host::advance(250000);
+    monitor.enter(STALL_TASK, 0x1234, 100);
+    Host::advance(20000);
+    monitor.leave();
+    EXPECT_EQ(monitor.getOverruns(), 0u);
+    EXPECT_EQ(monitor.getMaxElapsed(STALL_TASK), 20u);
+
+    Host::advance(100000);
+    monitor.leave();
+    EXPECT_EQ(monitor.getMaxElapsed(STALL_HTTP), 370u);
+    EXPECT_EQ(monitor.getOverruns(), 1u);
+    EXPECT_EQ(monitor.getCount(STALL_HTTP), 1u);
+    EXPECT_EQ(monitor.getCount(STALL_TASK), 0u);
+    EXPECT_EQ(monitor.getLast().phase, (uint32_t)STALL_HTTP);
+}
+
+TEST_F(StallMonitorTest, TimerSamplesInnermostPhase){
+    monitor.enter(STALL_HTTP);
+    monitor.enter(STALL_TASKS, 0, 10);
+    Host::advance(15000);
+    Host::fireTimer();
+    EXPECT_EQ(monitor.getLast().phase, (uint32_t)STALL_TASKS);
+    EXPECT_EQ(monitor.getLast().elapsed, STALL_UNFINISHED);
+    EXPECT_EQ(monitor.getLast().samples, 1u);
+}
+
+TEST_F(StallMonitorTest, DeepNestingBalances){
+    for(int i = 0; i < STALL_DEPTH + 2; i++){
+        monitor.enter(STALL_LOG);
+    }
+    for(int i = 0; i < STALL_DEPTH + 2; i++){
+        monitor.leave();
+    }
+    //Unmatched leave is ignored
+    monitor.leave();
+    Host::advance(1000000);
+    monitor.enter(STALL_MDNS);
+    monitor.leave();
+    EXPECT_EQ(monitor.getOverruns(), 0u);
+}
+
+#if STALL_ASSERT
+TEST_F(StallMonitorTest, OnlyTasksAssert){
+    monitor.enter(STALL_HTTP);
+    Host::advance(1000000);
+    monitor.leave();
+    EXPECT_EQ(monitor.getOverruns(), 1u);
+    monitor.enter(STALL_TASK);
+    Host::advance(1000000);
+    EXPECT_DEATH(monitor.leave(), "");
+}
+#endif
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <gtest/gtest.h>
+#include <TaskList.h>
+#include <vector>
+
+class TaskListTest : public ::testing::Test{
+protected:
+    void SetUp() override{
+        for(Node &node : nodes){
+            list.append(&node);
+        }
+    }
+
+    //Nodes left in the list, in order, walked the way runInterrupts() does
+    std::vector<Node*> walk(){
+        std::vector<Node*> seen;
+        list.reset();
+        while(list.advance()){
+            seen.push_back(list.getCurrent());
+        }
+        return seen;
+    }
+
+    Node nodes[4];
+    List list;
+};
+
+TEST_F(TaskListTest, WalksInOrder){
+    EXPECT_EQ(walk(), (std::vector<Node*>{&nodes[0], &nodes[1], &nodes[2], &nodes[3]}));
+    EXPECT_EQ(list.length, 4);
+}
+
+TEST_F(TaskListTest, RemovesAnyNode){
+    EXPECT_TRUE(list.remove(&nodes[1]));
+    EXPECT_EQ(walk(), (std::vector<Node*>{&nodes[0], &nodes[2], &nodes[3]}));
+    EXPECT_TRUE(list.remove(&nodes[3]));
+    EXPECT_EQ(list.tail, &nodes[2]);
+    EXPECT_TRUE(list.remove(&nodes[0]));
+    EXPECT_EQ(walk(), (std::vector<Node*>{&nodes[2]}));
+    EXPECT_FALSE(list.remove(&nodes[0]));
+    EXPECT_TRUE(list.remove(&nodes[2]));
+    EXPECT_EQ(list.head, nullptr);
+    EXPECT_EQ(list.tail, nullptr);
+    EXPECT_EQ(list.length, 0);
+
+    //Emptied list takes new nodes
+    list.append(&nodes[3]);
+    EXPECT_EQ(walk(), (std::vector<Node*>{&nodes[3]}));
+}
+
+TEST_F(TaskListTest, RemovingCurrentKeepsTheWalk){
+    //One shot tasks finish wherever they are, the rest still run this pass
+    std::vector<Node*> seen;
+    list.reset();
+    while(list.advance()){
+        Node *current = list.getCurrent();
+        seen.push_back(current);
+        if(current != &nodes[2]){
+            list.remove(current);
+        }
+    }
+    EXPECT_EQ(seen, (std::vector<Node*>{&nodes[0], &nodes[1], &nodes[2], &nodes[3]}));
+    EXPECT_EQ(walk(), (std::vector<Node*>{&nodes[2]}));
+}
+
+int main(int argc, char **argv){
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}